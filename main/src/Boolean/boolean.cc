@@ -15,17 +15,29 @@ namespace Boolean {
 
 namespace {
 
+// The elements are extracted again only if the body has changed since
+// the last time (see EE<Type::BODY>::generation()).
 template <Topo::Type typeT>
 struct ItearatorCache
 {
   Topo::Iterator<Topo::Type::BODY, typeT> ents_;
+  size_t generation_ = SIZE_MAX;
   Topo::Iterator<Topo::Type::BODY, typeT>& get(Topo::Wrap<Topo::Type::BODY>& _body)
   {
-    if (ents_.size() == 0)
+    auto generation =
+      static_cast<const Topo::EE<Topo::Type::BODY>*>(_body.get())->generation();
+    if (generation != generation_)
+    {
       ents_.reset(_body);
+      generation_ = generation;
+    }
     return ents_;
   }
-  void clear() { ents_.clear(); }
+  void clear()
+  {
+    ents_.clear();
+    generation_ = SIZE_MAX;
+  }
 };
 
 struct BodyInfo : public 
@@ -35,6 +47,7 @@ struct BodyInfo : public
 {
   void init(Topo::Wrap<Topo::Type::BODY> _body)
   {
+    clear();
     body_ = _body;
   }
 
@@ -83,8 +96,6 @@ Topo::Wrap<Topo::Type::BODY> Solver::compute(const Operation _op)
 #endif
     size_t max_iter = 10;
     while (remove_degeneracies(bodies_[0].body_, bodies_[1].body_) && --max_iter > 0);
-    bodies_[0].clear();
-    bodies_[1].clear();
 #ifdef DEB_ON
     static int n = 0;
     std::string str = "debug_";
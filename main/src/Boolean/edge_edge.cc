@@ -96,12 +96,23 @@ void merge_intersections(std::vector<EdgeEdgeSplintInfo>& _splt_inf)
     std::get<0>(ball_pts[k]).push_back(_splt_inf[i].pt_);
     std::get<double>(ball_pts[k]) = std::max(std::get<double>(ball_pts[k]), _splt_inf[i].tol_);
   }
+  std::vector<Geo::Point> pts;
+  std::vector<size_t> offsets(1, 0), clusters;
   for (size_t i = 0; i < _splt_inf.size(); ++i)
   {
-    const auto& pts = std::get<0>(ball_pts[i]);
-    if (pts.empty())
+    const auto& cluster_pts = std::get<0>(ball_pts[i]);
+    if (cluster_pts.empty())
       continue;
-    auto best_sphere = Geo::min_ball(pts.data(), pts.size());
+    pts.insert(pts.end(), cluster_pts.begin(), cluster_pts.end());
+    offsets.push_back(pts.size());
+    clusters.push_back(i);
+  }
+  std::vector<Geo::MinSphereT<Geo::Point>> spheres(clusters.size());
+  Geo::min_balls(pts.data(), offsets.data(), clusters.size(), spheres.data());
+  for (size_t j = 0; j < clusters.size(); ++j)
+  {
+    const auto i = clusters[j];
+    const auto& best_sphere = spheres[j];
     double tol = best_sphere.radius_ + std::get<double>(ball_pts[i]);
     (*_splt_inf[i].vert_)->set_geom(best_sphere.centre_);
     (*_splt_inf[i].vert_)->set_tolerance(tol);
@@ -265,9 +276,7 @@ bool EdgeVersusEdges::split()
       it->add_point(ed_split_info);
     }
   }
-  for (auto split_op : ed_splt_set)
-    split_op();
-  return true;
+  return Topo::split_edges(ed_splt_set);
 }
 
 
@@ -78,9 +78,7 @@ bool EdgesVersusVertices::intersect(
 
 bool EdgesVersusVertices::split()
 {
-  for (auto split_op : ed_splt_set_)
-    split_op();
-  return true;
+  return Topo::split_edges(ed_splt_set_);
 }
 
 
@@ -11,6 +11,7 @@
 #include "Topology/impl.hh"
 #include "Topology/shared.hh"
 #include "Topology/split.hh"
+#include "Topology/view.hh"
 #include <Topology/split_chain.hh>
 #include "Utils/error_handling.hh"
 #include "Utils/circular.hh"
@@ -32,8 +33,8 @@ static std::set<Topo::Wrap<Topo::Type::VERTEX>> face_vertices(
 {
   std::set<Topo::Wrap<Topo::Type::VERTEX>> vert_set;
   vert_set.insert(_verts.begin(), _verts.end());
-  Topo::Iterator<Topo::Type::FACE, Topo::Type::VERTEX> fv_it(_face_a);
-  vert_set.insert(fv_it.begin(), fv_it.end());
+  for (auto vert : Topo::view<Topo::Type::VERTEX>(_face_a))
+    vert_set.emplace(vert);
   return vert_set;
 }
 
@@ -130,7 +131,7 @@ struct FaceEdgeMap
 
     if (elem.second) // It is a new face
     {
-      Topo::Iterator<Topo::Type::FACE, Topo::Type::VERTEX> fv_it(_face);
+      auto fv_it = Topo::view<Topo::Type::VERTEX>(_face);
       auto pl_fit = Geo::IPlaneFit::make();
       pl_fit->init(fv_it.size());
       std::vector<Geo::Point> face_pts;
@@ -212,16 +213,11 @@ bool FaceVersus::face_intersect(
         add_a = add_b = true;
       if (!add_a && !add_b)
       {
-        auto face_normal = [](const Topo::Wrap<Topo::Type::FACE>& _face)
-        {
-          Topo::Iterator<Topo::Type::FACE, Topo::Type::LOOP> l_it(_face);
-          Topo::Iterator<Topo::Type::LOOP, Topo::Type::VERTEX> v_it(*l_it.begin());
-          return Geo::vertex_polygon_normal(v_it.begin(), v_it.end());
-        };
-        auto cos_ang = face_normal(face_a) * face_normal(face_b);
+        auto cos_ang =
+          Topo::face_plane_normal(face_a) * Topo::face_plane_normal(face_b);
         if (fabs(cos_ang) > 0.7)
         {
-          bool same_dir = (face_normal(face_a) * face_normal(face_b)) > 0;
+          bool same_dir = cos_ang > 0;
           add_a = same_dir == same_sense;
         }
         add_b = add_a;
@@ -420,10 +416,9 @@ static void split_face(
   std::sort(edge_vec.begin(), edge_vec.end());
   for (auto f : newfaces)
   {
-    Topo::Iterator<Topo::Type::FACE, Topo::Type::VERTEX> fe(f);
     Topo::VertexChain vc;
-    for (auto v : fe)
-      vc.push_back(v);
+    for (auto v : Topo::view<Topo::Type::VERTEX>(f))
+      vc.emplace_back(v);
     std::sort(vc.begin(), vc.end());
     auto where = 
       std::equal_range(edge_vec.begin(), edge_vec.end(), vc);
@@ -2,8 +2,9 @@
 #include "face_intersections.hh"
 #include "Geo/kdtree.hh"
 #include "Geo/pow.hh"
+#include "Topology/view.hh"
 
-#include <set>
+#include <algorithm>
 
 namespace Boolean {
 
@@ -26,11 +27,10 @@ bool FaceVersus::vertex_intersect(
   for (auto& couple : couples)
   {
     const auto& face = kdtree_f[couple[0]];
-    Topo::Iterator<Topo::Type::FACE, Topo::Type::VERTEX> fv_it(face);
-    std::set<Topo::Wrap<Topo::Type::VERTEX>> face_verts(fv_it.begin(), fv_it.end());
+    auto face_verts = Topo::view<Topo::Type::VERTEX>(face);
     auto& face_info = face_geom(face);
     const auto& vert = kdtree_v[couple[1]];
-    if (face_verts.find(vert) != face_verts.end())
+    if (std::find(face_verts.begin(), face_verts.end(), vert.get()) != face_verts.end())
       continue;
     Geo::Point pt, clsst_pt;
     double dist_sq;
@@ -11,6 +11,7 @@
 #include "Utils/enum.hh"
 
 #include <set>
+#include <unordered_map>
 
 namespace Boolean {
 
@@ -18,11 +19,28 @@ namespace {
 
 const int SAFE_TOL_MULTIPLE_SQ = 4;
 
+// The vertices of all the chains of short edges are merged at once,
+// then again if the moved vertices made new short edges.
 void remove_degenerate_edges(Topo::Wrap<Topo::Type::BODY>& _body)
 {
+  std::vector<Topo::Wrap<Topo::Type::VERTEX>> verts;
+  std::unordered_map<const Topo::IBase*, size_t> vert_inds;
   for (bool achange = true; achange; )
   {
-    achange = false;
+    verts.clear();
+    vert_inds.clear();
+    Utils::UnionFind classes;
+    auto index = [&verts, &vert_inds, &classes](
+      const Topo::Wrap<Topo::Type::VERTEX>& _vert)
+    {
+      auto pos = vert_inds.emplace(_vert.get(), verts.size());
+      if (pos.second)
+      {
+        verts.push_back(_vert);
+        classes.grow(verts.size());
+      }
+      return pos.first->second;
+    };
     Topo::Iterator<Topo::Type::BODY, Topo::Type::EDGE> it_ed(_body);
     for (auto edge : it_ed)
     {
@@ -36,9 +54,10 @@ void remove_degenerate_edges(Topo::Wrap<Topo::Type::BODY>& _body)
       auto len2 = Geo::length_square(seg[1] - seg[0]);
       if (len2 > SAFE_TOL_MULTIPLE_SQ * Geo::sq(tol))
         continue;
-      Topo::Iterator<Topo::Type::EDGE, Topo::Type::VERTEX> it_ve(edge);
-      achange |= Topo::merge(it_ve.get(0), it_ve.get(1));
+      // The second vertex is kept, as in Topo::merge(_a, _b).
+      classes.unite(index(vv.get(1)), index(vv.get(0)));
     }
+    achange = Topo::merge(verts, classes) > 0;
   }
 }
 
@@ -6,6 +6,7 @@
 #include "Utils/equivalence_relation.hh"
 #include "Utils/statistics.hh"
 
+#include <algorithm>
 #include <set>
 #include <vector>
 
@@ -37,27 +38,60 @@ bool vertices_versus_vertices(
       continue;
     equiv_set.add_relation(va, vb);
   }
-  std::vector<Topo::Wrap<Topo::Type::VERTEX>> mrg_set;
-  while (!(mrg_set = equiv_set.extract_equivalence_set()).empty())
+  // Collects all the sets to compute their min balls in one batch.
+  std::vector<std::vector<Topo::Wrap<Topo::Type::VERTEX>>> mrg_sets;
+  std::vector<Geo::Point> pt_to_mrg;
+  std::vector<size_t> offsets(1, 0);
+  for (;;)
   {
-    std::vector<Geo::Point> pt_to_mrg;
+    auto mrg_set = equiv_set.extract_equivalence_set();
+    if (mrg_set.empty())
+      break;
     for (const auto& vert : mrg_set)
     {
+      pt_to_mrg.emplace_back();
+      vert->geom(pt_to_mrg.back());
+    }
+    offsets.push_back(pt_to_mrg.size());
+    mrg_sets.push_back(std::move(mrg_set));
+  }
+  std::vector<Geo::MinSphereT<Geo::Point>> spheres(mrg_sets.size());
+  Geo::min_balls(pt_to_mrg.data(), offsets.data(), mrg_sets.size(), spheres.data());
+
+  for (size_t i = 0; i < mrg_sets.size(); ++i)
+  {
+    const auto& mrg_set = mrg_sets[i];
+    auto centre = spheres[i].centre_;
+    // If a vertex tolerance already covers the set, the merged vertex
+    // keeps its position.
+    for (const auto& vert : mrg_set)
+    {
+      if (vert->tolerance() < spheres[i].radius_)
+        continue;
       Geo::Point pt;
       vert->geom(pt);
-      pt_to_mrg.push_back(pt);
+      auto covers = [&pt, &vert](const auto& _other)
+      {
+        Geo::Point other_pt;
+        _other->geom(other_pt);
+        return Geo::length(other_pt - pt) <= vert->tolerance();
+      };
+      if (std::all_of(mrg_set.begin(), mrg_set.end(), covers))
+      {
+        centre = pt;
+        break;
+      }
     }
-    auto sph = Geo::min_ball(pt_to_mrg.data(), pt_to_mrg.size());
     Utils::FindMax<double> max_tol;
     for (const auto& vert : mrg_set)
     {
       Geo::Point pt;
       vert->geom(pt);
-      auto new_tol = Geo::length(pt - sph.centre_) + vert->tolerance();
+      auto new_tol = Geo::length(pt - centre) + vert->tolerance();
       max_tol.add(new_tol);
     }
     auto vert0 = *mrg_set.begin();
-    vert0->set_geom(sph.centre_);
+    vert0->set_geom(centre);
     vert0->set_tolerance(max_tol());
     auto vert_it = mrg_set.begin();
     while (++vert_it != mrg_set.end())
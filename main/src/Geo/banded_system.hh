@@ -0,0 +1,87 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace Geo
+{
+
+/*! Symmetric matrix with A(i, j) = 0 if |i - j| > band. Only the lower
+    band is stored, row by row, and cholesky() factorizes it in place.
+    Memory and factorization are O(size * band) and O(size * band^2).
+*/
+class BandedSymmetricMatrix
+{
+public:
+  void init(const size_t _size, const size_t _band)
+  {
+    size_ = _size;
+    band_ = _band;
+    vals_.assign(_size * (_band + 1), 0.);
+  }
+  size_t size() const { return size_; }
+  size_t band() const { return band_; }
+
+  // Element (_i, _j) with _j <= _i <= _j + band.
+  double& operator()(const size_t _i, const size_t _j)
+  {
+    return vals_[_i * (band_ + 1) + band_ + _j - _i];
+  }
+  double operator()(const size_t _i, const size_t _j) const
+  {
+    return vals_[_i * (band_ + 1) + band_ + _j - _i];
+  }
+
+  // L * L^T decomposition. Fails on a pivot small compared to the diagonal,
+  // in this case the matrix content is undefined.
+  bool cholesky()
+  {
+    for (size_t i = 0; i < size_; ++i)
+    {
+      const size_t first = i > band_ ? i - band_ : 0;
+      for (size_t j = first; j <= i; ++j)
+      {
+        double s = (*this)(i, j);
+        for (size_t k = first; k < j; ++k)
+          s -= (*this)(i, k) * (*this)(j, k);
+        if (j < i)
+        {
+          (*this)(i, j) = s / (*this)(j, j);
+          continue;
+        }
+        if (!(s > PIVOT_TOL * (*this)(i, i)))
+          return false;
+        (*this)(i, i) = std::sqrt(s);
+      }
+    }
+    return true;
+  }
+
+  // Solves L * L^T * x = _b in place after cholesky(). ValueT can be a
+  // scalar or a vector with the arithmetic operators.
+  template <typename ValueT>
+  void solve(std::vector<ValueT>& _b) const
+  {
+    for (size_t i = 0; i < size_; ++i)
+    {
+      for (size_t k = i > band_ ? i - band_ : 0; k < i; ++k)
+        _b[i] -= (*this)(i, k) * _b[k];
+      _b[i] /= (*this)(i, i);
+    }
+    for (size_t i = size_; i-- > 0;)
+    {
+      _b[i] /= (*this)(i, i);
+      const size_t first = i > band_ ? i - band_ : 0;
+      for (size_t k = first; k < i; ++k)
+        _b[k] -= (*this)(i, k) * _b[i];
+    }
+  }
+
+private:
+  static constexpr double PIVOT_TOL = 1e-14;
+  size_t size_ = 0, band_ = 0;
+  std::vector<double> vals_;
+};
+
+}//namespace Geo
@@ -1,11 +1,12 @@
 
 #include <bspline_fiting.hh>
+#include <Geo/banded_system.hh>
+#include <Geo/evalnurbs.hh>
 #include <Geo/iterate.hh>
+#include "Utils/error_handling.hh"
+#include "Utils/parallel.hh"
 
-#pragma warning( push )
-#pragma warning( disable : 4714 )
-#include <Eigen/Dense>
-
+#include <algorithm>
 #include <fstream>
 #include <vector>
 
@@ -20,14 +21,13 @@ struct BsplineFitting : public IBsplineFitting<dimT>
     if (_knots.empty())
       return false;
     auto extn = (_knots.back() - _knots.front()) / 2;
+    knots_.clear();
     knots_.push_back(_knots.front() - extn);
     knots_.insert(knots_.end(), _knots.begin(), _knots.end());
     knots_.push_back(_knots.back() + extn);
     deg_ = _deg;
     f_ = &_f;
     X_.clear();
-    A_.clear();
-    B_.clear();
     return true;
   }
 
@@ -40,15 +40,35 @@ struct BsplineFitting : public IBsplineFitting<dimT>
 
   void compute();
   const std::vector<VectorD<dimT>>& X() const { return X_; }
-  VectorD<dimT> eval(const double _t);
+  VectorD<dimT> eval(const double _t) const;
 private:
-  void find_equations();
-  double N(size_t _i, const size_t _k, const double _t);
-  void add_equation(const double _t, const double _wi);
+  // Sample of the function with its least square weight.
+  struct Sample
+  {
+    double t_, w_;
+  };
+  // Equation of a sample: the non zero basis functions are
+  // first_ ... first_ + deg_ (at most MAX_DEG + 1).
+  enum { MAX_DEG = 15 };
+  struct Equation
+  {
+    size_t first_;
+    double N_[MAX_DEG + 1];
+    VectorD<dimT> pt_;
+  };
+
+  void find_samples();
+  void add_sample(const double _t, const double _wi);
+  void make_equation(const Sample& _smpl, const VectorD<dimT>* _crv_pt,
+    Equation& _eq) const;
+  void eval_samples();
+  size_t basis(const double _t, double* _N) const;
 
-  std::vector<std::vector<double>> A_;
+  std::vector<Sample> samples_;
+  std::vector<Equation> eqs_;
+  std::vector<VectorD<dimT>> crv_pts_;
+  BandedSymmetricMatrix AtA_;
   std::vector<double> knots_;
-  std::vector<VectorD<dimT>> B_;
   std::vector<VectorD<dimT>> X_;
   size_t deg_ = 0;
   const IFunction* f_ = nullptr;
@@ -57,51 +77,108 @@ private:
   size_t smpl_per_intrvl_ = 4;
 };
 
+/*! Computes the basis functions of degree deg_ not null in _t, stored in
+    _N[0 ... deg_], returns the index of the first one. The triangular
+    scheme of Cox - de Boor skips the functions whose support goes beyond
+    the knot vector.
+*/
 template<size_t dimT>
-double BsplineFitting<dimT>::N(size_t _i, const size_t _p, const double _t)
+size_t BsplineFitting<dimT>::basis(const double _t, double* _N) const
 {
-  if (_p == 0)
+  std::fill_n(_N, deg_ + 1, 0.);
+  auto it = std::upper_bound(knots_.begin(), knots_.end(), _t);
+  if (it == knots_.begin() || it == knots_.end())
+    return 0;
+  const size_t span = it - knots_.begin() - 1;
+  // _N[j] is the function span - deg_ + j.
+  _N[deg_] = 1;
+  for (size_t k = 1; k <= deg_; ++k)
   {
-    if (_t < knots_[_i] || _t >= knots_[_i + 1])
-      return 0;
-    return 1;
+    for (size_t j = deg_ - k; j <= deg_; ++j)
+    {
+      if (span + j < deg_)
+        continue;
+      const size_t i = span + j - deg_;
+      if (i + k + 1 >= knots_.size())
+      {
+        _N[j] = 0;
+        continue;
+      }
+      double res = 0;
+      if (_N[j] != 0)
+        res += _N[j] * (_t - knots_[i]) / (knots_[i + k] - knots_[i]);
+      if (j < deg_ && _N[j + 1] != 0)
+      {
+        auto end_kn = knots_[i + k + 1];
+        res += _N[j + 1] * (end_kn - _t) / (end_kn - knots_[i + 1]);
+      }
+      _N[j] = res;
+    }
   }
-  double res = 0;
+  if (span >= deg_)
+    return span - deg_;
+  // Functions with negative index do not exist.
+  std::copy(_N + deg_ - span, _N + deg_ + 1, _N);
+  std::fill(_N + span + 1, _N + deg_ + 1, 0.);
+  return 0;
+}
 
-  auto b = N(_i, _p - 1, _t);
-  if (b != 0)
-    res += b * (_t - knots_[_i]) / (knots_[_i + _p] - knots_[_i]);
+template<size_t dimT>
+void BsplineFitting<dimT>::add_sample(const double _t, const double _wi)
+{
+  samples_.push_back({ _t, _wi });
+}
 
-  b = N(_i + 1, _p - 1, _t);
-  if (b != 0)
+// Evaluates the current curve in all the samples (sorted by parameter)
+// with NubBatch, in parallel on chunks of samples.
+template<size_t dimT>
+void BsplineFitting<dimT>::eval_samples()
+{
+  crv_pts_.resize(samples_.size());
+  // NubBatch knots do not have the extra end knots.
+  std::vector<double> knots(knots_.begin() + 1, knots_.end() - 1);
+  NubBatch<dimT> crv;
+  THROW_IF(!crv.init(X_, knots), "Invalid fitted B-spline");
+  static constexpr size_t CHUNK = 256;
+  const auto chunk_nmbr = (samples_.size() + CHUNK - 1) / CHUNK;
+  Utils::parallel_for(chunk_nmbr, [this, &crv](size_t _c)
   {
-    auto end_kn = knots_[_i + _p + 1];
-    res += b * (end_kn - _t) / (end_kn - knots_[_i + 1]);
-  }
-  return res;
+    const auto beg = _c * CHUNK;
+    const auto n = std::min(CHUNK, samples_.size() - beg);
+    double pars[CHUNK], vals[dimT * CHUNK];
+    for (size_t j = 0; j < n; ++j)
+      pars[j] = samples_[beg + j].t_;
+    crv.eval(pars, n, vals);
+    for (size_t j = 0; j < n; ++j)
+      for (size_t d = 0; d < dimT; ++d)
+        crv_pts_[beg + j][d] = vals[d * n + j];
+  }, 1);
 }
 
+// Evaluates the row of the least square system and the point to fit,
+// it can run in parallel on different samples.
 template<size_t dimT>
-void BsplineFitting<dimT>::add_equation(const double _t, const double _wi)
+void BsplineFitting<dimT>::make_equation(
+  const Sample& _smpl, const VectorD<dimT>* _crv_pt, Equation& _eq) const
 {
-  A_.emplace_back();
-  const auto wi_sqr = sqrt(_wi);
-  for (int j = 0; j < knots_.size() - deg_ - 1; ++j)
-    A_.back().push_back(N(j, deg_, _t) * wi_sqr);
+  const auto wi_sqr = sqrt(_smpl.w_);
+  _eq.first_ = basis(_smpl.t_, _eq.N_);
+  for (size_t j = 0; j <= deg_; ++j)
+    _eq.N_[j] *= wi_sqr;
 
   VectorD<dimT> pt_crv;
-  if (X_.empty() || (_t == knots_[1]) || (_t == knots_[knots_.size() - 2]))
-    pt_crv = f_->evaluate(_t);
+  if (_crv_pt == nullptr || (_smpl.t_ == knots_[1]) ||
+     (_smpl.t_ == knots_[knots_.size() - 2]))
+    pt_crv = f_->evaluate(_smpl.t_);
   else
-    pt_crv = f_->closest_point(eval(_t), _t);
-  B_.emplace_back(pt_crv * wi_sqr);
-};
+    pt_crv = f_->closest_point(*_crv_pt, _smpl.t_);
+  _eq.pt_ = pt_crv * wi_sqr;
+}
 
 template<size_t dimT>
-void BsplineFitting<dimT>::find_equations()
+void BsplineFitting<dimT>::find_samples()
 {
-  A_.clear();
-  B_.clear();
+  samples_.clear();
   if (fvr_bndr_)
   {
     double w_prev = 0;
@@ -117,12 +194,12 @@ void BsplineFitting<dimT>::find_equations()
       for (double x = 0; x < 1; x += step)
       {
         auto t = knots_[i - 1] * (1 - x) + knots_[i] * x;
-        add_equation(t, wi);
+        add_sample(t, wi);
         wi = w_step;
       }
       w_prev = w_step / 2;
     }
-    add_equation(knots_[last_idx], w_prev);
+    add_sample(knots_[last_idx], w_prev);
   }
   else
   {
@@ -135,46 +212,72 @@ void BsplineFitting<dimT>::find_equations()
       const double step = 1. / smpl_per_intrvl_;
       const double wi = dw * step;
       for (double x = step / 2; x < 1; x += step)
-        add_equation(knots_[i - 1] * (1 - x) + knots_[i] * x, wi);
+        add_sample(knots_[i - 1] * (1 - x) + knots_[i] * x, wi);
     }
   }
 }
 
+/*! The normal equations of the least square problem are banded with
+    half bandwidth deg_, they are assembled in a BandedSymmetricMatrix and
+    solved with its Cholesky decomposition. The function is evaluated in
+    parallel on the samples.
+*/
 template<size_t dimT>
 void BsplineFitting<dimT>::compute()
 {
+  THROW_IF(deg_ > MAX_DEG, "B-spline degree too big");
+  const auto col_nmbr = knots_.size() - deg_ - 1;
+  find_samples();
+  eqs_.resize(samples_.size());
   for (size_t iter = 0; iter <= itr_nmbr_; ++iter)
   {
-    find_equations();
-    const auto row_nmbr = A_.size();
-    const auto col_nmbr = A_.front().size();
-    Eigen::MatrixXd A(row_nmbr, col_nmbr);
-    for (int i = 0; i < row_nmbr; ++i)
+    const bool use_crv = !X_.empty();
+    if (use_crv)
+      eval_samples();
+    Utils::parallel_for(samples_.size(), [this, use_crv](size_t _i)
+    {
+      make_equation(samples_[_i], use_crv ? &crv_pts_[_i] : nullptr, eqs_[_i]);
+    });
+
+    // Sequential assembly in sample order, the result does not depend on
+    // the thread number.
+    AtA_.init(col_nmbr, deg_);
+    std::vector<VectorD<dimT>> AtB(col_nmbr, VectorD<dimT>{ 0 });
+    double max_diag = 0;
+    for (const auto& eq : eqs_)
     {
-      for (int j = 0; j < col_nmbr; ++j)
-        A(i, j) = A_[i][j];
+      for (size_t i = 0; i <= deg_ && eq.first_ + i < col_nmbr; ++i)
+      {
+        const auto row = eq.first_ + i;
+        for (size_t j = 0; j <= i; ++j)
+          AtA_(row, eq.first_ + j) += eq.N_[i] * eq.N_[j];
+        AtB[row] += eq.N_[i] * eq.pt_;
+        max_diag = std::max(max_diag, AtA_(row, row));
+      }
     }
-    const auto& jsvd =
-      A.jacobiSvd(Eigen::ComputeThinU | Eigen::ComputeThinV);
-    for (int j = 0; j < B_[0].size(); ++j)
+    // Control points without samples are not constrained, a small
+    // regularization gives the minimal norm solution as the SVD did.
+    auto AtA_copy = AtA_;
+    if (!AtA_.cholesky())
     {
-      Eigen::VectorXd B(B_.size());
-      for (int i = 0; i < row_nmbr; ++i)
-        B(i) = B_[i][j];
-      Eigen::VectorXd res = jsvd.solve(B);
-      X_.resize(col_nmbr);
-      for (int i = 0; i < col_nmbr; ++i)
-        X_[i][j] = res(i);
+      AtA_ = AtA_copy;
+      for (size_t i = 0; i < col_nmbr; ++i)
+        AtA_(i, i) += 1e-12 * max_diag;
+      THROW_IF(!AtA_.cholesky(), "B-spline fitting singular system");
     }
+    AtA_.solve(AtB);
+    X_ = std::move(AtB);
   }
 }
 
 template<size_t dimT>
-VectorD<dimT> BsplineFitting<dimT>::eval(const double _t)
+VectorD<dimT> BsplineFitting<dimT>::eval(const double _t) const
 {
+  double N[MAX_DEG + 1];
+  const auto first = basis(_t, N);
   VectorD<dimT> res = { 0 };
-  for (int i = 0; i < X_.size(); ++i)
-    res += N(i, deg_, _t) * X_[i];
+  for (size_t i = 0; i <= deg_ && first + i < X_.size(); ++i)
+    res += N[i] * X_[first + i];
   return res;
 }
 
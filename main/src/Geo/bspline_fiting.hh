@@ -8,6 +8,7 @@ namespace Geo {
 template <size_t dimT>
 struct IBsplineFitting
 {
+  // Called from several threads during compute().
   struct IFunction
   {
     virtual Geo::VectorD<dimT> evaluate(const double _t) const = 0;
@@ -7,15 +7,12 @@
 #include "PolygonTriangularization/poly_triang.hh"
 #include "Utils/error_handling.hh"
 
-#define JACOBI
-#ifdef JACOBI
-#pragma warning( push )
-#pragma warning( disable : 4714 )
-#include <Eigen/Dense>
-#endif
-
 #include <vector>
 
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
 namespace {
 bool check_par(double _t) { return _t >= 0 && _t <= 1; }
 bool check_par(double _u, double _v)
@@ -24,61 +21,6 @@ bool check_par(double _u, double _v)
 }
 }//namespace
 
-namespace Gen
-{
-template <class TypeT, size_t DimT, bool Inf1T, bool Inf2T>
-bool closest_point(const Segment<TypeT, DimT>& _seg_a, const Segment<TypeT, DimT>& _seg_b,
-                   Geo::Vector<TypeT, DimT>* _clsst_pt, double _t[2], double * _dist_sq)
-{
-  Geo::Vector<TypeT, DimT> a[2] = {
-    _seg_a[1] - _seg_a[0],
-    _seg_b[0] - _seg_b[1] };
-  Eigen::MatrixXd A(a[0].size(), std::size(a));
-  Eigen::VectorXd B(a[0].size());
-  for (int i = 0; i < a[0].size(); ++i)
-  {
-    B(i) = _seg_b[0][i] - _seg_a[0][i];
-    for (int j = 0; j < std::size(a); ++j)
-      A(i, j) = a[j][i];
-  }
-  Eigen::VectorXd  res = (A.transpose() * A).ldlt().solve(A.transpose() * B);
-  if (constexpr(!Inf1T))
-  {
-    if (!check_par(res(0)))
-      return false;
-  }
-  if (constexpr(!Inf2T))
-  {
-    if (!check_par(res(1)))
-      return false;
-  }
-  auto pt_a = evaluate(_seg_a, res(0));
-  auto pt_b = evaluate(_seg_b, res(1));
-  if (_clsst_pt != nullptr)
-    *_clsst_pt = (pt_a + pt_b) / 2.;
-  if (_dist_sq != nullptr)
-    *_dist_sq = Geo::length_square(pt_a - pt_b);
-  if (_t != nullptr)
-  {
-    _t[0] = res(0);
-    _t[1] = res(1);
-  }
-  return true;
-}
-
-#define INST_CLOSEST_POINT_SEG_SEG(TYPE, NUM, INF)                        \
-template bool closest_point<TYPE, NUM, INF, INF>(                              \
-  const Segment<TYPE, NUM>& _seg_a, const Segment<TYPE, NUM>& _seg_b,\
-  Geo::Vector<TYPE, NUM>* _clsst_pt, double _t[2], double * _dist);
-
-INST_CLOSEST_POINT_SEG_SEG(double, 2, false)
-INST_CLOSEST_POINT_SEG_SEG(double, 2, true)
-
-INST_CLOSEST_POINT_SEG_SEG(double, 3, false)
-INST_CLOSEST_POINT_SEG_SEG(double, 3, true)
-
-} // namespace Gen
-
 namespace Geo {
 
 Point evaluate(const Segment& _seg, double _t)
@@ -102,6 +44,7 @@ struct PolygonalFace : public IPolygonalFace
     return true;
   }
   virtual size_t triangle_number() const { return tris_.size(); }
+  virtual const TriangleBatch& triangles() const { return batch_; }
 
   virtual Point normal() const;
 
@@ -119,6 +62,7 @@ protected:
 
 private:
   std::vector<Triangle> tris_;
+  TriangleBatch batch_;
   std::vector<std::vector<Point>> ptss_;
 };
 
@@ -134,12 +78,14 @@ void PolygonalFace::compute()
   }
   const auto& tris = ptg->triangles();
   const auto& poly = ptg->polygon();
+  batch_.reserve(batch_.size() + tris.size());
   for (const auto& tri : tris)
   {
     tris_.push_back({
       poly[tri[0]],
       poly[tri[1]],
       poly[tri[2]] });
+    batch_.add(tris_.back());
   }
 }
 
@@ -181,7 +127,7 @@ bool closest_point(const Triangle& _tri, const Point& _pt,
   B[1] = dp * v1;
 
   double uv[2];
-  if (!solve_2x2(A, uv, B))
+  if (!solve<2>(A, uv, B))
     return false;
   if (!check_par(uv[0], uv[1]))
     return false;
@@ -196,89 +142,290 @@ bool closest_point(const Triangle& _tri, const Point& _pt,
 bool closest_point(const IPolygonalFace& _face, const Point& _pt,
   Point* _clsst_pt, double * _dist_sq)
 {
-  Utils::StatisticsT<double> dist_stats;
-  Triangle tri;
-  Point clsst_pt;
-  const auto tri_nmbr = _face.triangle_number();
-  for (size_t i = 0; i < tri_nmbr; ++i)
-  {
-    if (!_face.triangle(i, tri))
-      continue;
-    double dist_sq = 0;
-    if (!closest_point(tri, _pt, &clsst_pt, &dist_sq))
-      continue;
-    if ((dist_stats.add(dist_sq) & dist_stats.Smallest) && _clsst_pt != nullptr)
-      *_clsst_pt = clsst_pt;
-  }
-  if (dist_stats.count() == 0)
-    return false;
-  if (_dist_sq != nullptr)
-    *_dist_sq = dist_stats.min();
-  return true;
+  return _face.triangles().closest_point(_pt, _clsst_pt, _dist_sq) != SIZE_MAX;
 }
 
-bool closest_point(const Triangle& _tri, const Segment& _seg,
-  Point* _clsst_pt, double * _t, double * _dist_sq)
+namespace {
+
+// Columns of the triangle/segment system with a sine of their angle below
+// this value are too ill conditioned for the Cramer rule filter.
+const double PARALLEL_TOL = 1e-3;
+// Relative margin of the Cramer rule filter on the parameter ranges.
+const double OUTSIDE_TOL = 1e-6;
+
+bool outside(double _x, double _min, double _max)
 {
-  const auto a = _seg[0] - _tri[0];
-  const Point coeff[] =
-  { _tri[1] - _tri[0], _tri[2] - _tri[0], _seg[0] - _seg[1] };
+  const double tol = OUTSIDE_TOL * (1 + std::fabs(_x));
+  return _x < _min - tol || _x > _max + tol;
+}
 
-  Eigen::MatrixXd A(3, 3);
-  Eigen::VectorXd B(3);
-  for (int i = 0; i < 3; ++i)
-  {
-    for (int j = 0; j < 3; ++j)
-      A(j, i) = coeff[i][j];
-    B(i) = a[i];
-  }
-#if 1
-  Eigen::VectorXd  uvt = (A.transpose() * A).ldlt().solve(A.transpose() * B);
-#else
-  const auto& jsvd =
-    A.jacobiSvd(Eigen::ComputeThinU | Eigen::ComputeThinV);
-  Eigen::VectorXd uvt = jsvd.solve(B);
-#endif
+// Cheap test with the Cramer rule on triple products: returns false only
+// if the segment clearly misses the triangle. With w = _seg[0] - _seg[1],
+// a = _seg[0] - _tri[0] and n = e1 % e2 the determinant is n * w and
+//   u = a * (e2 % w) / det, v = a * (w % e1) / det, t = a * n / det.
+bool may_intersect(const Point& _a, const Point& _e1, const Point& _e2,
+  const Point& _nrm, double _edge_len, const Point& _w)
+{
+  const auto det = _nrm * _w;
+  if (std::fabs(det) <= PARALLEL_TOL * _edge_len * length(_w))
+    return true;
+  const double u = (_a * (_e2 % _w)) / det;
+  const double v = (_a * (_w % _e1)) / det;
+  const double t = (_a * _nrm) / det;
+  return !outside(u, 0, 1) && !outside(v, 0, 1) && !outside(u + v, 0, 1) &&
+    !outside(t, 0, 1);
+}
 
+// Solves _tri[0] + u * e1 + v * e2 = _seg[0] + t * (_seg[1] - _seg[0])
+// in the least squares sense, so segments on the triangle plane are found.
+bool intersect(const Triangle& _tri, const Point& _e1, const Point& _e2,
+  const Segment& _seg, double& _t, Point& _clsst_pt, double& _dist_sq)
+{
+  const Point cols[] = { _e1, _e2, _seg[0] - _seg[1] };
+  double uvt[3];
+  least_squares(cols, _seg[0] - _tri[0], uvt);
   if (!check_par(uvt[0], uvt[1]) || !check_par(uvt[2]))
     return false;
   auto pt_seg = evaluate(_seg, uvt[2]);
   auto pt_tri = evaluate(_tri, uvt[0], uvt[1]);
+  _t = uvt[2];
+  _clsst_pt = (pt_seg + pt_tri) / 2.;
+  _dist_sq = length_square(pt_seg - pt_tri);
+  return true;
+}
+
+}//namespace
+
+bool closest_point(const Triangle& _tri, const Segment& _seg,
+  Point* _clsst_pt, double * _t, double * _dist_sq)
+{
+  double t, dist_sq;
+  Point clsst_pt;
+  if (!intersect(_tri, _tri[1] - _tri[0], _tri[2] - _tri[0], _seg,
+                 t, clsst_pt, dist_sq))
+    return false;
   if (_clsst_pt!= nullptr)
-    *_clsst_pt = (pt_seg + pt_tri) / 2.;
+    *_clsst_pt = clsst_pt;
   if (_t != nullptr)
-    *_t = uvt[2];
+    *_t = t;
   if (_dist_sq != nullptr)
-    *_dist_sq = length_square(pt_seg - pt_tri);
+    *_dist_sq = dist_sq;
   return true;
 }
 
-bool closest_point(const IPolygonalFace& _face, const Segment& _pt,
+bool closest_point(const IPolygonalFace& _face, const Segment& _seg,
   Point* _clsst_pt, double * _t, double * _dist_sq)
 {
-  Utils::StatisticsT<double> dist_stats;
+  return _face.triangles().closest_point(
+    _seg, _clsst_pt, _t, _dist_sq) != SIZE_MAX;
+}
+
+void TriangleBatch::clear()
+{
+  for (size_t i = 0; i < 3; ++i)
+  {
+    for (auto& vrt : vrt_)
+      vrt[i].clear();
+    e1_[i].clear();
+    e2_[i].clear();
+    nrm_[i].clear();
+    inv_gram_[i].clear();
+  }
+  edge_len_.clear();
+}
+
+void TriangleBatch::reserve(size_t _size)
+{
+  for (size_t i = 0; i < 3; ++i)
+  {
+    for (auto& vrt : vrt_)
+      vrt[i].reserve(_size);
+    e1_[i].reserve(_size);
+    e2_[i].reserve(_size);
+    nrm_[i].reserve(_size);
+    inv_gram_[i].reserve(_size);
+  }
+  edge_len_.reserve(_size);
+}
+
+void TriangleBatch::add(const Triangle& _tri)
+{
+  const auto e1 = _tri[1] - _tri[0];
+  const auto e2 = _tri[2] - _tri[0];
+  const auto nrm = e1 % e2;
+  for (size_t i = 0; i < 3; ++i)
+  {
+    for (size_t j = 0; j < 3; ++j)
+      vrt_[j][i].push_back(_tri[j][i]);
+    e1_[i].push_back(e1[i]);
+    e2_[i].push_back(e2[i]);
+    nrm_[i].push_back(nrm[i]);
+  }
+  edge_len_.push_back(length(e1) * length(e2));
+  // Same system as closest_point(Triangle, Point).
+  const auto v0 = _tri[0] - _tri[2];
+  const auto v1 = _tri[1] - _tri[2];
+  double gram[2][2] = {};
+  gram[0][0] = length_square(v0);
+  gram[1][1] = length_square(v1);
+  gram[0][1] = gram[1][0] = v0 * v1;
+  double inv_gram[2][2] = {};
+  invert(gram, inv_gram);
+  inv_gram_[0].push_back(inv_gram[0][0]);
+  inv_gram_[1].push_back(inv_gram[0][1]);
+  inv_gram_[2].push_back(inv_gram[1][1]);
+}
+
+Triangle TriangleBatch::triangle(size_t _i) const
+{
   Triangle tri;
-  Point clsst_pt;
-  for (size_t i = 0; i < _face.triangle_number(); ++i)
+  for (size_t j = 0; j < 3; ++j)
+    tri[j] = { vrt_[j][0][_i], vrt_[j][1][_i], vrt_[j][2][_i] };
+  return tri;
+}
+
+size_t TriangleBatch::closest_point(const Point& _pt,
+  Point* _clsst_pt, double * _dist) const
+{
+  size_t best = SIZE_MAX;
+  double best_dist_sq = std::numeric_limits<double>::max();
+  Point best_pt;
+  for (size_t i = 0; i < size(); ++i)
   {
-    if (!_face.triangle(i, tri))
+    if (inv_gram_[0][i] == 0)
+      continue;
+    const auto tri = triangle(i);
+    const auto v0 = tri[0] - tri[2];
+    const auto v1 = tri[1] - tri[2];
+    const auto dp = _pt - tri[2];
+    const double b0 = dp * v0, b1 = dp * v1;
+    const double u = inv_gram_[0][i] * b0 + inv_gram_[1][i] * b1;
+    const double v = inv_gram_[1][i] * b0 + inv_gram_[2][i] * b1;
+    if (!check_par(u, v))
       continue;
-    double dist_sq = 0, t;
-    if (!closest_point(tri, _pt, &clsst_pt, &t, &dist_sq))
+    const auto pt = tri[2] + u * v0 + v * v1;
+    const auto dist_sq = length_square(pt - _pt);
+    if (dist_sq >= best_dist_sq)
       continue;
-    if (dist_stats.add(dist_sq) & dist_stats.Smallest)
+    best = i;
+    best_dist_sq = dist_sq;
+    best_pt = pt;
+  }
+  if (best == SIZE_MAX)
+    return best;
+  if (_clsst_pt != nullptr)
+    *_clsst_pt = best_pt;
+  if (_dist != nullptr)
+    *_dist = std::sqrt(best_dist_sq);
+  return best;
+}
+
+size_t TriangleBatch::closest_point(const Segment& _seg,
+  Point* _clsst_pt, double * _t, double * _dist_sq) const
+{
+  size_t best = SIZE_MAX;
+  double best_t = 0;
+  double best_dist_sq = std::numeric_limits<double>::max();
+  Point best_pt;
+  auto check = [&](size_t _i)
+  {
+    const Point e1{ e1_[0][_i], e1_[1][_i], e1_[2][_i] };
+    const Point e2{ e2_[0][_i], e2_[1][_i], e2_[2][_i] };
+    double t, dist_sq;
+    Point pt;
+    if (!intersect(triangle(_i), e1, e2, _seg, t, pt, dist_sq) ||
+        dist_sq >= best_dist_sq)
+      return;
+    best = _i;
+    best_t = t;
+    best_dist_sq = dist_sq;
+    best_pt = pt;
+  };
+  const auto w = _seg[0] - _seg[1];
+  size_t i = 0;
+#ifdef __AVX2__
+  const __m256d zero = _mm256_setzero_pd();
+  const __m256d one = _mm256_set1_pd(1.);
+  const __m256d abs_mask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7fffffffffffffff));
+  const __m256d par_tol = _mm256_set1_pd(PARALLEL_TOL * length(w));
+  const __m256d out_tol = _mm256_set1_pd(OUTSIDE_TOL);
+  __m256d ww[3], s0[3];
+  for (size_t k = 0; k < 3; ++k)
+  {
+    ww[k] = _mm256_set1_pd(w[k]);
+    s0[k] = _mm256_set1_pd(_seg[0][k]);
+  }
+  auto dot = [](const __m256d _a[3], const __m256d _b[3])
+  {
+    return _mm256_add_pd(_mm256_mul_pd(_a[0], _b[0]),
+      _mm256_add_pd(_mm256_mul_pd(_a[1], _b[1]), _mm256_mul_pd(_a[2], _b[2])));
+  };
+  auto cross = [](const __m256d _a[3], const __m256d _b[3], __m256d _c[3])
+  {
+    _c[0] = _mm256_sub_pd(_mm256_mul_pd(_a[1], _b[2]), _mm256_mul_pd(_a[2], _b[1]));
+    _c[1] = _mm256_sub_pd(_mm256_mul_pd(_a[2], _b[0]), _mm256_mul_pd(_a[0], _b[2]));
+    _c[2] = _mm256_sub_pd(_mm256_mul_pd(_a[0], _b[1]), _mm256_mul_pd(_a[1], _b[0]));
+  };
+  // Mask of the lanes with _x inside [_min, _max] up to the relative margin.
+  auto inside = [&](__m256d _x, __m256d _min, __m256d _max)
+  {
+    const __m256d tol = _mm256_mul_pd(out_tol,
+      _mm256_add_pd(one, _mm256_and_pd(_x, abs_mask)));
+    return _mm256_and_pd(
+      _mm256_cmp_pd(_x, _mm256_sub_pd(_min, tol), _CMP_GE_OQ),
+      _mm256_cmp_pd(_x, _mm256_add_pd(_max, tol), _CMP_LE_OQ));
+  };
+  for (; i + 4 <= size(); i += 4)
+  {
+    __m256d e1[3], e2[3], nrm[3], a[3], tmp[3];
+    for (size_t k = 0; k < 3; ++k)
     {
-      if (_clsst_pt != nullptr)
-        *_clsst_pt = clsst_pt;
-      if (_t != nullptr)
-        *_t = t;
+      e1[k] = _mm256_loadu_pd(&e1_[k][i]);
+      e2[k] = _mm256_loadu_pd(&e2_[k][i]);
+      nrm[k] = _mm256_loadu_pd(&nrm_[k][i]);
+      a[k] = _mm256_sub_pd(s0[k], _mm256_loadu_pd(&vrt_[0][k][i]));
+    }
+    const __m256d det = dot(nrm, ww);
+    // Ill conditioned lanes always go to the exact test.
+    const __m256d ill = _mm256_cmp_pd(_mm256_and_pd(det, abs_mask),
+      _mm256_mul_pd(par_tol, _mm256_loadu_pd(&edge_len_[i])), _CMP_LE_OQ);
+    const __m256d inv_det = _mm256_div_pd(one, det);
+    cross(e2, ww, tmp);
+    const __m256d u = _mm256_mul_pd(dot(a, tmp), inv_det);
+    cross(ww, e1, tmp);
+    const __m256d v = _mm256_mul_pd(dot(a, tmp), inv_det);
+    const __m256d t = _mm256_mul_pd(dot(a, nrm), inv_det);
+    __m256d maybe = inside(u, zero, one);
+    maybe = _mm256_and_pd(maybe, inside(v, zero, one));
+    maybe = _mm256_and_pd(maybe, inside(_mm256_add_pd(u, v), zero, one));
+    maybe = _mm256_and_pd(maybe, inside(t, zero, one));
+    const int mask = _mm256_movemask_pd(_mm256_or_pd(ill, maybe));
+    for (size_t j = 0; j < 4; ++j)
+    {
+      if (mask & (1 << j))
+        check(i + j);
     }
   }
-  if (dist_stats.count() == 0)
-    return false;
+#endif
+  for (; i < size(); ++i)
+  {
+    const Point e1{ e1_[0][i], e1_[1][i], e1_[2][i] };
+    const Point e2{ e2_[0][i], e2_[1][i], e2_[2][i] };
+    const Point nrm{ nrm_[0][i], nrm_[1][i], nrm_[2][i] };
+    const Point a{ _seg[0][0] - vrt_[0][0][i], _seg[0][1] - vrt_[0][1][i],
+      _seg[0][2] - vrt_[0][2][i] };
+    if (may_intersect(a, e1, e2, nrm, edge_len_[i], w))
+      check(i);
+  }
+  if (best == SIZE_MAX)
+    return best;
+  if (_clsst_pt != nullptr)
+    *_clsst_pt = best_pt;
+  if (_t != nullptr)
+    *_t = best_t;
   if (_dist_sq != nullptr)
-    *_dist_sq = dist_stats.min();
-  return true;
+    *_dist_sq = best_dist_sq;
+  return best;
 }
 
-}//namespace Geo
\ No newline at end of file
+}//namespace Geo
@@ -1,9 +1,12 @@
 #pragma once
 
 #include "Geo/vector.hh"
+#include "Geo/linear_system.hh"
 
 #include <array>
+#include <limits>
 #include <memory>
+#include <vector>
 
 namespace Gen {
 template <class TypeT, size_t DimT> using Segment = 
@@ -43,10 +46,54 @@ bool closest_point(
   return true;
   }
 
+/*! Closest points between two segments (or lines if Inf1/Inf2 are true).
+    Solves the 2x2 normal equations on the stack, so it never allocates.
+    Parallel segments get the solution with a null component on the
+    degenerate pivot, then finite segments are checked on their range:
+    the start of the shorter segment (_seg_b with equal lengths) is
+    projected on the other one, and overlapping segments can succeed.
+*/
 template <class TypeT, size_t DimT, bool Inf1 = false, bool Inf2 = false>
-bool closest_point(const Segment<TypeT, DimT>& _seg_a, const Segment<TypeT, DimT>& _seg_b,
-                   Geo::Vector<TypeT, DimT>* _clsst_pt = nullptr, 
-                   double _t[2] = nullptr, double * _dist = nullptr);
+constexpr bool closest_point(
+  const Segment<TypeT, DimT>& _seg_a, const Segment<TypeT, DimT>& _seg_b,
+  Geo::Vector<TypeT, DimT>* _clsst_pt = nullptr,
+  double _t[2] = nullptr, double * _dist = nullptr)
+{
+  // _seg_a[0] + t0 * a0 = _seg_b[0] - t1 * a1
+  const Geo::Vector<TypeT, DimT> a[2] = {
+    _seg_a[1] - _seg_a[0],
+    _seg_b[0] - _seg_b[1] };
+  double res[2] = {};
+  Geo::least_squares(a, _seg_b[0] - _seg_a[0], res);
+  const TypeT t0 = res[0], t1 = res[1];
+  if constexpr (!Inf1)
+  {
+    if (t0 < 0 || t0 > 1)
+      return false;
+  }
+  if constexpr (!Inf2)
+  {
+    if (t1 < 0 || t1 > 1)
+      return false;
+  }
+  TypeT dist_sq = 0;
+  for (size_t i = 0; i < DimT; ++i)
+  {
+    const TypeT pt_a = (1 - t0) * _seg_a[0][i] + t0 * _seg_a[1][i];
+    const TypeT pt_b = (1 - t1) * _seg_b[0][i] + t1 * _seg_b[1][i];
+    if (_clsst_pt != nullptr)
+      (*_clsst_pt)[i] = (pt_a + pt_b) / 2;
+    dist_sq += (pt_a - pt_b) * (pt_a - pt_b);
+  }
+  if (_dist != nullptr)
+    *_dist = dist_sq;
+  if (_t != nullptr)
+  {
+    _t[0] = t0;
+    _t[1] = t1;
+  }
+  return true;
+}
 
 
 } // namespace Gen
@@ -57,11 +104,53 @@ typedef VectorD3 Point;
 typedef std::array<Point, 2> Segment;
 typedef std::array<Point, 3> Triangle;
 
+/*! Set of triangles stored by coordinate (structure of arrays), so that
+    a segment can be tested against several triangles at once.
+    When compiled with AVX2 (GEO_AVX2 CMake option) four triangles are
+    filtered together.
+*/
+struct TriangleBatch
+{
+  void clear();
+  void reserve(size_t _size);
+  void add(const Triangle& _tri);
+  size_t size() const { return edge_len_.size(); }
+  Triangle triangle(size_t _i) const;
+
+  /*! Closest point between _seg and the triangles of the batch.
+      Returns the index of the triangle with the smallest distance
+      or SIZE_MAX if _seg does not cross any triangle.
+  */
+  size_t closest_point(const Segment& _seg,
+    Point* _clsst_pt = nullptr, double * _t = nullptr,
+    double * _dist_sq = nullptr) const;
+
+  /*! Projection of _pt on the triangles of the batch. Returns the index
+      of the nearest triangle containing the projection or SIZE_MAX.
+      As closest_point(Triangle, Point) _dist gets the distance, not its
+      square.
+  */
+  size_t closest_point(const Point& _pt,
+    Point* _clsst_pt = nullptr, double * _dist = nullptr) const;
+
+private:
+  // vrt_[j][i] is the coordinate i of the vertex j of the triangles.
+  std::vector<double> vrt_[3][3];
+  // Edges from the first vertex and their cross product.
+  std::vector<double> e1_[3], e2_[3], nrm_[3];
+  // Product of the edge lengths, the largest possible norm of nrm_.
+  std::vector<double> edge_len_;
+  // Inverse of the Gram matrix (00, 01, 11) of the edges from the last
+  // vertex, zero for degenerate triangles.
+  std::vector<double> inv_gram_[3];
+};
+
 struct IPolygonalFace
 {
   virtual ~IPolygonalFace() {}
   virtual bool triangle(size_t _idx, Triangle& _tri) const = 0;
   virtual size_t triangle_number() const = 0;
+  virtual const TriangleBatch& triangles() const = 0;
   virtual Point normal() const = 0;
   static std::shared_ptr<IPolygonalFace> make();
   template <class IteratorT> void add_loop(const IteratorT& _beg, const IteratorT& _end)
@@ -88,10 +177,10 @@ closest_point(const Segment& _seg, const Point& _pt,
 }
 
 /*! Finds the internal points at minimum distance between two segments.
-    Returns false 
-    if the two segments are parallel (according to the numeric precision) or
-    if the minimum distance point between the two segment is on an end of 
-    at least one the two segments.
+    Returns false if the minimum distance point between the two segment is
+    outside at least one the two segments. Parallel segments are not
+    rejected: the start of the shorter one is projected on the other one
+    (see Gen::closest_point), so overlapping segments return true.
 */
 inline bool closest_point(const Segment& _seg_a, const Segment& _seg_b,
                           Point* _clsst_pt = nullptr, double _t[2] = nullptr, double * _dist_sq = nullptr)
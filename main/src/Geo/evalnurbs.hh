@@ -2,6 +2,7 @@
 #include "combinations.hh"
 
 #include <algorithm>
+#include <cstddef>
 #include <vector>
 
 namespace Geo {
@@ -108,6 +109,144 @@ public:
   }
 };
 
+/*! Evaluation of a NUB curve and of its derivatives in many sorted
+    parameters. Knots follow the Nub convention. The knot span is found
+    moving forward from the span of the previous parameter and the basis
+    functions are computed with the triangular de Boor - Cox scheme on
+    blocks of parameters (SoA, one lane per parameter). The derivative k
+    combines the basis of degree deg - k of the same triangle with the
+    control points of the derivative curve, computed in init().
+*/
+template <size_t DimT, typename Par = double> class NubBatch
+{
+  enum { MAX_DEG = 25, LANES = 8 };
+  std::vector<Par> m_kn;
+  // Control points of the derivative k, coordinate d of the point i is
+  // m_pts[k][d * (m_np - k) + i].
+  std::vector<std::vector<Par>> m_pts;
+  size_t m_np, m_deg;
+
+public:
+  NubBatch() : m_np(0), m_deg(0) {}
+
+  template <typename Pt>
+  bool init(const std::vector<Pt> & ctrp, const std::vector<Par> & kn)
+  {
+    m_np = 0;
+    if (kn.size() < ctrp.size() || ctrp.empty())
+      return false;
+    const size_t deg = kn.size() - ctrp.size() + 1;
+    if (ctrp.size() < deg || deg > MAX_DEG)
+      return false;
+    m_np = ctrp.size();
+    m_deg = deg;
+    m_kn = kn;
+    m_pts.resize(m_deg + 1);
+    m_pts[0].resize(DimT * m_np);
+    for (size_t i = 0; i < m_np; ++i)
+      for (size_t d = 0; d < DimT; ++d)
+        m_pts[0][d * m_np + i] = ctrp[i][d];
+    // P(k)i = (deg - k + 1) * (P(k-1)i+1 - P(k-1)i) / (u(i+deg+1) - u(i+k))
+    // with u(j) = kn[j - 1]. Zero length supports give null points.
+    for (size_t k = 1; k <= m_deg; ++k)
+    {
+      const size_t np_k = m_np - k;
+      m_pts[k].resize(DimT * np_k);
+      for (size_t i = 0; i < np_k; ++i)
+      {
+        const Par den = m_kn[i + m_deg] - m_kn[i + k - 1];
+        const Par coe = den > 0 ? Par(m_deg - k + 1) / den : Par(0);
+        for (size_t d = 0; d < DimT; ++d)
+        {
+          const Par * prev = m_pts[k - 1].data() + d * (np_k + 1) + i;
+          m_pts[k][d * np_k + i] = coe * (prev[1] - prev[0]);
+        }
+      }
+    }
+    return true;
+  }
+
+  size_t degree() const { return m_deg; }
+
+  /*! Evaluates in the non decreasing parameters t[0 ... n - 1] the curve
+      and its derivatives up to der_nmbr. The coordinate d of the derivative
+      k in t[j] is written in res[(k * DimT + d) * n + j]. Spans are chosen
+      as Nub::eval without _right.
+  */
+  bool eval(const Par * t, size_t n, Par * res, size_t der_nmbr = 0) const
+  {
+    if (m_np == 0)
+      return false;
+    const size_t der_max = std::min(der_nmbr, m_deg);
+    for (size_t k = der_max + 1; k <= der_nmbr; ++k)
+      std::fill_n(res + k * DimT * n, DimT * n, Par(0));
+    if (n == 0)
+      return true;
+    // Span s has knots kn[s - 1], kn[s] and points s - deg ... s.
+    const size_t last_span = m_np - 1;
+    size_t s = std::lower_bound(m_kn.begin() + m_deg,
+                                m_kn.begin() + last_span, t[0]) - m_kn.begin();
+    Par tl[LANES], N[MAX_DEG + 1][LANES];
+    Par left[MAX_DEG + 1][LANES], right[MAX_DEG + 1][LANES], saved[LANES];
+    size_t sl[LANES];
+    for (size_t beg = 0; beg < n; beg += LANES)
+    {
+      const size_t lanes = std::min<size_t>(LANES, n - beg);
+      for (size_t l = 0; l < LANES; ++l)
+      {
+        // Unused lanes repeat the last parameter.
+        tl[l] = t[beg + std::min(l, lanes - 1)];
+        while (s < last_span && m_kn[s] < tl[l])
+          ++s;
+        sl[l] = s;
+        N[0][l] = 1;
+      }
+      for (size_t k = 0; k <= m_deg; ++k)
+      {
+        if (k > 0)
+        {
+          for (size_t l = 0; l < LANES; ++l)
+          {
+            left[k][l] = tl[l] - m_kn[sl[l] - k];
+            right[k][l] = m_kn[sl[l] + k - 1] - tl[l];
+            saved[l] = 0;
+          }
+          for (size_t r = 0; r < k; ++r)
+          {
+            for (size_t l = 0; l < LANES; ++l)
+            {
+              const Par temp = N[r][l] / (right[r + 1][l] + left[k - r][l]);
+              N[r][l] = saved[l] + right[r + 1][l] * temp;
+              saved[l] = left[k - r][l] * temp;
+            }
+          }
+          for (size_t l = 0; l < LANES; ++l)
+            N[k][l] = saved[l];
+        }
+        // Basis of degree k gives the derivative deg - k.
+        if (k + der_max < m_deg)
+          continue;
+        const size_t der = m_deg - k;
+        const size_t np_k = m_np - der;
+        for (size_t d = 0; d < DimT; ++d)
+        {
+          const Par * pts = m_pts[der].data() + d * np_k;
+          Par * out = res + (der * DimT + d) * n + beg;
+          for (size_t l = 0; l < lanes; ++l)
+          {
+            const Par * pt_l = pts + sl[l] - m_deg;
+            Par val = 0;
+            for (size_t r = 0; r <= k; ++r)
+              val += N[r][l] * pt_l[r];
+            out[l] = val;
+          }
+        }
+      }
+    }
+    return true;
+  }
+};
+
 template <typename Pt, typename Par, typename Res = Pt> class nub_cv
 {
   std::vector<Pt>   m_ctrp;
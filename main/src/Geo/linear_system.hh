@@ -1,15 +1,273 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <limits>
+
 namespace Geo 
 {
-// Solution of a 3x3 linear system
-bool invert_3x3(const double A[3][3], double iA[3][3]);
 
-bool solve_3x3(const double A[3][3], double x[3], const double b[3]);
+enum class LinearSolver { Cramer, LDLT };
+
+namespace LinearSystem {
+
+// Determinant below this value means singular system (Cramer).
+constexpr double DET_TOL = 1.e-12;
+
+constexpr double abs(const double _x) { return _x < 0 ? -_x : _x; }
+
+template <size_t N>
+constexpr double det(const double (&_A)[N][N])
+{
+  static_assert(N == 2 || N == 3, "Cramer rule only for 2x2 and 3x3");
+  if constexpr (N == 2)
+    return _A[0][0] * _A[1][1] - _A[1][0] * _A[0][1];
+  else
+  {
+    return
+      _A[0][0] * (_A[2][2] * _A[1][1] - _A[2][1] * _A[1][2]) -
+      _A[1][0] * (_A[2][2] * _A[0][1] - _A[2][1] * _A[0][2]) +
+      _A[2][0] * (_A[1][2] * _A[0][1] - _A[1][1] * _A[0][2]);
+  }
+}
+
+// L * D * L^T decomposition of a symmetric matrix. Only the lower
+// triangle of _A is used. Fails on a pivot small compared to the diagonal.
+template <size_t N>
+constexpr bool ldlt(const double (&_A)[N][N], double (&_L)[N][N], double (&_D)[N])
+{
+  for (size_t j = 0; j < N; ++j)
+  {
+    double d = _A[j][j];
+    for (size_t k = 0; k < j; ++k)
+      d -= _L[j][k] * _L[j][k] * _D[k];
+    if (abs(d) <= DET_TOL * abs(_A[j][j]) || d == 0)
+      return false;
+    _D[j] = d;
+    _L[j][j] = 1;
+    for (size_t i = j + 1; i < N; ++i)
+    {
+      double l = _A[i][j];
+      for (size_t k = 0; k < j; ++k)
+        l -= _L[i][k] * _L[j][k] * _D[k];
+      _L[i][j] = l / d;
+    }
+  }
+  return true;
+}
+
+constexpr void swap(double& _a, double& _b)
+{
+  const double tmp = _a;
+  _a = _b;
+  _b = tmp;
+}
+
+// L * D * L^T decomposition in place of a symmetric positive semidefinite
+// matrix with diagonal pivoting, as Eigen::LDLT does. At step k the row
+// _transp[k] is swapped with k. Null pivots leave their column unscaled.
+template <size_t N>
+constexpr void ldlt_pivot(double (&_A)[N][N], size_t (&_transp)[N])
+{
+  for (size_t k = 0; k < N; ++k)
+  {
+    size_t p = k;
+    for (size_t i = k + 1; i < N; ++i)
+    {
+      if (abs(_A[i][i]) > abs(_A[p][p]))
+        p = i;
+    }
+    _transp[k] = p;
+    if (p != k)
+    {
+      for (size_t j = 0; j < k; ++j)
+        swap(_A[k][j], _A[p][j]);
+      for (size_t i = p + 1; i < N; ++i)
+        swap(_A[i][k], _A[i][p]);
+      swap(_A[k][k], _A[p][p]);
+      for (size_t i = k + 1; i < p; ++i)
+        swap(_A[i][k], _A[p][i]);
+    }
+    if (k > 0)
+    {
+      double temp[N] = {};
+      for (size_t j = 0; j < k; ++j)
+        temp[j] = _A[j][j] * _A[k][j];
+      double s = _A[k][0] * temp[0];
+      for (size_t j = 1; j < k; ++j)
+        s += _A[k][j] * temp[j];
+      _A[k][k] -= s;
+      for (size_t i = k + 1; i < N; ++i)
+      {
+        s = _A[i][0] * temp[0];
+        for (size_t j = 1; j < k; ++j)
+          s += _A[i][j] * temp[j];
+        _A[i][k] -= s;
+      }
+    }
+    const double d = _A[k][k];
+    if (k == 0 && d == 0)
+    {
+      // Null matrix.
+      for (size_t j = 0; j < N; ++j)
+        _transp[j] = j;
+      return;
+    }
+    if (d != 0)
+    {
+      for (size_t i = k + 1; i < N; ++i)
+        _A[i][k] /= d;
+    }
+  }
+}
+
+}//namespace LinearSystem
+
+// Inverse of a 2x2 or 3x3 matrix with the cofactors.
+template <size_t N>
+constexpr bool invert(const double (&_A)[N][N], double (&_iA)[N][N])
+{
+  const double det = LinearSystem::det(_A);
+  if (LinearSystem::abs(det) < LinearSystem::DET_TOL)
+    return false;
+  if constexpr (N == 2)
+  {
+    _iA[0][0] =  _A[1][1] / det;
+    _iA[0][1] = -_A[0][1] / det;
+    _iA[1][0] = -_A[1][0] / det;
+    _iA[1][1] =  _A[0][0] / det;
+  }
+  else
+  {
+    _iA[0][0] =  (_A[2][2] * _A[1][1] - _A[2][1] * _A[1][2]) / det;
+    _iA[0][1] = -(_A[2][2] * _A[0][1] - _A[2][1] * _A[0][2]) / det;
+    _iA[0][2] =  (_A[1][2] * _A[0][1] - _A[1][1] * _A[0][2]) / det;
+
+    _iA[1][0] = -(_A[2][2] * _A[1][0] - _A[2][0] * _A[1][2]) / det;
+    _iA[1][1] =  (_A[2][2] * _A[0][0] - _A[2][0] * _A[0][2]) / det;
+    _iA[1][2] = -(_A[1][2] * _A[0][0] - _A[1][0] * _A[0][2]) / det;
+
+    _iA[2][0] =  (_A[2][1] * _A[1][0] - _A[2][0] * _A[1][1]) / det;
+    _iA[2][1] = -(_A[2][1] * _A[0][0] - _A[2][0] * _A[0][1]) / det;
+    _iA[2][2] =  (_A[1][1] * _A[0][0] - _A[1][0] * _A[0][1]) / det;
+  }
+  return true;
+}
+
+/*! Solves _A * _x = _b. Cramer works on any 2x2 or 3x3 matrix,
+    LDLT on symmetric matrices of any size.
+*/
+template <size_t N, LinearSolver solverT = LinearSolver::Cramer>
+constexpr bool solve(const double (&_A)[N][N], double (&_x)[N], const double (&_b)[N])
+{
+  if constexpr (solverT == LinearSolver::Cramer)
+  {
+    double iA[N][N] = {};
+    if (!invert(_A, iA))
+      return false;
+    for (size_t i = 0; i < N; ++i)
+    {
+      _x[i] = 0;
+      for (size_t j = 0; j < N; ++j)
+        _x[i] += iA[i][j] * _b[j];
+    }
+  }
+  else
+  {
+    double L[N][N] = {}, D[N] = {};
+    if (!LinearSystem::ldlt(_A, L, D))
+      return false;
+    for (size_t i = 0; i < N; ++i)
+    {
+      _x[i] = _b[i];
+      for (size_t k = 0; k < i; ++k)
+        _x[i] -= L[i][k] * _x[k];
+    }
+    for (size_t i = N; i-- > 0;)
+    {
+      _x[i] /= D[i];
+      for (size_t k = i + 1; k < N; ++k)
+        _x[i] -= L[k][i] * _x[k];
+    }
+  }
+  return true;
+}
+
+/*! Least squares solution of _x[0] * _cols[0] + ... = _b with the normal
+    equations. The pivoted LDLT gives zero components on null pivots, so
+    parallel or degenerate columns still give a solution. Operations are
+    done in the same order as the Eigen::LDLT solve on dynamic matrices
+    that the intersection code was tuned with, to get the same bits.
+*/
+template <size_t M, class VectorT>
+constexpr void least_squares(const VectorT (&_cols)[M], const VectorT& _b,
+  double (&_x)[M])
+{
+  constexpr size_t N = std::tuple_size<VectorT>::value;
+  double A[M][M] = {};
+  for (size_t i = 0; i < M; ++i)
+  {
+    for (size_t j = 0; j < M; ++j)
+    {
+      A[i][j] = _cols[i][0] * _cols[j][0];
+      for (size_t k = 1; k < N; ++k)
+        A[i][j] += _cols[i][k] * _cols[j][k];
+    }
+    _x[i] = _cols[i][0] * _b[0];
+    for (size_t k = 1; k < N; ++k)
+      _x[i] += _cols[i][k] * _b[k];
+  }
+  size_t transp[M] = {};
+  LinearSystem::ldlt_pivot(A, transp);
+  for (size_t k = 0; k < M; ++k)
+    LinearSystem::swap(_x[k], _x[transp[k]]);
+  for (size_t j = 0; j < M; ++j)
+  {
+    for (size_t i = j + 1; i < M; ++i)
+      _x[i] -= _x[j] * A[i][j];
+  }
+  for (size_t i = 0; i < M; ++i)
+  {
+    if (LinearSystem::abs(A[i][i]) > std::numeric_limits<double>::min())
+      _x[i] /= A[i][i];
+    else
+      _x[i] = 0;
+  }
+  for (size_t i = M - 1; i-- > 0;)
+  {
+    double s = A[i + 1][i] * _x[i + 1];
+    for (size_t j = i + 2; j < M; ++j)
+      s += A[j][i] * _x[j];
+    _x[i] -= s;
+  }
+  for (size_t k = M; k-- > 0;)
+    LinearSystem::swap(_x[k], _x[transp[k]]);
+}
 
 // Solution of a 3x3 linear system
-bool invert_2x2(const double A[2][2], double iA[2][2]);
+inline bool invert_3x3(const double A[3][3], double iA[3][3])
+{
+  return invert<3>(*reinterpret_cast<const double(*)[3][3]>(A),
+    *reinterpret_cast<double(*)[3][3]>(iA));
+}
+
+inline bool solve_3x3(const double A[3][3], double x[3], const double b[3])
+{
+  return solve<3>(*reinterpret_cast<const double(*)[3][3]>(A),
+    *reinterpret_cast<double(*)[3]>(x), *reinterpret_cast<const double(*)[3]>(b));
+}
 
-bool solve_2x2(const double A[2][2], double x[2], const double b[2]);
+// Solution of a 2x2 linear system
+inline bool invert_2x2(const double A[2][2], double iA[2][2])
+{
+  return invert<2>(*reinterpret_cast<const double(*)[2][2]>(A),
+    *reinterpret_cast<double(*)[2][2]>(iA));
+}
+
+inline bool solve_2x2(const double A[2][2], double x[2], const double b[2])
+{
+  return solve<2>(*reinterpret_cast<const double(*)[2][2]>(A),
+    *reinterpret_cast<double(*)[2]>(x), *reinterpret_cast<const double(*)[2]>(b));
+}
 
-}// namespace Geo
\ No newline at end of file
+}// namespace Geo
@@ -1,91 +1,177 @@
 
 #include "linking_number.hh"
+#include "range.hh"
+#include "Utils/parallel.hh"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
 
 namespace Geo
 {
 namespace {
+
+// Solid angle subtended by the segments _p[0] and _p[1] (Klenin and
+// Langowski): sum of the angles of the spherical quadrilateral seen from
+// the segments end points, with the sign of the pair orientation.
 double contribution(const Geo::VectorD3 _p[2][2])
 {
-  Geo::VectorD3 T[2];
-  Geo::VectorD2 len;
-  for (auto i = 0; i < 2; ++i)
+  const Geo::VectorD3 r[4] = {
+    _p[1][0] - _p[0][0],    // r13
+    _p[1][1] - _p[0][0],    // r14
+    _p[1][1] - _p[0][1],    // r24
+    _p[1][0] - _p[0][1] };  // r23
+  Geo::VectorD3 n[4];
+  for (size_t i = 0; i < 4; ++i)
   {
-    T[i] = _p[i][1] - _p[i][0];
-    len[i] = Geo::length(T[i]);
-    T[i] /= len[i];
+    n[i] = r[i] % r[(i + 1) % 4];
+    auto len = Geo::length(n[i]);
+    if (len == 0)
+      return 0;
+    n[i] /= len;
   }
-  auto dp = _p[0][0] - _p[1][0];
-  const double SAMPLES = 8;
-  Geo::VectorD2 dt = len / SAMPLES;
-  Geo::VectorD2 u;
-  //auto coeff = (T[0] % T[1]) * dp * dt[0] * dt[1];
-  double integr_sum = 0;
-  double coeff = (T[0] % T[1]) * dp * dt[0] * dt[1];
-  for (u[0] = dt[0] / 2.; u[0] < len[0]; u[0] += dt[0])
-    for (u[1] = dt[1] / 2.; u[1] < len[1]; u[1] += dt[1])
-    {
-      auto v = dp + T[0] * u[0] - T[1] * u[1];
-      auto vlen_sq = Geo::length_square(v);
-      integr_sum += coeff / (vlen_sq * sqrt(vlen_sq));
-    }
-  return integr_sum /* * coeff*/;
+  double omega = 0;
+  for (size_t i = 0; i < 4; ++i)
+    omega += std::asin(std::clamp(n[i] * n[(i + 1) % 4], -1., 1.));
+  const auto orient = ((_p[1][1] - _p[1][0]) % (_p[0][1] - _p[0][0])) * r[0];
+  return orient > 0 ? omega : -omega;
 }
 
-long double contribution1(const Geo::VectorD3 _p[2][2])
+// Far field approximation of the contribution of two groups of segments.
+double far_contribution(
+  const Geo::VectorD3& _chord0, const Geo::VectorD3& _centre0,
+  const Geo::VectorD3& _chord1, const Geo::VectorD3& _centre1)
 {
-  Geo::VectorD3 T[2];
-  for (auto i : { 0, 1 })
-    T[i] = _p[i][1] - _p[i][0];
-  auto dp = _p[0][0] - _p[1][0];
-  const double SAMPLES = 4096;
-  double dt = 1. / SAMPLES;
-  Geo::VectorD2 u;
-  long double integr_sum = 0;
-  double coeff = (T[0] % T[1]) * dp * dt * dt;
-  for (u[0] = dt / 2.; u[0] < 1.; u[0] += dt)
-    for (u[1] = dt / 2.; u[1] < 1.; u[1] += dt)
-    {
-      auto v = dp + T[0] * u[0] - T[1] * u[1];
-      long double vlen_sq = 0;
-      for (auto c : v)
-        vlen_sq += c * c;
-      integr_sum += 1. / (vlen_sq * sqrt(vlen_sq));
-    }
-  return coeff * integr_sum;
+  const auto d = _centre1 - _centre0;
+  const auto len_sq = Geo::length_square(d);
+  return ((_chord1 % _chord0) * d) / (len_sq * std::sqrt(len_sq));
 }
 
-} // namespace
+// Consecutive segments [beg_, end_[ of a loop, segment i goes from point i
+// to point i + 1 (modulo the point number).
+struct Cluster
+{
+  size_t beg_, end_;
+  Geo::VectorD3 centre_, chord_;
+  double radius_;
+  size_t children_[2];
+};
 
+const size_t LEAF_SIZE = 8;
+const size_t NO_CHILD = SIZE_MAX;
 
-int LinkingNumber::compute(
+size_t build_clusters(const std::vector<Geo::VectorD3>& _loop,
+  size_t _beg, size_t _end, std::vector<Cluster>& _clusters)
+{
+  const auto idx = _clusters.size();
+  _clusters.emplace_back();
+  Geo::Range<3> box;
+  for (size_t i = _beg; i <= _end; ++i)
+    box += _loop[i % _loop.size()];
+  auto& cl = _clusters.back();
+  cl.beg_ = _beg;
+  cl.end_ = _end;
+  cl.centre_ = (box[0] + box[1]) / 2.;
+  cl.radius_ = Geo::length(box[1] - box[0]) / 2.;
+  cl.chord_ = _loop[_end % _loop.size()] - _loop[_beg];
+  cl.children_[0] = cl.children_[1] = NO_CHILD;
+  if (_end - _beg > LEAF_SIZE)
+  {
+    const auto mid = (_beg + _end) / 2;
+    auto child0 = build_clusters(_loop, _beg, mid, _clusters);
+    auto child1 = build_clusters(_loop, mid, _end, _clusters);
+    _clusters[idx].children_[0] = child0;
+    _clusters[idx].children_[1] = child1;
+  }
+  return idx;
+}
+
+} // namespace
+
+double LinkingNumber::integral(
   const std::vector<Geo::VectorD3>& _loop0,
-  const std::vector<Geo::VectorD3>& _loop1)
+  const std::vector<Geo::VectorD3>& _loop1,
+  const double _theta)
 {
   if (_loop0.size() < 3 || _loop1.size() < 3)
     return 0;
-  long double link_numb = 0;
-  Geo::VectorD3 p[2][2];
-  p[0][0] = _loop0.back();
-  for (const auto& p1 : _loop0)
+  const std::vector<Geo::VectorD3>* loops[2] = { &_loop0, &_loop1 };
+  std::vector<Cluster> clusters[2];
+  for (size_t i = 0; i < 2; ++i)
   {
-    p[0][1] = p1;
-    p[1][0] = _loop1.back();
-    long double cc = 0;
-    for (const auto& q1 : _loop1)
+    clusters[i].reserve(4 * loops[i]->size() / LEAF_SIZE + 1);
+    build_clusters(*loops[i], 0, loops[i]->size(), clusters[i]);
+  }
+
+  // Dual tree traversal: far couples are added to the result,
+  // near leaf couples are collected to be evaluated in parallel.
+  long double far_sum = 0;
+  std::vector<std::array<size_t, 2>> near_couples;
+  std::vector<std::array<size_t, 2>> stack(1, { 0, 0 });
+  while (!stack.empty())
+  {
+    const auto couple = stack.back();
+    stack.pop_back();
+    const Cluster* cl[2] = {
+      &clusters[0][couple[0]], &clusters[1][couple[1]] };
+    const auto dist = Geo::length(cl[1]->centre_ - cl[0]->centre_);
+    if (cl[0]->radius_ + cl[1]->radius_ < _theta * dist)
     {
-      p[1][1] = q1;
-      auto cc_l = contribution1(p);
-      std::cout << " " << cc_l;
-      cc += cc_l;
-      p[1][0] = p[1][1];
+      far_sum += far_contribution(
+        cl[0]->chord_, cl[0]->centre_, cl[1]->chord_, cl[1]->centre_);
+      continue;
+    }
+    const bool leaf[2] = {
+      cl[0]->children_[0] == NO_CHILD, cl[1]->children_[0] == NO_CHILD };
+    if (leaf[0] && leaf[1])
+    {
+      near_couples.push_back(couple);
+      continue;
+    }
+    // Splits the biggest cluster.
+    const size_t split = leaf[0] ||
+      (!leaf[1] && cl[1]->radius_ > cl[0]->radius_) ? 1 : 0;
+    for (auto child : cl[split]->children_)
+    {
+      auto new_couple = couple;
+      new_couple[split] = child;
+      stack.push_back(new_couple);
     }
-    std::cout << std::endl << cc << std::endl;
-    link_numb += cc;
-    p[0][0] = p[0][1];
   }
-  link_numb /= 4 * M_PI;
-  std::cout << "link_numb = " << link_numb << std::endl;
-  return static_cast<int>(std::round(link_numb));
+
+  std::vector<double> near_vals(near_couples.size());
+  Utils::parallel_for(near_couples.size(), [&](size_t _i)
+  {
+    const Cluster* cl[2] = {
+      &clusters[0][near_couples[_i][0]], &clusters[1][near_couples[_i][1]] };
+    double sum = 0;
+    Geo::VectorD3 p[2][2];
+    for (size_t i = cl[0]->beg_; i < cl[0]->end_; ++i)
+    {
+      p[0][0] = _loop0[i];
+      p[0][1] = _loop0[(i + 1) % _loop0.size()];
+      for (size_t j = cl[1]->beg_; j < cl[1]->end_; ++j)
+      {
+        p[1][0] = _loop1[j];
+        p[1][1] = _loop1[(j + 1) % _loop1.size()];
+        sum += contribution(p);
+      }
+    }
+    near_vals[_i] = sum;
+  }, 1);
+
+  // Ordered sum to have the same result regardless of the threads.
+  long double link_numb = far_sum;
+  for (auto val : near_vals)
+    link_numb += val;
+  return static_cast<double>(link_numb / (4 * M_PI));
+}
+
+int LinkingNumber::compute(
+  const std::vector<Geo::VectorD3>& _loop0,
+  const std::vector<Geo::VectorD3>& _loop1)
+{
+  return static_cast<int>(std::round(integral(_loop0, _loop1)));
 }
 
 } // namespace Geo
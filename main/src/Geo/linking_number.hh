@@ -13,6 +13,18 @@ struct LinkingNumber
   static int compute(
     const std::vector<Geo::VectorD3>& _loop0, 
     const std::vector<Geo::VectorD3>& _loop1);
+
+  /*! Gauss linking integral of two closed polygons divided by 4 pi.
+      Near segment pairs use the exact solid angle of the quadrilateral
+      of their end points. Far clusters of consecutive segments are
+      approximated by their chords placed at the cluster centres when
+      (radius0 + radius1) < _theta * distance. _theta = 0 gives the exact
+      value with n * m solid angles.
+  */
+  static double integral(
+    const std::vector<Geo::VectorD3>& _loop0,
+    const std::vector<Geo::VectorD3>& _loop1,
+    const double _theta = 0.25);
 };
 
 
@@ -2,6 +2,12 @@
 
 #include "Geo/pow.hh"
 #include "Geo/linear_system.hh"
+#include "Geo/vector.hh"
+#include "Utils/parallel.hh"
+
+#include <algorithm>
+#include <random>
+#include <vector>
 
 namespace Geo {
 
@@ -13,10 +19,16 @@ struct MinSphereT
   MinSphereT(const Point* _pts, const size_t _pts_num);
   Point centre_;
   double radius_ = -1.;
+  // True if _pt is in the sphere enlarged by a tolerance relative to the
+  // radius, which covers the rounding of the centre computation.
   bool contains(const Point& _pt) const
   {
-    return radius_ >= 0 && length_square(_pt - centre_) <= (1 + Geo::sq(radius_)) * 1e-15;
+    return radius_ >= 0 &&
+      length_square(_pt - centre_) <= Geo::sq(radius_ * (1 + REL_TOL)) + ABS_TOL_SQ;
   }
+  static constexpr double REL_TOL = 1e-10;
+  // Keeps coincident points together when the radius is 0.
+  static constexpr double ABS_TOL_SQ = 1e-30;
 };
 
 // Constructor from n points
@@ -72,66 +84,106 @@ MinSphereT<Point>::MinSphereT(const Point* _pts, const size_t _pts_num)
   }
 }
 
+namespace MinBall {
+
+// Smallest sphere with the _bnd_num points of _bnd on its boundary. If
+// they are degenerate (e.g. 4 coplanar points) it is the smallest sphere
+// through all but one of them that contains them all.
 template <class Point>
-MinSphereT<Point> min_ball(const Point* _pts, const size_t _pts_num)
+MinSphereT<Point> boundary_sphere(const Point* _bnd, const size_t _bnd_num)
 {
-  // Finds the minmum sphere containitn N 3d points.
-  Point pts_ball[4];
-  size_t pts_ball_num = 0;
-  enum class Step {one, two, three};
-  std::vector<Step> step_per_depth(_pts_num + 1);
-  step_per_depth[_pts_num] = Step::one;
-  MinSphereT<Point> sphere;
-  for (size_t cur_pts_num = _pts_num; cur_pts_num <= _pts_num; )
+  MinSphereT<Point> sphere(_bnd, _bnd_num);
+  if (sphere.radius_ >= 0 || _bnd_num < 3)
+    return sphere;
+  for (size_t skip = 0; skip < _bnd_num; ++skip)
   {
-    switch(step_per_depth[cur_pts_num])
+    Point sub[3];
+    for (size_t i = 0, j = 0; i < _bnd_num; ++i)
     {
-    case Step::one:
-      if (pts_ball_num == 4 || cur_pts_num == 0)
-      {
-        sphere = MinSphereT<Point>(pts_ball, pts_ball_num);
-        // We have the sphere for the first cur_pts_num points.
-        // Let's consider one more point.
-        cur_pts_num++;
-      }
-      else
-      {
-        // Asks for the sphere including the first cur_pts_num - 1
-        // points, and after go to step 2.
-        step_per_depth[cur_pts_num] = Step::two;
-        step_per_depth[--cur_pts_num] = Step::one;
-      }
-      break;
-
-    case Step::two:
-      // Current sphere (*this) is the min ball of cur_pts_num - 1 points.
-      // Let's check if it contains also the current point.
-      if (sphere.contains(_pts[cur_pts_num - 1]))
-        // We have the sphe refor the first cur_pts_num points.
-        // Let's consider one more point.
-        cur_pts_num++;
-      else
-      {
-        // Current point must be on the bounding sphere.
-        // Put it in the list of points where the sphere must lie
-        // and compute again the sphere for the first cur_pts_num - 1
-        // points.
-        pts_ball[pts_ball_num++] = _pts[cur_pts_num - 1];
-        step_per_depth[cur_pts_num] = Step::three;
-        step_per_depth[--cur_pts_num] = Step::one;
-      }
-      break;
-
-    case Step::three:
-      // Remove the point on sphere added in Step::two
-      pts_ball_num--;
-      // We have the sphere for the first cur_pts_num points.
-      // Let's consider one more point.
-      ++cur_pts_num;
-      break;
+      if (i != skip)
+        sub[j++] = _bnd[i];
     }
+    auto cand = boundary_sphere(sub, _bnd_num - 1);
+    if (cand.radius_ >= 0 && cand.contains(_bnd[skip]) &&
+        (sphere.radius_ < 0 || cand.radius_ < sphere.radius_))
+    {
+      sphere = cand;
+    }
+  }
+  return sphere;
+}
+
+// Move to front Welzl: min ball of _pts[0, _end[ with the _bnd_num points
+// of _bnd on the boundary. Points that fall outside are moved to the
+// front of _pts, so that later calls find them early. The recursion
+// depth is at most 4.
+template <class Point>
+MinSphereT<Point> move_to_front(
+  Point* _pts, const size_t _end, Point* _bnd, const size_t _bnd_num)
+{
+  auto sphere = boundary_sphere(_bnd, _bnd_num);
+  if (_bnd_num == 4)
+    return sphere;
+  for (size_t i = 0; i < _end; ++i)
+  {
+    if (sphere.contains(_pts[i]))
+      continue;
+    _bnd[_bnd_num] = _pts[i];
+    sphere = move_to_front(_pts, i, _bnd, _bnd_num + 1);
+    std::rotate(_pts, _pts + i, _pts + i + 1);
   }
   return sphere;
 }
 
+}//namespace MinBall
+
+/*! Minimum sphere of _pts_num points with the move to front Welzl
+    algorithm. The points are copied in _buffer, of at least _pts_num
+    points, that is reordered; callers of many balls can reuse it.
+    The copy is shuffled with a seed that depends only on the number of
+    points, so the result does not change between runs.
+*/
+template <class Point>
+MinSphereT<Point> min_ball(const Point* _pts, const size_t _pts_num,
+  Point* _buffer)
+{
+  std::copy(_pts, _pts + _pts_num, _buffer);
+  std::minstd_rand gen(static_cast<unsigned>(_pts_num) + 1);
+  std::shuffle(_buffer, _buffer + _pts_num, gen);
+  Point bnd[4];
+  return MinBall::move_to_front(_buffer, _pts_num, bnd, 0);
+}
+
+template <class Point>
+MinSphereT<Point> min_ball(const Point* _pts, const size_t _pts_num)
+{
+  const size_t STACK_SIZE = 64;
+  if (_pts_num <= STACK_SIZE)
+  {
+    Point buffer[STACK_SIZE];
+    return min_ball(_pts, _pts_num, buffer);
+  }
+  std::vector<Point> buffer(_pts_num);
+  return min_ball(_pts, _pts_num, buffer.data());
+}
+
+/*! Min balls of many clusters stored in CSR form: the points of cluster i
+    are _pts[_offsets[i], _offsets[i + 1][. _offsets has _cluster_num + 1
+    entries and _spheres _cluster_num. Clusters are solved in parallel,
+    each thread reuses its buffer of points.
+*/
+template <class Point>
+void min_balls(const Point* _pts, const size_t* _offsets, const size_t _cluster_num,
+  MinSphereT<Point>* _spheres)
+{
+  Utils::parallel_for(_cluster_num, [_pts, _offsets, _spheres](size_t _i)
+  {
+    thread_local std::vector<Point> buffer;
+    const auto pts_num = _offsets[_i + 1] - _offsets[_i];
+    if (buffer.size() < pts_num)
+      buffer.resize(pts_num);
+    _spheres[_i] = min_ball(_pts + _offsets[_i], pts_num, buffer.data());
+  });
+}
+
 } // namespace Geo
@@ -1,6 +1,10 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
 #include <set>
 
 namespace Geo {
@@ -8,4 +12,286 @@ namespace Geo {
 template<size_t DegT>
 std::multiset<double> polygon_roots(const std::array<double, DegT + 1>& _poly);
 
+/*! Distinct real roots of a polynomial of degree up to DegT in increasing
+    order, stored inline.
+*/
+template<size_t DegT>
+struct PolynomialRoots
+{
+  const double* begin() const { return vals_.data(); }
+  const double* end() const { return vals_.data() + size_; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  double operator[](size_t _i) const { return vals_[_i]; }
+  void push_back(double _val) { vals_[size_++] = _val; }
+
+private:
+  std::array<double, DegT> vals_;
+  size_t size_ = 0;
+};
+
+namespace PolynomialSolver {
+
+// Number of polynomials solved together by the batched solver.
+constexpr size_t LANES = 8;
+constexpr size_t MAX_ITER = 64;
+
+// Horner evaluation of the polynomials, of their derivatives and of the
+// polynomials with absolute coefficients in |x|, bound of the rounding error.
+template<size_t DegT, size_t LanesT>
+inline void evaluate(const double(&_coef)[DegT + 1][LanesT],
+  const double(&_x)[LanesT], double(&_f)[LanesT], double(&_df)[LanesT],
+  double(&_f_abs)[LanesT])
+{
+  for (size_t k = 0; k < LanesT; ++k)
+  {
+    _f[k] = _coef[DegT][k];
+    _df[k] = 0;
+    _f_abs[k] = std::abs(_coef[DegT][k]);
+  }
+  for (size_t i = DegT; i-- > 0;)
+  {
+    for (size_t k = 0; k < LanesT; ++k)
+    {
+      _df[k] = _df[k] * _x[k] + _f[k];
+      _f[k] = _f[k] * _x[k] + _coef[i][k];
+      _f_abs[k] = _f_abs[k] * std::abs(_x[k]) + std::abs(_coef[i][k]);
+    }
+  }
+}
+
+/*! Real roots of LanesT polynomials with non zero leading coefficient.
+    _coef[i][k] is the coefficient of x^i of the polynomial k.
+    Roots are isolated between the roots of the derivative and refined
+    with Newton iterations safeguarded by bisection, in lockstep on all
+    the lanes.
+*/
+template<size_t DegT, size_t LanesT>
+void solve_block(const double(&_coef)[DegT + 1][LanesT],
+  double(&_roots)[DegT][LanesT], size_t(&_count)[LanesT])
+{
+  static_assert(DegT > 0, "Constant polynomial");
+  if constexpr (DegT == 1)
+  {
+    for (size_t k = 0; k < LanesT; ++k)
+    {
+      _roots[0][k] = -_coef[0][k] / _coef[1][k];
+      _count[k] = 1;
+    }
+  }
+  else if constexpr (DegT == 2)
+  {
+    const auto eps = std::numeric_limits<double>::epsilon();
+    for (size_t k = 0; k < LanesT; ++k)
+    {
+      const double a = _coef[2][k], b = _coef[1][k], c = _coef[0][k];
+      const double disc = b * b - 4 * a * c;
+      // A discriminant under its rounding error is a double root.
+      const bool dbl = std::abs(disc) <= 4 * eps * (b * b + 4 * std::abs(a * c));
+      const double q = -0.5 * (b + std::copysign(std::sqrt(std::max(disc, 0.)), b));
+      double x0 = q / a, x1 = q == 0 ? x0 : c / q;
+      if (x1 < x0)
+        std::swap(x0, x1);
+      // + 0. turns -0 into 0.
+      _roots[0][k] = dbl ? -0.5 * b / a + 0. : x0;
+      _roots[1][k] = x1;
+      _count[k] = dbl ? 1 : (disc < 0 ? 0 : 2);
+    }
+  }
+  else
+  {
+    double deriv[DegT][LanesT], crit[DegT - 1][LanesT];
+    size_t crit_count[LanesT];
+    for (size_t i = 0; i < DegT; ++i)
+      for (size_t k = 0; k < LanesT; ++k)
+        deriv[i][k] = (i + 1) * _coef[i + 1][k];
+    solve_block<DegT - 1, LanesT>(deriv, crit, crit_count);
+    // Merges equal critical points.
+    for (size_t k = 0; k < LanesT; ++k)
+    {
+      size_t n = crit_count[k] > 0 ? 1 : 0;
+      for (size_t j = 1; j < crit_count[k]; ++j)
+      {
+        if (crit[j][k] > crit[n - 1][k])
+          crit[n++][k] = crit[j][k];
+      }
+      crit_count[k] = n;
+    }
+    const auto eps = std::numeric_limits<double>::epsilon();
+    // A critical point where f is under the rounding error of the
+    // evaluation is a multiple root. The polynomial is monotone between
+    // critical points, so there is no other root in the adjacent intervals.
+    int64_t crit_root[DegT - 1][LanesT];
+    for (size_t j = 0; j < DegT - 1; ++j)
+    {
+      double x[LanesT], f[LanesT], df[LanesT], f_abs[LanesT];
+      for (size_t k = 0; k < LanesT; ++k)
+        x[k] = j < crit_count[k] ? crit[j][k] : 0;
+      evaluate<DegT, LanesT>(_coef, x, f, df, f_abs);
+      for (size_t k = 0; k < LanesT; ++k)
+      {
+        crit_root[j][k] = j < crit_count[k] &&
+          std::abs(f[k]) <= 2 * DegT * eps * f_abs[k];
+      }
+    }
+
+    // Fujiwara bound, all roots are in [-bound, bound].
+    double bound[LanesT];
+    for (size_t k = 0; k < LanesT; ++k)
+    {
+      double max_ratio = std::abs(_coef[0][k] / (2 * _coef[DegT][k]));
+      max_ratio = std::pow(max_ratio, 1. / DegT);
+      for (size_t i = 1; i < DegT; ++i)
+      {
+        max_ratio = std::max(max_ratio, std::pow(
+          std::abs(_coef[i][k] / _coef[DegT][k]), 1. / (DegT - i)));
+      }
+      bound[k] = 2 * max_ratio;
+      _count[k] = 0;
+    }
+    for (size_t j = 0; j < DegT; ++j)
+    {
+      double lo[LanesT], hi[LanesT], x[LanesT];
+      double f_lo[LanesT], f_hi[LanesT], f[LanesT], df[LanesT], f_abs[LanesT];
+      // Integer masks as wide as the doubles let the lane loops vectorize.
+      int64_t active[LanesT], found[LanesT];
+      for (size_t k = 0; k < LanesT; ++k)
+      {
+        const bool valid = j <= crit_count[k];
+        lo[k] = j == 0 || !valid ? -bound[k] : crit[j - 1][k];
+        hi[k] = j == crit_count[k] || !valid ? bound[k] : crit[j][k];
+      }
+      evaluate<DegT, LanesT>(_coef, lo, f_lo, df, f_abs);
+      evaluate<DegT, LanesT>(_coef, hi, f_hi, df, f_abs);
+      bool any_active = false;
+      for (size_t k = 0; k < LanesT; ++k)
+      {
+        const bool valid = j <= crit_count[k];
+        const bool lo_root = valid && j > 0 && crit_root[j - 1][k];
+        const bool hi_root = valid && j < crit_count[k] && crit_root[j][k];
+        // A root on a critical point is assigned to the interval before.
+        if (hi_root)
+          _roots[_count[k]++][k] = hi[k] + 0.;
+        found[k] = active[k] = valid && !lo_root && !hi_root &&
+          f_lo[k] * f_hi[k] < 0;
+        any_active |= active[k] != 0;
+        // Out of the critical points the polynomial is monotone and
+        // convex or concave, Newton converges from the external end.
+        x[k] = j == 0 ? lo[k] : (j == crit_count[k] ? hi[k] :
+          0.5 * (lo[k] + hi[k]));
+      }
+      for (size_t iter = 0; any_active && iter < MAX_ITER; ++iter)
+      {
+        evaluate<DegT, LanesT>(_coef, x, f, df, f_abs);
+        any_active = false;
+        for (size_t k = 0; k < LanesT; ++k)
+        {
+          const int64_t same_side = (f[k] < 0) == (f_lo[k] < 0);
+          lo[k] = same_side ? x[k] : lo[k];
+          hi[k] = same_side ? hi[k] : x[k];
+          const double mid = 0.5 * (lo[k] + hi[k]);
+          double x_new = x[k] - f[k] / df[k];
+          x_new = (x_new > lo[k]) & (x_new < hi[k]) ? x_new : mid;
+          // Stops when f is under the rounding error of the evaluation.
+          const int64_t conv = (std::abs(f[k]) <= 2 * DegT * eps * f_abs[k]) |
+            (std::abs(x_new - x[k]) <= 4 * eps * std::abs(x[k])) |
+            (hi[k] - lo[k] <= eps * (std::abs(lo[k]) + std::abs(hi[k])));
+          active[k] = active[k] & !conv;
+          x[k] = active[k] ? x_new : x[k];
+        }
+        for (size_t k = 0; k < LanesT; ++k)
+          any_active |= active[k] != 0;
+      }
+      for (size_t k = 0; k < LanesT; ++k)
+      {
+        if (found[k])
+          _roots[_count[k]++][k] = x[k];
+      }
+    }
+  }
+}
+
+}//namespace PolynomialSolver
+
+/*! Distinct real roots of sum(_poly[i] * x^i), i = 0..DegT.
+    A multiple root is given once, with about 1/multiplicity of the digits.
+    No memory is allocated.
+*/
+template<size_t DegT>
+PolynomialRoots<DegT> polynomial_roots(const double* _poly)
+{
+  PolynomialRoots<DegT> res;
+  if constexpr (DegT > 0)
+  {
+    if (_poly[DegT] == 0)
+    {
+      for (auto root : polynomial_roots<DegT - 1>(_poly))
+        res.push_back(root);
+      return res;
+    }
+    double coef[DegT + 1][1], roots[DegT][1];
+    size_t count[1];
+    for (size_t i = 0; i <= DegT; ++i)
+      coef[i][0] = _poly[i];
+    PolynomialSolver::solve_block<DegT, 1>(coef, roots, count);
+    for (size_t i = 0; i < count[0]; ++i)
+      res.push_back(roots[i][0]);
+  }
+  return res;
+}
+
+template<size_t DegT>
+PolynomialRoots<DegT> polynomial_roots(const std::array<double, DegT + 1>& _poly)
+{
+  return polynomial_roots<DegT>(_poly.data());
+}
+
+/*! Real roots of _n polynomials of degree DegT in SoA layout.
+    _coeffs[i * _n + k] is the coefficient of x^i of the polynomial k,
+    the root j of the polynomial k is written in _roots[j * _n + k] and
+    the number of roots in _counts[k].
+*/
+template<size_t DegT>
+void polynomial_roots_batch(size_t _n, const double* _coeffs,
+  double* _roots, size_t* _counts)
+{
+  using PolynomialSolver::LANES;
+  double coef[DegT + 1][LANES], roots[DegT][LANES];
+  size_t count[LANES];
+  for (size_t beg = 0; beg < _n; beg += LANES)
+  {
+    const size_t lanes = std::min(LANES, _n - beg);
+    bool degenerate = false;
+    for (size_t k = 0; k < LANES; ++k)
+    {
+      // Unused lanes and lanes with lower degree get x^DegT.
+      const bool use = k < lanes && _coeffs[DegT * _n + beg + k] != 0;
+      degenerate |= k < lanes && !use;
+      for (size_t i = 0; i <= DegT; ++i)
+        coef[i][k] = use ? _coeffs[i * _n + beg + k] : (i == DegT ? 1 : 0);
+    }
+    PolynomialSolver::solve_block<DegT, LANES>(coef, roots, count);
+    for (size_t k = 0; k < lanes; ++k)
+    {
+      for (size_t j = 0; j < count[k]; ++j)
+        _roots[j * _n + beg + k] = roots[j][k];
+      _counts[beg + k] = count[k];
+    }
+    if (!degenerate)
+      continue;
+    for (size_t k = 0; k < lanes; ++k)
+    {
+      if (_coeffs[DegT * _n + beg + k] != 0)
+        continue;
+      std::array<double, DegT + 1> poly;
+      for (size_t i = 0; i <= DegT; ++i)
+        poly[i] = _coeffs[i * _n + beg + k];
+      auto res = polynomial_roots<DegT>(poly);
+      for (size_t j = 0; j < res.size(); ++j)
+        _roots[j * _n + beg + k] = res[j];
+      _counts[beg + k] = res.size();
+    }
+  }
+}
+
 } // namespace Geo
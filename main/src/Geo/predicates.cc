@@ -0,0 +1,318 @@
+
+#include "predicates.hh"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace Geo
+{
+namespace Predicates
+{
+namespace
+{
+
+// Half of the distance between 1 and the next double.
+const double EPS = DBL_EPSILON / 2;
+// Relative error bounds of the floating point determinants.
+const double ORIENT2D_BOUND = (3 + 16 * EPS) * EPS;
+const double ORIENT3D_BOUND = (7 + 56 * EPS) * EPS;
+
+// _a + _b == _x + _y exactly, with _x the rounded sum.
+void two_sum(double _a, double _b, double& _x, double& _y)
+{
+  _x = _a + _b;
+  const double b_virt = _x - _a;
+  const double a_virt = _x - b_virt;
+  _y = (_a - a_virt) + (_b - b_virt);
+}
+
+// _a * _b == _x + _y exactly, with _x the rounded product.
+void two_product(double _a, double _b, double& _x, double& _y)
+{
+  _x = _a * _b;
+  _y = std::fma(_a, _b, -_x);
+}
+
+// Exact value as sum of non overlapping components sorted by increasing
+// magnitude, without zeros. N is an upper bound of the component number,
+// so all the exact arithmetic stays on the stack.
+template <size_t N> struct Expansion
+{
+  double comp_[N];
+  size_t size_ = 0;
+
+  // Adds _b in place (Grow-Expansion of Shewchuk).
+  void grow(double _b)
+  {
+    double q = _b;
+    size_t n = 0;
+    for (size_t i = 0; i < size_; ++i)
+    {
+      double h;
+      two_sum(q, comp_[i], q, h);
+      if (h != 0)
+        comp_[n++] = h;
+    }
+    if (q != 0)
+      comp_[n++] = q;
+    size_ = n;
+  }
+
+  int sign() const
+  {
+    if (size_ == 0)
+      return 0;
+    return comp_[size_ - 1] > 0 ? 1 : -1;
+  }
+
+  // Operators as hidden friends, so that they do not hide the vector ones.
+  template <size_t M>
+  friend Expansion<N + M> operator+(const Expansion& _a, const Expansion<M>& _b)
+  {
+    Expansion<N + M> res;
+    for (size_t i = 0; i < _a.size_; ++i)
+      res.comp_[i] = _a.comp_[i];
+    res.size_ = _a.size_;
+    for (size_t i = 0; i < _b.size_; ++i)
+      res.grow(_b.comp_[i]);
+    return res;
+  }
+
+  template <size_t M>
+  friend Expansion<N + M> operator-(const Expansion& _a, Expansion<M> _b)
+  {
+    for (size_t i = 0; i < _b.size_; ++i)
+      _b.comp_[i] = -_b.comp_[i];
+    return _a + _b;
+  }
+
+  template <size_t M>
+  friend Expansion<2 * N * M> operator*(const Expansion& _a, const Expansion<M>& _b)
+  {
+    Expansion<2 * N * M> res;
+    for (size_t i = 0; i < _a.size_; ++i)
+    {
+      for (size_t j = 0; j < _b.size_; ++j)
+      {
+        double x, y;
+        two_product(_a.comp_[i], _b.comp_[j], x, y);
+        res.grow(y);
+        res.grow(x);
+      }
+    }
+    return res;
+  }
+};
+
+Expansion<2> difference(double _a, double _b)
+{
+  Expansion<2> res;
+  res.grow(_a);
+  res.grow(-_b);
+  return res;
+}
+
+int sign(double _val)
+{
+  return _val > 0 ? 1 : (_val < 0 ? -1 : 0);
+}
+
+int orient2d_exact(const VectorD2& _a, const VectorD2& _b, const VectorD2& _c)
+{
+  const auto acx = difference(_a[0], _c[0]);
+  const auto acy = difference(_a[1], _c[1]);
+  const auto bcx = difference(_b[0], _c[0]);
+  const auto bcy = difference(_b[1], _c[1]);
+  return (acx * bcy - acy * bcx).sign();
+}
+
+int orient3d_exact(const VectorD3& _a, const VectorD3& _b, const VectorD3& _c,
+  const VectorD3& _d)
+{
+  Expansion<2> u[3], v[3], w[3];
+  for (size_t i = 0; i < 3; ++i)
+  {
+    u[i] = difference(_b[i], _a[i]);
+    v[i] = difference(_c[i], _a[i]);
+    w[i] = difference(_d[i], _a[i]);
+  }
+  return (w[0] * (u[1] * v[2] - u[2] * v[1]) +
+    w[1] * (u[2] * v[0] - u[0] * v[2]) +
+    w[2] * (u[0] * v[1] - u[1] * v[0])).sign();
+}
+
+// Drops the coordinate _axis.
+VectorD2 project(const VectorD3& _pt, size_t _axis)
+{
+  return { _pt[(_axis + 1) % 3], _pt[(_axis + 2) % 3] };
+}
+
+// Axis that can be dropped from coplanar points keeping their
+// configuration: the projection must be one to one on their plane or, if
+// they are collinear, on their line.
+template <size_t N>
+size_t projection_axis(const VectorD3 (&_pts)[N])
+{
+  for (size_t axis = 0; axis < 3; ++axis)
+  {
+    for (size_t i = 0; i < N; ++i)
+      for (size_t j = i + 1; j < N; ++j)
+        for (size_t k = j + 1; k < N; ++k)
+        {
+          if (orient2d(project(_pts[i], axis), project(_pts[j], axis),
+                       project(_pts[k], axis)) != 0)
+            return axis;
+        }
+  }
+  for (size_t axis = 0; axis < 3; ++axis)
+  {
+    for (size_t i = 1; i < N; ++i)
+    {
+      if (project(_pts[i], axis) != project(_pts[0], axis))
+        return axis;
+    }
+  }
+  return 0;
+}
+
+bool inside(const VectorD2 (&_tri)[3], const VectorD2& _pt)
+{
+  bool pos = false, neg = false;
+  for (size_t i = 0; i < 3; ++i)
+  {
+    const int s = orient2d(_tri[i], _tri[(i + 1) % 3], _pt);
+    pos |= s > 0;
+    neg |= s < 0;
+  }
+  return !(pos && neg);
+}
+
+}//namespace
+
+int orient2d(const VectorD2& _a, const VectorD2& _b, const VectorD2& _c)
+{
+  const double det_left = (_a[0] - _c[0]) * (_b[1] - _c[1]);
+  const double det_right = (_a[1] - _c[1]) * (_b[0] - _c[0]);
+  const double det = det_left - det_right;
+  const double err_bound =
+    ORIENT2D_BOUND * (std::fabs(det_left) + std::fabs(det_right));
+  if (std::fabs(det) > err_bound)
+    return sign(det);
+  return orient2d_exact(_a, _b, _c);
+}
+
+int orient3d(const VectorD3& _a, const VectorD3& _b, const VectorD3& _c,
+  const VectorD3& _d)
+{
+  const auto u = _b - _a;
+  const auto v = _c - _a;
+  const auto w = _d - _a;
+  const double m[3][2] = {
+    { u[1] * v[2], u[2] * v[1] },
+    { u[2] * v[0], u[0] * v[2] },
+    { u[0] * v[1], u[1] * v[0] } };
+  double det = 0, permanent = 0;
+  for (size_t i = 0; i < 3; ++i)
+  {
+    det += w[i] * (m[i][0] - m[i][1]);
+    permanent += std::fabs(w[i]) * (std::fabs(m[i][0]) + std::fabs(m[i][1]));
+  }
+  if (std::fabs(det) > ORIENT3D_BOUND * permanent)
+    return sign(det);
+  return orient3d_exact(_a, _b, _c, _d);
+}
+
+Intersection intersect(const std::array<VectorD2, 2>& _seg_a,
+  const std::array<VectorD2, 2>& _seg_b)
+{
+  const int oa0 = orient2d(_seg_b[0], _seg_b[1], _seg_a[0]);
+  const int oa1 = orient2d(_seg_b[0], _seg_b[1], _seg_a[1]);
+  const int ob0 = orient2d(_seg_a[0], _seg_a[1], _seg_b[0]);
+  const int ob1 = orient2d(_seg_a[0], _seg_a[1], _seg_b[1]);
+  if (oa0 * oa1 > 0 || ob0 * ob1 > 0)
+    return Intersection::NONE;
+  if (oa0 != 0 && oa1 != 0 && ob0 != 0 && ob1 != 0)
+    return Intersection::CROSS;
+  if (oa0 == 0 && oa1 == 0 && ob0 == 0 && ob1 == 0)
+  {
+    // Collinear: the lexicographic order is the order along the line.
+    auto a = std::minmax(_seg_a[0], _seg_a[1]);
+    auto b = std::minmax(_seg_b[0], _seg_b[1]);
+    if (a.second < b.first || b.second < a.first)
+      return Intersection::NONE;
+  }
+  return Intersection::TOUCH;
+}
+
+Intersection intersect(const Segment& _seg_a, const Segment& _seg_b)
+{
+  if (orient3d(_seg_a[0], _seg_a[1], _seg_b[0], _seg_b[1]) != 0)
+    return Intersection::NONE;
+  const VectorD3 pts[] = { _seg_a[0], _seg_a[1], _seg_b[0], _seg_b[1] };
+  const auto axis = projection_axis(pts);
+  return intersect(
+    std::array<VectorD2, 2>{ project(_seg_a[0], axis), project(_seg_a[1], axis) },
+    std::array<VectorD2, 2>{ project(_seg_b[0], axis), project(_seg_b[1], axis) });
+}
+
+Intersection intersect(const Triangle& _tri, const Segment& _seg)
+{
+  const int s0 = orient3d(_tri[0], _tri[1], _tri[2], _seg[0]);
+  const int s1 = orient3d(_tri[0], _tri[1], _tri[2], _seg[1]);
+  if (s0 * s1 > 0)
+    return Intersection::NONE;
+  if (s0 == 0 && s1 == 0)
+  {
+    // Coplanar, or the triangle is degenerate: drop an axis along which
+    // the projected triangle is not degenerate.
+    size_t axis = 0;
+    VectorD2 tri[3];
+    for (; axis < 3; ++axis)
+    {
+      for (size_t i = 0; i < 3; ++i)
+        tri[i] = project(_tri[i], axis);
+      if (orient2d(tri[0], tri[1], tri[2]) != 0)
+        break;
+    }
+    if (axis == 3)
+    {
+      for (size_t i = 0; i < 3; ++i)
+      {
+        if (intersect(_seg, Segment{ _tri[i], _tri[(i + 1) % 3] }) !=
+            Intersection::NONE)
+          return Intersection::TOUCH;
+      }
+      return Intersection::NONE;
+    }
+    const std::array<VectorD2, 2> seg{
+      project(_seg[0], axis), project(_seg[1], axis) };
+    if (inside(tri, seg[0]) || inside(tri, seg[1]))
+      return Intersection::TOUCH;
+    for (size_t i = 0; i < 3; ++i)
+    {
+      if (intersect(seg, { tri[i], tri[(i + 1) % 3] }) != Intersection::NONE)
+        return Intersection::TOUCH;
+    }
+    return Intersection::NONE;
+  }
+  // The segment reaches the triangle plane: the line through the segment
+  // must see the three edges with the same orientation.
+  int edge_or[3];
+  bool pos = false, neg = false;
+  for (size_t i = 0; i < 3; ++i)
+  {
+    edge_or[i] = orient3d(_seg[0], _seg[1], _tri[i], _tri[(i + 1) % 3]);
+    pos |= edge_or[i] > 0;
+    neg |= edge_or[i] < 0;
+  }
+  if (pos && neg)
+    return Intersection::NONE;
+  if (s0 == 0 || s1 == 0 ||
+      edge_or[0] == 0 || edge_or[1] == 0 || edge_or[2] == 0)
+    return Intersection::TOUCH;
+  return Intersection::CROSS;
+}
+
+}//namespace Predicates
+}//namespace Geo
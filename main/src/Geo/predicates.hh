@@ -0,0 +1,49 @@
+#pragma once
+
+#include "vector.hh"
+#include "entity.hh"
+
+namespace Geo
+{
+/*! Robust geometric predicates. Every predicate first evaluates its
+    determinants in floating point with a forward error bound (the filter
+    of Shewchuk, "Adaptive precision floating-point arithmetic and fast
+    robust geometric predicates"); only if the sign is not certain it is
+    computed again with exact expansion arithmetic. So the answers are
+    exact for any double input, with no tolerance.
+*/
+namespace Predicates
+{
+
+// Sign of ((_b - _a) % (_c - _a)): 1 if _a, _b, _c are counterclockwise,
+// -1 if clockwise, 0 if collinear.
+int orient2d(const VectorD2& _a, const VectorD2& _b, const VectorD2& _c);
+
+// Sign of ((_b - _a) % (_c - _a)) * (_d - _a): 1 if _d is on the side of
+// the normal of the triangle _a, _b, _c, -1 if on the other side, 0 if the
+// four points are coplanar.
+int orient3d(const VectorD3& _a, const VectorD3& _b, const VectorD3& _c,
+  const VectorD3& _d);
+
+enum class Intersection
+{
+  NONE,   // No common point.
+  TOUCH,  // Common points, but not a proper crossing (degenerate case).
+  CROSS   // The interiors cross in one point.
+};
+
+// Intersection of two closed 2D segments.
+Intersection intersect(const std::array<VectorD2, 2>& _seg_a,
+  const std::array<VectorD2, 2>& _seg_b);
+
+// Intersection of two closed 3D segments. Only coplanar segments can
+// intersect, so CROSS means that they cross in their interior.
+Intersection intersect(const Segment& _seg_a, const Segment& _seg_b);
+
+// Intersection of a closed segment with a closed triangle. CROSS means that
+// the segment interior crosses the triangle interior. A degenerate triangle
+// is the union of its edges.
+Intersection intersect(const Triangle& _tri, const Segment& _seg);
+
+}//namespace Predicates
+}//namespace Geo
@@ -120,14 +120,16 @@ ValT interpolate(const ValT& _a, const ValT& _b, const ParametrT& _par)
   return (1 - _par) * _a + _par * _b;
 }
 
+// The tolerance check goes first, so that only one square root of the
+// largest length is computed when the points are not within _tol.
 template <typename ValT, size_t N>
 bool same(const std::array<ValT, N>& _a, const std::array<ValT, N>& _b, const ValT& _tol)
 {
   auto diff_sq = length_square(_a - _b);
-  auto tol = std::max(Geo::epsilon_sq(_a), Geo::epsilon_sq(_b));
-  if (_tol <= 0)
-    return diff_sq <= tol;
-  return diff_sq <= std::max(Geo::sq(_tol), tol);
+  if (_tol > 0 && diff_sq <= Geo::sq(_tol))
+    return true;
+  auto len_sq = std::max(length_square(_a), length_square(_b));
+  return diff_sq <= Geo::epsilon_sq(sqrt(len_sq));
 }
 
 template <typename ValT, size_t N>
@@ -1,11 +1,15 @@
 #pragma once
 
+#include <Topology/compact_mesh.hh>
 #include <Topology/topology.hh>
 
 namespace IO {
 
 Topo::Wrap<Topo::Type::BODY> load_obj(const char* _flnm);
 bool save_obj(const char* _flnm, Topo::Wrap<Topo::Type::BODY>, bool _split = true);
+// Same as load_obj and save_obj(_flnm, _body, false) on a compact mesh.
+Topo::CompactMesh load_obj_compact(const char* _flnm);
+bool save_obj(const char* _flnm, const Topo::CompactMesh& _mesh);
 bool save_face(const Topo::E<Topo::Type::FACE>* _ptr, int _num,
                const bool _split = true);
 bool save_face(const Topo::E<Topo::Type::FACE>* _ptr, const char* _flnm,
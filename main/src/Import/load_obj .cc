@@ -10,6 +10,30 @@
 
 namespace IO {
 
+namespace {
+
+// Calls _fun with the vertex index of every corner of a face line, the
+// texture and normal indices after the '/' are skipped.
+template <class FunctionT>
+void read_face(std::istringstream& _buf, FunctionT _fun)
+{
+  int vert_idx;
+  while (_buf >> vert_idx)
+  {
+    _fun(vert_idx);
+    char c;
+    while (_buf >> c && c == '/')
+    {
+      while (_buf >> c && c == '/');// skip multiple occurrences of /
+      _buf.putback(c);
+      _buf >> vert_idx;
+    }
+    _buf.putback(c);
+  }
+}
+
+}//namespace
+
 Topo::Wrap<Topo::Type::BODY> load_obj(const char* _flnm)
 {
   Topo::Wrap<Topo::Type::BODY> new_body;
@@ -41,22 +65,48 @@ Topo::Wrap<Topo::Type::BODY> load_obj(const char* _flnm)
       Topo::Wrap<Topo::Type::FACE> face;
       face.make<Topo::EE<Topo::Type::FACE>>();
       new_body->insert_child(face.get());
-      int vert_idx;
-      while (buf >> vert_idx)
+      read_face(buf, [&face, &verts](int _vert_idx)
       {
-        face->insert_child(verts[vert_idx-1].get());
-        char c;
-        while (buf >> c && c == '/')
-        {
-          while (buf >> c && c == '/');// skip multiple occurrences of /
-          buf.putback(c);
-          buf >> vert_idx;
-        }
-        buf.putback(c);
-      }
+        face->insert_child(verts[_vert_idx - 1].get());
+      });
     }
   }
   return new_body;
 }
 
+Topo::CompactMesh load_obj_compact(const char* _flnm)
+{
+  Topo::CompactMesh mesh;
+  std::ifstream fstr(_flnm);
+  THROW_IF(!fstr.good(), "IO load error");
+
+  std::string line;
+  std::vector<std::vector<Topo::CompactMesh::Index>> loops(1);
+  while (std::getline(fstr, line))
+  {
+    if (line.size() < 3 || line[1] != ' ')
+      continue;
+    std::istringstream buf(line.c_str() + 2);
+    if (line[0] == 'v')
+    {
+      Geo::Point pt;
+      for (auto& coord : pt)
+        buf >> coord;
+      mesh.add_vertex(pt, Geo::epsilon(pt));
+    }
+    else if (line[0] == 'f')
+    {
+      auto& loop = loops[0];
+      loop.clear();
+      read_face(buf, [&loop](int _vert_idx)
+      {
+        loop.push_back(Topo::CompactMesh::Index(_vert_idx - 1));
+      });
+      mesh.add_face(loops);
+    }
+  }
+  mesh.connect_twins();
+  return mesh;
+}
+
 }//namespace Import
\ No newline at end of file
@@ -100,6 +100,37 @@ bool save_obj(const char* _flnm, const Topo::Wrap<Topo::Type::BODY> _body,
   return fstr.good();
 }
 
+bool save_obj(const char* _flnm, const Topo::CompactMesh& _mesh)
+{
+  std::ofstream fstr(_flnm);
+  THROW_IF(!fstr, "IO save error");
+  fstr << std::setprecision(17);
+  std::vector<Geo::Point> all_pts(_mesh.vert_pos_);
+  std::sort(all_pts.begin(), all_pts.end());
+  for (const auto& pt : all_pts)
+    fstr << "v " << pt[0] << " " << pt[1] << " " << pt[2] << "\n";
+
+  std::vector<Topo::CompactMesh::Index> loop_verts;
+  for (Topo::CompactMesh::Index f = 0; f < _mesh.face_count(); ++f)
+  {
+    for (auto l = _mesh.face_loop_[f]; l < _mesh.face_loop_[f + 1]; ++l)
+    {
+      fstr << "f";
+      if (l > _mesh.face_loop_[f])
+        fstr << "  ";
+      _mesh.loop_vertices(l, loop_verts);
+      for (auto v : loop_verts)
+      {
+        const auto idx = std::lower_bound(all_pts.begin(), all_pts.end(),
+          _mesh.vert_pos_[v]) - all_pts.begin() + 1;
+        fstr << " " << idx;
+      }
+      fstr << "\n";
+    }
+  }
+  return fstr.good();
+}
+
 bool save_face(const Topo::E<Topo::Type::FACE>* _ptr, const char* _flnm,
   const bool _split)
 {
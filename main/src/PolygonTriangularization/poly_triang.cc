@@ -342,7 +342,7 @@ size_t inside_triangle(
       A[i][j] = A[j][i] = _vert[i] * _vert[j];
     B[i] = _vert[i] * _test_pt;
   }
-  if (!Geo::solve_2x2(A, X, B))
+  if (!Geo::solve<2>(A, X, B))
     return 0;
 
   size_t result = 0;
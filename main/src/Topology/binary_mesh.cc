@@ -0,0 +1,226 @@
+#include "binary_mesh.hh"
+#include "impl.hh"
+
+#include <Utils/error_handling.hh>
+
+#include <array>
+#include <cstring>
+#include <fstream>
+
+namespace Topo {
+
+namespace {
+
+const char MAGIC[8] = { 'T', 'O', 'P', 'O', 'M', 'S', 'H', '\0' };
+
+struct Header
+{
+  char magic_[8];
+  uint32_t version_;
+  uint32_t index_size_;
+  uint64_t vert_nmbr_;
+  uint64_t face_nmbr_;
+  uint64_t loop_nmbr_;
+  uint64_t index_nmbr_;
+};
+static_assert(sizeof(Header) % 8 == 0, "Blocks must be 8 bytes aligned");
+static_assert(sizeof(Geo::Point) == 3 * sizeof(double), "Points are written as they are");
+
+size_t padded(size_t _bytes) { return (_bytes + 7) & ~size_t(7); }
+
+// Bytes of the blocks in file order.
+std::array<size_t, 6> block_sizes(const Header& _hd)
+{
+  typedef BinaryMesh::Index Index;
+  return {
+    3 * _hd.vert_nmbr_ * sizeof(double),
+    _hd.vert_nmbr_ * sizeof(double),
+    (_hd.face_nmbr_ + 1) * sizeof(Index),
+    (_hd.loop_nmbr_ + 1) * sizeof(Index),
+    _hd.index_nmbr_ * sizeof(Index),
+    _hd.face_nmbr_ };
+}
+
+}//namespace
+
+bool BinaryMesh::open(const char* _flnm)
+{
+  close();
+  if (!file_.open(_flnm))
+    return false;
+  auto check = [this](bool _ok)
+  {
+    if (!_ok)
+      close();
+    return _ok;
+  };
+  if (!check(file_.size() >= sizeof(Header)))
+    return false;
+  Header hd;
+  memcpy(&hd, file_.data(), sizeof(hd));
+  // Counts bigger than the file would overflow the block sizes.
+  if (!check(memcmp(hd.magic_, MAGIC, sizeof(MAGIC)) == 0 &&
+    hd.version_ == VERSION && hd.index_size_ == sizeof(Index) &&
+    hd.vert_nmbr_ < file_.size() && hd.face_nmbr_ < file_.size() &&
+    hd.loop_nmbr_ < file_.size() && hd.index_nmbr_ < file_.size()))
+  {
+    return false;
+  }
+  const char* blocks[6];
+  size_t pos = sizeof(Header);
+  const auto sizes = block_sizes(hd);
+  for (size_t i = 0; i < sizes.size(); ++i)
+  {
+    blocks[i] = file_.data() + pos;
+    pos += padded(sizes[i]);
+  }
+  if (!check(pos <= file_.size()))
+    return false;
+  // The file is mapped at a page start and the blocks are 8 bytes aligned.
+  vert_pos_ = reinterpret_cast<const double*>(blocks[0]);
+  vert_tol_ = reinterpret_cast<const double*>(blocks[1]);
+  face_loop_ = reinterpret_cast<const Index*>(blocks[2]);
+  loop_vert_ = reinterpret_cast<const Index*>(blocks[3]);
+  vert_ind_ = reinterpret_cast<const Index*>(blocks[4]);
+  face_has_loops_ = reinterpret_cast<const uint8_t*>(blocks[5]);
+  vert_nmbr_ = size_t(hd.vert_nmbr_);
+  face_nmbr_ = size_t(hd.face_nmbr_);
+  loop_nmbr_ = size_t(hd.loop_nmbr_);
+  index_nmbr_ = size_t(hd.index_nmbr_);
+  // Only the ends of the offsets, the rest is checked when it is used.
+  return check(face_loop_[0] == 0 && face_loop_[face_nmbr_] == loop_nmbr_ &&
+    loop_vert_[0] == 0 && loop_vert_[loop_nmbr_] == index_nmbr_);
+}
+
+void BinaryMesh::close()
+{
+  file_.close();
+  vert_pos_ = vert_tol_ = nullptr;
+  face_loop_ = loop_vert_ = vert_ind_ = nullptr;
+  face_has_loops_ = nullptr;
+  vert_nmbr_ = face_nmbr_ = loop_nmbr_ = index_nmbr_ = 0;
+  verts_.clear();
+}
+
+void BinaryMesh::check_face(Index _f) const
+{
+  THROW_IF(face_loop_[_f] > face_loop_[_f + 1] ||
+    face_loop_[_f + 1] > loop_nmbr_, "Wrong face");
+}
+
+void BinaryMesh::check_loop(Index _l) const
+{
+  THROW_IF(loop_vert_[_l] > loop_vert_[_l + 1] ||
+    loop_vert_[_l + 1] > index_nmbr_, "Wrong loop");
+}
+
+Wrap<Type::FACE> BinaryMesh::face(Index _f) const
+{
+  THROW_IF(_f >= face_nmbr_, "Wrong face index");
+  check_face(_f);
+  verts_.resize(vert_nmbr_);
+  Wrap<Type::FACE> face;
+  face.make<EE<Type::FACE>>();
+  for (auto l = face_loop_[_f]; l < face_loop_[_f + 1]; ++l)
+  {
+    check_loop(l);
+    IBase* parent = face.get();
+    Wrap<Type::LOOP> loop;
+    if (face_has_loops_[_f])
+    {
+      loop.make<EE<Type::LOOP>>();
+      face->insert_child(loop.get());
+      parent = loop.get();
+    }
+    for (auto i = loop_vert_[l]; i < loop_vert_[l + 1]; ++i)
+    {
+      const auto v = vert_ind_[i];
+      THROW_IF(v >= vert_nmbr_, "Wrong vertex index");
+      auto& vert = verts_[v];
+      if (!vert)
+      {
+        vert.make<EE<Type::VERTEX>>();
+        vert->set_geom(vertex(v));
+        vert->set_tolerance(tolerance(v));
+      }
+      parent->insert_child(vert.get());
+    }
+  }
+  return face;
+}
+
+Wrap<Type::BODY> BinaryMesh::to_body() const
+{
+  Wrap<Type::BODY> body;
+  body.make<EE<Type::BODY>>();
+  for (Index f = 0; f < face_nmbr_; ++f)
+    body->insert_child(face(f).get());
+  return body;
+}
+
+CompactMesh BinaryMesh::to_compact() const
+{
+  CompactMesh mesh;
+  mesh.vert_pos_.resize(vert_nmbr_);
+  memcpy(mesh.vert_pos_.data(), vert_pos_, vert_nmbr_ * sizeof(Geo::Point));
+  mesh.vert_tol_.assign(vert_tol_, vert_tol_ + vert_nmbr_);
+  mesh.he_vert_.reserve(index_nmbr_);
+  mesh.he_next_.reserve(index_nmbr_);
+  mesh.he_twin_.reserve(index_nmbr_);
+  mesh.he_face_.reserve(index_nmbr_);
+  std::vector<std::vector<Index>> loops;
+  for (Index f = 0; f < face_nmbr_; ++f)
+  {
+    loops.clear();
+    check_face(f);
+    for (auto l = face_loop_[f]; l < face_loop_[f + 1]; ++l)
+    {
+      check_loop(l);
+      loops.emplace_back(vert_ind_ + loop_vert_[l], vert_ind_ + loop_vert_[l + 1]);
+    }
+    mesh.add_face(loops, face_has_loops_[f] != 0);
+  }
+  mesh.connect_twins();
+  return mesh;
+}
+
+bool save_binary(const char* _flnm, const CompactMesh& _mesh)
+{
+  typedef CompactMesh::Index Index;
+  std::ofstream fstr(_flnm, std::ios::binary);
+  THROW_IF(!fstr, "IO save error");
+
+  std::vector<Index> loop_vert(1, 0), vert_ind, loop_verts;
+  vert_ind.reserve(_mesh.half_edge_count());
+  for (Index l = 0; l < _mesh.loop_count(); ++l)
+  {
+    _mesh.loop_vertices(l, loop_verts);
+    vert_ind.insert(vert_ind.end(), loop_verts.begin(), loop_verts.end());
+    loop_vert.push_back(Index(vert_ind.size()));
+  }
+  std::vector<uint8_t> has_loops(
+    _mesh.face_has_loops_.begin(), _mesh.face_has_loops_.end());
+
+  Header hd = {};
+  memcpy(hd.magic_, MAGIC, sizeof(MAGIC));
+  hd.version_ = BinaryMesh::VERSION;
+  hd.index_size_ = sizeof(Index);
+  hd.vert_nmbr_ = _mesh.vertex_count();
+  hd.face_nmbr_ = _mesh.face_count();
+  hd.loop_nmbr_ = _mesh.loop_count();
+  hd.index_nmbr_ = vert_ind.size();
+  fstr.write(reinterpret_cast<const char*>(&hd), sizeof(hd));
+
+  const void* blocks[] = { _mesh.vert_pos_.data(), _mesh.vert_tol_.data(),
+    _mesh.face_loop_.data(), loop_vert.data(), vert_ind.data(), has_loops.data() };
+  const auto sizes = block_sizes(hd);
+  for (size_t i = 0; i < sizes.size(); ++i)
+  {
+    static const char pad[8] = {};
+    fstr.write(static_cast<const char*>(blocks[i]), sizes[i]);
+    fstr.write(pad, padded(sizes[i]) - sizes[i]);
+  }
+  return fstr.good();
+}
+
+}//namespace Topo
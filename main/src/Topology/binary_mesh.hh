@@ -0,0 +1,73 @@
+#pragma once
+
+#include "compact_mesh.hh"
+
+#include <Utils/mapped_file.hh>
+
+#include <cstdint>
+#include <vector>
+
+namespace Topo {
+
+/*! Columnar binary file of a body made of faces and vertices. The file
+    is memory mapped and its blocks are used in place, so opening it
+    reads only the header and a big body is available at once; faces
+    become Topo entities only when asked.
+    After the header every block starts at a multiple of 8 bytes:
+      double  positions[3 * vertex_count]
+      double  tolerances[vertex_count]
+      uint32  face_loop[face_count + 1]   loops of f are [face_loop[f], face_loop[f + 1])
+      uint32  loop_vert[loop_count + 1]   same for the vertex indices of a loop
+      uint32  vert_ind[index_count]
+      uint8   face_has_loops[face_count]
+    Numbers are written in the byte order of the machine.
+*/
+class BinaryMesh
+{
+public:
+  typedef CompactMesh::Index Index;
+  static const uint32_t VERSION = 1;
+
+  // False if the file cannot be mapped or it is not a valid mesh file
+  // of this version.
+  bool open(const char* _flnm);
+  void close();
+
+  size_t vertex_count() const { return vert_nmbr_; }
+  size_t face_count() const { return face_nmbr_; }
+  size_t loop_count() const { return loop_nmbr_; }
+
+  Geo::Point vertex(Index _v) const
+  {
+    return { vert_pos_[3 * _v], vert_pos_[3 * _v + 1], vert_pos_[3 * _v + 2] };
+  }
+  double tolerance(Index _v) const { return vert_tol_[_v]; }
+
+  // The face _f with its loops and vertices. Vertices are made once and
+  // shared by all the faces asked to this object.
+  Wrap<Type::FACE> face(Index _f) const;
+  Wrap<Type::BODY> to_body() const;
+  CompactMesh to_compact() const;
+
+  // Blocks in the file.
+  const double* vert_pos_ = nullptr;
+  const double* vert_tol_ = nullptr;
+  const Index* face_loop_ = nullptr;
+  const Index* loop_vert_ = nullptr;
+  const Index* vert_ind_ = nullptr;
+  const uint8_t* face_has_loops_ = nullptr;
+
+private:
+  // Throw if the offsets of the face or of the loop are out of the blocks.
+  void check_face(Index _f) const;
+  void check_loop(Index _l) const;
+
+  Utils::MappedFile file_;
+  size_t vert_nmbr_ = 0, face_nmbr_ = 0, loop_nmbr_ = 0, index_nmbr_ = 0;
+  mutable std::vector<Wrap<Type::VERTEX>> verts_;
+};
+
+// Writes the file read by BinaryMesh.
+bool save_binary(const char* _flnm, const CompactMesh& _mesh);
+
+}//namespace Topo
@@ -0,0 +1,262 @@
+#include "compact_mesh.hh"
+#include "impl.hh"
+#include "iterator.hh"
+
+#include <Utils/error_handling.hh>
+
+#include <algorithm>
+#include <array>
+#include <unordered_map>
+
+namespace Topo {
+
+void CompactMesh::clear()
+{
+  *this = CompactMesh();
+}
+
+CompactMesh::Index CompactMesh::add_vertex(const Geo::Point& _pt, double _tol)
+{
+  vert_pos_.push_back(_pt);
+  vert_tol_.push_back(_tol);
+  return Index(vert_pos_.size() - 1);
+}
+
+CompactMesh::Index CompactMesh::add_face(
+  const std::vector<std::vector<Index>>& _loops, bool _has_loops)
+{
+  const auto face = Index(face_count());
+  for (const auto& loop : _loops)
+  {
+    THROW_IF(loop.empty(), "Empty loop");
+    const auto first = Index(he_vert_.size());
+    loop_he_.push_back(first);
+    for (size_t i = 0; i < loop.size(); ++i)
+    {
+      THROW_IF(loop[i] >= vertex_count(), "Wrong vertex index");
+      he_vert_.push_back(loop[i]);
+      he_next_.push_back(i + 1 < loop.size() ? first + Index(i + 1) : first);
+      he_twin_.push_back(INVALID);
+      he_face_.push_back(face);
+    }
+  }
+  face_loop_.push_back(Index(loop_he_.size()));
+  face_has_loops_.push_back(_has_loops || _loops.size() > 1);
+  return face;
+}
+
+void CompactMesh::connect_twins()
+{
+  // Sorts the half-edges by unordered couple of vertices and in each
+  // group joins every half-edge with the first free one going backward.
+  std::vector<std::array<Index, 3>> keys(half_edge_count());
+  for (Index h = 0; h < keys.size(); ++h)
+  {
+    auto v0 = he_vert_[h], v1 = he_vert_[he_next_[h]];
+    keys[h] = { std::min(v0, v1), std::max(v0, v1), h };
+    he_twin_[h] = INVALID;
+  }
+  std::sort(keys.begin(), keys.end());
+  for (size_t i = 0; i < keys.size();)
+  {
+    auto j = i + 1;
+    while (j < keys.size() && keys[j][0] == keys[i][0] && keys[j][1] == keys[i][1])
+      ++j;
+    for (auto k = i; k < j; ++k)
+    {
+      const auto h = keys[k][2];
+      if (he_twin_[h] != INVALID)
+        continue;
+      for (auto l = k + 1; l < j; ++l)
+      {
+        const auto g = keys[l][2];
+        if (he_twin_[g] == INVALID && he_vert_[g] == he_vert_[he_next_[h]] &&
+          he_vert_[h] == he_vert_[he_next_[g]] && he_vert_[g] != he_vert_[h])
+        {
+          he_twin_[h] = g;
+          he_twin_[g] = h;
+          break;
+        }
+      }
+    }
+    i = j;
+  }
+}
+
+void CompactMesh::loop_vertices(Index _l, std::vector<Index>& _verts) const
+{
+  _verts.clear();
+  const auto first = loop_he_[_l];
+  auto h = first;
+  do
+  {
+    _verts.push_back(he_vert_[h]);
+    h = he_next_[h];
+  } while (h != first);
+}
+
+namespace {
+
+template <class FunctionT>
+void for_face_points(const CompactMesh& _mesh, CompactMesh::Index _f,
+  FunctionT _fun)
+{
+  for (auto l = _mesh.face_loop_[_f]; l < _mesh.face_loop_[_f + 1]; ++l)
+  {
+    const auto first = _mesh.loop_he_[l];
+    auto h = first;
+    do
+    {
+      _fun(_mesh.vert_pos_[_mesh.he_vert_[h]]);
+      h = _mesh.he_next_[h];
+    } while (h != first);
+  }
+}
+
+}//namespace
+
+Geo::Range<3> CompactMesh::face_box(Index _f) const
+{
+  Geo::Range<3> b;
+  for_face_points(*this, _f, [&b](const Geo::Point& _pt) { b += _pt; });
+  b.fatten(1.e-5);
+  return b;
+}
+
+Geo::Point CompactMesh::face_centroid(Index _f) const
+{
+  Geo::Point pt = {};
+  size_t nmbr = 0;
+  for_face_points(*this, _f, [&pt, &nmbr](const Geo::Point& _pt)
+  {
+    pt += _pt;
+    ++nmbr;
+  });
+  if (nmbr > 0)
+    pt /= double(nmbr);
+  return pt;
+}
+
+Geo::Segment CompactMesh::edge_segment(Index _h) const
+{
+  return { vert_pos_[he_vert_[_h]], vert_pos_[he_vert_[he_next_[_h]]] };
+}
+
+Geo::Range<3> CompactMesh::edge_box(Index _h) const
+{
+  Geo::Range<3> b;
+  for (const auto& pt : edge_segment(_h))
+    b += pt;
+  b.fatten(std::max(vert_tol_[he_vert_[_h]], vert_tol_[he_vert_[he_next_[_h]]]));
+  return b;
+}
+
+size_t CompactMesh::memory() const
+{
+  auto bytes = [](const auto& _vec)
+  {
+    return _vec.capacity() * sizeof(_vec[0]);
+  };
+  return bytes(vert_pos_) + bytes(vert_tol_) +
+    bytes(he_vert_) + bytes(he_next_) + bytes(he_twin_) + bytes(he_face_) +
+    bytes(loop_he_) + bytes(face_loop_) + face_has_loops_.capacity() / 8;
+}
+
+void CompactMesh::from_body(const Wrap<Type::BODY>& _body)
+{
+  clear();
+  // Vertices are numbered in order of first use.
+  std::unordered_map<const IBase*, Index> vert_inds;
+  auto vertex_index = [this, &vert_inds](IBase* _vert)
+  {
+    auto pos = vert_inds.emplace(_vert, Index(vertex_count()));
+    if (pos.second)
+    {
+      Geo::Point pt;
+      static_cast<E<Type::VERTEX>*>(_vert)->geom(pt);
+      add_vertex(pt, _vert->tolerance());
+    }
+    return pos.first->second;
+  };
+  std::vector<std::vector<Index>> loops;
+  auto add_loop = [&loops, &vertex_index](const IBase* _loop)
+  {
+    loops.emplace_back();
+    for (size_t i = 0; i < _loop->size(Direction::Down); ++i)
+      loops.back().push_back(vertex_index(_loop->get(Direction::Down, i)));
+  };
+  Iterator<Type::BODY, Type::FACE> bf_it(_body);
+  for (const auto& face : bf_it)
+  {
+    loops.clear();
+    const bool has_loops = face->size(Direction::Down) > 0 &&
+      face->get(Direction::Down, 0)->type() == Type::LOOP;
+    if (has_loops)
+    {
+      for (size_t i = 0; i < face->size(Direction::Down); ++i)
+        add_loop(face->get(Direction::Down, i));
+    }
+    else if (face->size(Direction::Down) > 0)
+      add_loop(face.get());
+    add_face(loops, has_loops);
+  }
+  connect_twins();
+}
+
+Wrap<Type::BODY> CompactMesh::to_body() const
+{
+  Wrap<Type::BODY> body;
+  body.make<EE<Type::BODY>>();
+  std::vector<Wrap<Type::VERTEX>> verts(vertex_count());
+  for (size_t i = 0; i < verts.size(); ++i)
+  {
+    verts[i].make<EE<Type::VERTEX>>();
+    verts[i]->set_geom(vert_pos_[i]);
+    verts[i]->set_tolerance(vert_tol_[i]);
+  }
+  std::vector<Index> loop_verts;
+  for (Index f = 0; f < face_count(); ++f)
+  {
+    Wrap<Type::FACE> face;
+    face.make<EE<Type::FACE>>();
+    body->insert_child(face.get());
+    for (auto l = face_loop_[f]; l < face_loop_[f + 1]; ++l)
+    {
+      IBase* parent = face.get();
+      Wrap<Type::LOOP> loop;
+      if (face_has_loops_[f])
+      {
+        loop.make<EE<Type::LOOP>>();
+        face->insert_child(loop.get());
+        parent = loop.get();
+      }
+      loop_vertices(l, loop_verts);
+      for (auto v : loop_verts)
+        parent->insert_child(verts[v].get());
+    }
+  }
+  return body;
+}
+
+std::vector<CompactMesh::Item> CompactMesh::face_items() const
+{
+  std::vector<Item> items(face_count());
+  for (Index f = 0; f < items.size(); ++f)
+    items[f] = { f, face_box(f), face_centroid(f) };
+  return items;
+}
+
+std::vector<CompactMesh::Item> CompactMesh::edge_items() const
+{
+  std::vector<Item> items;
+  for (Index h = 0; h < half_edge_count(); ++h)
+  {
+    if (!edge_representative(h))
+      continue;
+    auto seg = edge_segment(h);
+    items.push_back({ h, edge_box(h), (seg[0] + seg[1]) * 0.5 });
+  }
+  return items;
+}
+
+}//namespace Topo
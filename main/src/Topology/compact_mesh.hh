@@ -0,0 +1,103 @@
+#pragma once
+
+#include "topology.hh"
+
+#include <cstdint>
+#include <vector>
+
+namespace Topo {
+
+/*! Index based half-edge representation of a body made of faces and
+    vertices, stored in contiguous arrays (structure of arrays) instead
+    of a graph of objects.
+    Every loop of a face is a cycle of half-edges, the half-edge h goes
+    from he_vert_[h] to he_vert_[he_next_[h]]. The loops of the face f are
+    [face_loop_[f], face_loop_[f + 1]) and loop_he_[l] is the first
+    half-edge of the loop l, so that the loop vertices keep their order.
+    Half-edges with opposite direction on the same couple of vertices are
+    twins; half-edges on a boundary or on a non manifold edge without a
+    matching opposite one have INVALID twin.
+    It converts to and from Wrap<Type::BODY> preserving vertex sharing,
+    face, loop and vertex order and whether a face has loop children.
+*/
+struct CompactMesh
+{
+  typedef uint32_t Index;
+  static constexpr Index INVALID = UINT32_MAX;
+
+  // Vertices.
+  std::vector<Geo::Point> vert_pos_;
+  std::vector<double> vert_tol_;
+
+  // Half-edges.
+  std::vector<Index> he_vert_;
+  std::vector<Index> he_next_;
+  std::vector<Index> he_twin_;
+  std::vector<Index> he_face_;
+
+  // Loops and faces.
+  std::vector<Index> loop_he_;
+  std::vector<Index> face_loop_ = std::vector<Index>(1, 0);
+  // Faces with Type::LOOP children in the body, else with vertices.
+  std::vector<bool> face_has_loops_;
+
+  size_t vertex_count() const { return vert_pos_.size(); }
+  size_t half_edge_count() const { return he_vert_.size(); }
+  size_t loop_count() const { return loop_he_.size(); }
+  size_t face_count() const { return face_loop_.size() - 1; }
+
+  void clear();
+
+  // Adds a vertex and returns its index.
+  Index add_vertex(const Geo::Point& _pt, double _tol);
+
+  // Adds a face with one loop for each vertex index vector. Twins are
+  // not set, call connect_twins() when all the faces are there. Faces
+  // with more than one loop always have Type::LOOP children in
+  // to_body(), _has_loops asks for them also with one loop.
+  Index add_face(const std::vector<std::vector<Index>>& _loops,
+    bool _has_loops = false);
+
+  // Sets he_twin_ for all the half-edges.
+  void connect_twins();
+
+  // Vertex indices of the loop _l in order.
+  void loop_vertices(Index _l, std::vector<Index>& _verts) const;
+
+  // Same as EE<Type::FACE>::box() and internal_point(), for faces with
+  // loops they use the vertices of all the loops.
+  Geo::Range<3> face_box(Index _f) const;
+  Geo::Point face_centroid(Index _f) const;
+
+  // Edges are identified by one of their half-edges: the one with lower
+  // index of a twin couple. Same as EdgeRef::box() and internal_point().
+  bool edge_representative(Index _h) const
+  {
+    return he_twin_[_h] == INVALID || _h < he_twin_[_h];
+  }
+  Geo::Segment edge_segment(Index _h) const;
+  Geo::Range<3> edge_box(Index _h) const;
+
+  // Bytes used by the arrays.
+  size_t memory() const;
+
+  void from_body(const Wrap<Type::BODY>& _body);
+  Wrap<Type::BODY> to_body() const;
+
+  // Elements for Geo::KdTree, so that the Boolean broad-phase can run
+  // on the compact mesh (see Geo::find_kdtree_couples). The box and the
+  // internal point are computed once, the tree asks for them many times.
+  struct Item
+  {
+    Index ind_;  // Face or representative half-edge.
+    Geo::Range<3> box_;
+    Geo::Point pt_;
+    const Item* operator->() const { return this; }
+    const Geo::Range<3>& box() const { return box_; }
+    const Geo::Point& internal_point() const { return pt_; }
+  };
+  std::vector<Item> face_items() const;
+  std::vector<Item> edge_items() const;
+};
+
+}//namespace Topo
@@ -1,12 +1,17 @@
 
 #include "geom.hh"
+#include "impl.hh"
 #include "iterator.hh"
+#include "Geo/plane_fitting.hh"
 #include "Utils/error_handling.hh"
 
 namespace Topo {
 
 Geo::Point face_normal(Topo::Wrap<Topo::Type::FACE> _face)
 {
+  // Faces cache the normal, loops seen as faces are computed every time.
+  if (_face->sub_type() == SubType::FACE)
+    return static_cast<const EE<Type::FACE>*>(_face.get())->normal();
   Iterator<Type::FACE, Type::LOOP> fl_it(_face);
   THROW_IF(fl_it.size() == 0, "Normal ofnot defined face");
   Iterator<Type::LOOP, Type::VERTEX> lv_it(*fl_it.begin());
@@ -22,6 +27,20 @@ Geo::Point face_normal(Topo::Wrap<Topo::Type::FACE> _face)
   return poly_face->normal();
 }
 
+Geo::Point face_plane_normal(Topo::Wrap<Topo::Type::FACE> _face)
+{
+  Geo::Point center, norm;
+  if (_face->sub_type() == SubType::FACE)
+  {
+    static_cast<const EE<Type::FACE>*>(_face.get())->plane(center, norm);
+    return norm;
+  }
+  Iterator<Type::FACE, Type::LOOP> fl_it(_face);
+  THROW_IF(fl_it.size() == 0, "Normal of not defined face");
+  Iterator<Type::LOOP, Type::VERTEX> lv_it(*fl_it.begin());
+  return Geo::vertex_polygon_normal(lv_it.begin(), lv_it.end());
+}
+
 Geo::Point coedge_direction(Topo::Wrap<Topo::Type::COEDGE> _coed)
 {
   Geo::Segment seg;
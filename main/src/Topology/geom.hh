@@ -7,6 +7,8 @@
 namespace Topo {
 
 Geo::Point face_normal(Topo::Wrap<Topo::Type::FACE> _face);
+// Normal of the best fitting plane of the outer loop vertices.
+Geo::Point face_plane_normal(Topo::Wrap<Topo::Type::FACE> _face);
 Geo::Point coedge_direction(Topo::Wrap<Topo::Type::COEDGE> _coed);
 
 namespace PointInFace {
@@ -5,8 +5,98 @@
 #include <Utils/statistics.hh>
 #include <Geo/vector.hh>
 #include <Geo/iterate.hh>
+#include <Geo/plane_fitting.hh>
+
+#include <mutex>
+#include <unordered_map>
 
 namespace Topo {
+
+void ElementIndex::inserted(const std::vector<IBase*>& _elems, size_t _pos)
+{
+  if (_elems.size() < min_size_)
+    return;
+  if (index_.empty())
+  {
+    rebuild(_elems);
+    return;
+  }
+  if (_pos + 1 < _elems.size())
+  {
+    for (auto& entry : index_)
+      entry.second += entry.second >= _pos;
+  }
+  const Entry entry(_elems[_pos], _pos);
+  index_.insert(std::lower_bound(index_.begin(), index_.end(), entry), entry);
+}
+
+void ElementIndex::erased(
+  const std::vector<IBase*>& _elems, size_t _pos, const IBase* _el)
+{
+  if (_elems.size() < min_size_)
+  {
+    index_.clear();
+    return;
+  }
+  index_.erase(std::lower_bound(index_.begin(), index_.end(), Entry(_el, _pos)));
+  if (_pos < _elems.size())
+  {
+    for (auto& entry : index_)
+      entry.second -= entry.second > _pos;
+  }
+}
+
+void ElementIndex::replaced(size_t _pos, const IBase* _old_el, const IBase* _new_el)
+{
+  if (index_.empty())
+    return;
+  index_.erase(std::lower_bound(index_.begin(), index_.end(), Entry(_old_el, _pos)));
+  const Entry entry(_new_el, _pos);
+  index_.insert(std::lower_bound(index_.begin(), index_.end(), entry), entry);
+}
+
+void ElementIndex::rebuild(const std::vector<IBase*>& _elems)
+{
+  index_.clear();
+  if (_elems.size() < min_size_)
+    return;
+  index_.reserve(_elems.size());
+  for (size_t i = 0; i < _elems.size(); ++i)
+    index_.emplace_back(_elems[i], i);
+  std::sort(index_.begin(), index_.end());
+}
+
+size_t ElementIndex::find_first(
+  const std::vector<IBase*>& _elems, const IBase* _el) const
+{
+  if (index_.empty())
+  {
+    auto it = std::find(_elems.begin(), _elems.end(), _el);
+    return it == _elems.end() ? SIZE_MAX : it - _elems.begin();
+  }
+  auto it = std::lower_bound(index_.begin(), index_.end(), Entry(_el, 0));
+  return it == index_.end() || it->first != _el ? SIZE_MAX : it->second;
+}
+
+size_t ElementIndex::find_last(
+  const std::vector<IBase*>& _elems, const IBase* _el, size_t _end) const
+{
+  if (index_.empty())
+  {
+    auto start_it = _elems.rbegin();
+    if (_end < _elems.size())
+      start_it += _elems.size() - _end;
+    auto it = std::find(start_it, _elems.rend(), _el);
+    if (it == _elems.rend())
+      return SIZE_MAX;
+    return _elems.rend() - it - 1;
+  }
+  auto it = std::lower_bound(index_.begin(), index_.end(), Entry(_el, _end));
+  if (it == index_.begin() || (--it)->first != _el)
+    return SIZE_MAX;
+  return it->second;
+}
+
 //#pragma warning (disable : 4505)
 template <Type typeT> 
 size_t Base<typeT>::size(Direction _dir) const
@@ -50,19 +140,17 @@ bool Base<typeT>::remove()
 template <Type typeT>
 size_t Base<typeT>::find_parent(const IBase* _prnt) const
 {
-  auto it = std::find(up_elems_.begin(), up_elems_.end(), _prnt);
-  if (it == up_elems_.end())
-    return SIZE_MAX;
-  return it - up_elems_.begin();
+  return up_index_.find_first(up_elems_, _prnt);
 }
 
 template <Type typeT>
 bool Base<typeT>::remove_parent(IBase* _prnt)
 {
-  auto it = std::find(up_elems_.begin(), up_elems_.end(), _prnt);
-  if (it == up_elems_.end())
+  auto pos = up_index_.find_first(up_elems_, _prnt);
+  if (pos == SIZE_MAX)
     return false;
-  up_elems_.erase(it);
+  up_elems_.erase(up_elems_.begin() + pos);
+  up_index_.erased(up_elems_, pos, _prnt);
   return true;
 }
 
@@ -70,6 +158,7 @@ template <Type typeT>
 bool Base<typeT>::add_parent(IBase* _prnt)
 {
   up_elems_.push_back(_prnt); 
+  up_index_.inserted(up_elems_, up_elems_.size() - 1);
   return true;
 }
 
@@ -100,10 +189,14 @@ bool UpEntity<typeT>::insert_child(IBase* _el, size_t _pos)
 {
   if (_el == nullptr)
     return false;
-  auto it = (_pos >= low_elems_.size()) ? low_elems_.end() : low_elems_.begin() + _pos;
-  low_elems_.insert(it, _el);
+  if (_pos > low_elems_.size())
+    _pos = low_elems_.size();
+  low_elems_.insert(low_elems_.begin() + _pos, _el);
+  low_index_.inserted(low_elems_, _pos);
   _el->add_ref();
   _el->add_parent(this);
+  this->invalidate_geometry();
+  this->invalidate_parents_topology();
   return true;
 }
 
@@ -114,8 +207,11 @@ bool UpEntity<typeT>::remove_child(size_t _pos)
     return false;
   auto obj = low_elems_[_pos];
   low_elems_.erase(low_elems_.begin() + _pos);
+  low_index_.erased(low_elems_, _pos, obj);
   obj->remove_parent(this);
   obj->release_ref();
+  this->invalidate_geometry();
+  this->invalidate_parents_topology();
   return true;
 }
 
@@ -138,8 +234,11 @@ bool UpEntity<typeT>::replace_child(size_t _pos, IBase* _new_obj)
   low_elems_[_pos]->remove_parent(this);
   low_elems_[_pos]->release_ref();
 
+  low_index_.replaced(_pos, low_elems_[_pos], _new_obj);
   low_elems_[_pos] = _new_obj;
   _new_obj->add_parent(this);
+  this->invalidate_geometry();
+  this->invalidate_parents_topology();
   return true;
 }
 
@@ -160,13 +259,7 @@ bool UpEntity<typeT>::replace_child(IBase* _el, IBase* _new_el)
 template <Type typeT>
 size_t UpEntity<typeT>::find_child(const IBase* _el, size_t _end) const
 {
-  auto start_it = low_elems_.rbegin();
-  if (_end < low_elems_.size())
-    start_it += low_elems_.size() - _end;
-  auto it = std::find(start_it, low_elems_.rend(), _el);
-  if (it == low_elems_.rend())
-    return SIZE_MAX;
-  return low_elems_.rend() - it - 1;
+  return low_index_.find_last(low_elems_, _el, _end);
 }
 
 template <Type typeT>
@@ -177,20 +270,202 @@ bool UpEntity<typeT>::remove()
   return Base<typeT>::remove();
 }
 
+// Edges of the body faces with the number of their coedges. Modifying
+// the body is not thread safe, building the table on request is.
+struct EE<Type::BODY>::EdgeTable
+{
+  typedef std::pair<const IBase*, const IBase*> Key;
+  struct KeyHash
+  {
+    size_t operator()(const Key& _key) const
+    {
+      std::hash<const IBase*> hash;
+      return hash(_key.first) * 31 + hash(_key.second);
+    }
+  };
+  struct Entry
+  {
+    Wrap<Type::EDGE> edge_;
+    size_t coedges_ = 0;
+  };
+
+  // Vertices in the order of EdgeRef::finalise().
+  static Key key(const IBase* _v0, const IBase* _v1)
+  {
+    return *_v1 < *_v0 ? Key(_v1, _v0) : Key(_v0, _v1);
+  }
+
+  // Calls _fun for every couple of consecutive vertices of a face or a
+  // loop, as Iterator<Type::BODY, Type::EDGE> does.
+  template <class FunctionT>
+  static void for_each_coedge(const IBase* _el, FunctionT& _fun)
+  {
+    const auto size = _el->size(Direction::Down);
+    for (size_t i = 0; i < size; ++i)
+    {
+      auto child = _el->get(Direction::Down, i);
+      if (child->type() == Type::VERTEX)
+        _fun(child, _el->get(Direction::Down, i + 1));
+      else if (child->type() > Type::EDGE)
+        for_each_coedge(child, _fun);
+    }
+  }
+
+  void add(const IBase* _v0, const IBase* _v1)
+  {
+    auto k = key(_v0, _v1);
+    auto& entry = map_[k];
+    if (entry.coedges_++ > 0)
+      return;
+    auto edge = entry.edge_.make<EdgeRef>();
+    edge->verts_[0] = static_cast<E<Type::VERTEX>*>(const_cast<IBase*>(k.first));
+    edge->verts_[1] = static_cast<E<Type::VERTEX>*>(const_cast<IBase*>(k.second));
+    sorted_valid_ = false;
+  }
+
+  void remove(const IBase* _v0, const IBase* _v1)
+  {
+    auto it = map_.find(key(_v0, _v1));
+    if (it == map_.end() || --it->second.coedges_ > 0)
+      return;
+    map_.erase(it);
+    sorted_valid_ = false;
+  }
+
+  // A face has been inserted in or removed from the body.
+  void update(const IBase* _face, bool _add)
+  {
+    if (!valid_ || _face == nullptr)
+      return;
+    auto fun = [this, _add](const IBase* _v0, const IBase* _v1)
+    {
+      if (_add)
+        add(_v0, _v1);
+      else
+        remove(_v0, _v1);
+    };
+    for_each_coedge(_face, fun);
+  }
+
+  void clear()
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (!valid_)
+      return;
+    valid_ = sorted_valid_ = false;
+    map_.clear();
+    sorted_.clear();
+  }
+
+  const std::vector<Wrap<Type::EDGE>>& edges(const std::vector<IBase*>& _faces)
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (!valid_)
+    {
+      valid_ = true;
+      for (auto face : _faces)
+        update(face, true);
+    }
+    if (!sorted_valid_)
+    {
+      sorted_.clear();
+      sorted_.reserve(map_.size());
+      for (const auto& entry : map_)
+        sorted_.push_back(entry.second.edge_);
+      std::sort(sorted_.begin(), sorted_.end());
+      sorted_valid_ = true;
+    }
+    return sorted_;
+  }
+
+  Wrap<Type::EDGE> find(const IBase* _v0, const IBase* _v1)
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (!valid_)
+      return Wrap<Type::EDGE>();
+    auto it = map_.find(key(_v0, _v1));
+    return it == map_.end() ? Wrap<Type::EDGE>() : it->second.edge_;
+  }
+
+  std::mutex mtx_;
+  bool valid_ = false;
+  std::unordered_map<Key, Entry, KeyHash> map_;
+  bool sorted_valid_ = false;
+  std::vector<Wrap<Type::EDGE>> sorted_;
+};
+
+EE<Type::BODY>::EE() : edge_table_(new EdgeTable)
+{
+  // Faces are searched in the ordered children (see optimize()), keeping
+  // an index would make adding faces quadratic.
+  low_index_ = ElementIndex(SIZE_MAX);
+}
+
+EE<Type::BODY>::~EE() {}
+
 bool EE<Type::BODY>::insert_child(IBase* _el, size_t _pos)
 {
   auto res = UpEntity<Type::BODY>::insert_child(_el, _pos);
   ordered_children_ &= !res;
+  if (res)
+  {
+    edge_table_->update(_el, true);
+    ++generation_;
+  }
   return res;
 }
 
+bool EE<Type::BODY>::remove_child(size_t _pos)
+{
+  if (_pos < low_elems_.size())
+  {
+    edge_table_->update(low_elems_[_pos], false);
+    ++generation_;
+  }
+  return UpEntity<Type::BODY>::remove_child(_pos);
+}
+
 bool EE<Type::BODY>::replace_child(size_t _pos, IBase* _new_obj)
 {
+  auto old_obj = _pos < low_elems_.size() ? low_elems_[_pos] : nullptr;
   auto res = UpEntity<Type::BODY>::replace_child(_pos, _new_obj);
   ordered_children_ &= !res;
+  if (res && old_obj != _new_obj)
+  {
+    edge_table_->update(old_obj, false);
+    edge_table_->update(_new_obj, true);
+    ++generation_;
+  }
   return res;
 }
 
+const std::vector<Wrap<Type::EDGE>>& EE<Type::BODY>::edges() const
+{
+  return edge_table_->edges(low_elems_);
+}
+
+Wrap<Type::EDGE> EE<Type::BODY>::find_edge(const IBase* _v0, const IBase* _v1) const
+{
+  return edge_table_->find(_v0, _v1);
+}
+
+void EE<Type::BODY>::invalidate_topology()
+{
+  if (deferred_ > 0)
+  {
+    invalidation_pending_ = true;
+    return;
+  }
+  edge_table_->clear();
+  ++generation_;
+}
+
+void EE<Type::BODY>::resume_invalidation()
+{
+  if (--deferred_ == 0 && invalidation_pending_.exchange(false))
+    invalidate_topology();
+}
+
 namespace {
 bool compare_i_base(const IBase* _a, const IBase* _b) { return _a->id() < _b->id(); };
 }//namespace
@@ -214,7 +489,9 @@ void EE<Type::BODY>::optimize()
   if (ordered_children_)
     return;
   std::sort(low_elems_.begin(), low_elems_.end(), compare_i_base);
+  low_index_.rebuild(low_elems_);
   ordered_children_ = true;
+  ++generation_;
 }
 
 bool EE<Type::BODY>::remove()
@@ -236,17 +513,24 @@ bool EE<Type::BODY>::remove_children(
     _faces_to_remove.cbegin(), _faces_to_remove.cend(),
     std::back_inserter(low_elems), compare_i_base);
   low_elems_ = std::move(low_elems);
+  low_index_.rebuild(low_elems_);
+  edge_table_->clear();
+  ++generation_;
   return true;
 }
 
 bool EE<Type::FACE>::reverse()
 {
   std::reverse(low_elems_.begin(), low_elems_.end());
+  low_index_.rebuild(low_elems_);
+  cached_ &= ~(NORMAL | PLANE);
   return true;
 }
 
 Geo::Point EE<Type::FACE>::internal_point() const
 {
+  if (cached_ & CENTROID)
+    return centroid_;
   Geo::Point pt = {};
   if (!low_elems_.empty())
   {
@@ -254,11 +538,15 @@ Geo::Point EE<Type::FACE>::internal_point() const
       pt += el->internal_point();
     pt /= double(low_elems_.size());
   }
-  return pt;
+  centroid_ = pt;
+  cached_ |= CENTROID;
+  return centroid_;
 }
 
 Geo::Range<3> EE<Type::FACE>::box() const
 {
+  if (cached_ & BOX)
+    return box_;
   Utils::FindMax<double> max_tol;
   Geo::Range<3> b;
   for (const auto el : low_elems_)
@@ -266,10 +554,59 @@ Geo::Range<3> EE<Type::FACE>::box() const
     max_tol.add(el->tolerance());
     auto pt = el->internal_point();
     max_tol.add(Geo::epsilon(pt));
-    b += el->internal_point();
+    b += pt;
   }
   b.fatten(1.e-5);
-  return b;
+  box_ = b;
+  cached_ |= BOX;
+  return box_;
+}
+
+namespace {
+
+// Points of the first loop of the face or of the face itself when
+// it has vertices as children.
+std::vector<Geo::Point> outer_loop_points(const IBase* _face)
+{
+  const IBase* loop = _face;
+  if (_face->size(Direction::Down) > 0 &&
+    _face->get(Direction::Down, 0)->type() == Type::LOOP)
+  {
+    loop = _face->get(Direction::Down, 0);
+  }
+  std::vector<Geo::Point> pts(loop->size(Direction::Down));
+  for (size_t i = 0; i < pts.size(); ++i)
+    pts[i] = loop->get(Direction::Down, i)->internal_point();
+  THROW_IF(pts.empty(), "Normal of not defined face");
+  return pts;
+}
+
+}//namespace
+
+const Geo::VectorD3& EE<Type::FACE>::normal() const
+{
+  if (cached_ & NORMAL)
+    return normal_;
+  auto pts = outer_loop_points(this);
+  auto poly_face = Geo::IPolygonalFace::make();
+  poly_face->add_loop(pts.begin(), pts.end());
+  poly_face->compute();
+  normal_ = poly_face->normal();
+  cached_ |= NORMAL;
+  return normal_;
+}
+
+void EE<Type::FACE>::plane(Geo::Point& _center, Geo::VectorD3& _normal) const
+{
+  if (!(cached_ & PLANE))
+  {
+    auto pts = outer_loop_points(this);
+    plane_normal_ = Geo::point_polygon_normal(
+      pts.begin(), pts.end(), &plane_center_);
+    cached_ |= PLANE;
+  }
+  _center = plane_center_;
+  _normal = plane_normal_;
 }
 
 // A face can have all loops or all not loops.
@@ -283,6 +620,13 @@ bool EE<Type::FACE>::check()
   return loop_nmbr == 0 || loop_nmbr == low_elems_.size();
 }
 
+bool EE<Type::VERTEX>::set_geom(const Geo::Point& _pt)
+{
+  pt_ = _pt;
+  invalidate_parents_geometry();
+  return true;
+}
+
 double EE<Type::VERTEX>::tolerance() const
 {
   return std::max(tol_, Geo::epsilon(pt_));
@@ -330,7 +674,7 @@ bool EdgeRef::operator<(const Object& _oth) const
 {
   if (_oth.sub_type() != SubType::EDGE_REF)
     return E<Type::EDGE>::operator<(_oth);
-  auto oth = static_cast<const EdgeRef&>(_oth);
+  const auto& oth = static_cast<const EdgeRef&>(_oth);
   return verts_[0] < oth.verts_[0] ||
     (verts_[0] == oth.verts_[0] && verts_[1] < oth.verts_[1]);
 }
@@ -339,7 +683,7 @@ bool EdgeRef::operator==(const Object& _oth) const
 {
   if (_oth.sub_type() != SubType::EDGE_REF)
     return E<Type::EDGE>::operator==(_oth);
-  auto oth = static_cast<const EdgeRef&>(_oth);
+  const auto& oth = static_cast<const EdgeRef&>(_oth);
   return verts_[0] == oth.verts_[0] && verts_[1] == oth.verts_[1];
 }
 
@@ -394,7 +738,7 @@ bool CoEdgeRef::operator<(const Object& _oth) const
 {
   if (_oth.sub_type() != SubType::COEDGE_REF)
     return E<Type::COEDGE>::operator<(_oth);
-  auto oth = static_cast<const CoEdgeRef&>(_oth);
+  const auto& oth = static_cast<const CoEdgeRef&>(_oth);
   return loop_ < oth.loop_ || loop_ == oth.loop_ && ind_ < oth.ind_;
 }
 
@@ -402,7 +746,7 @@ bool CoEdgeRef::operator==(const Object& _oth) const
 {
   if (_oth.sub_type() != SubType::COEDGE_REF)
     return false;
-  auto oth = static_cast<const CoEdgeRef&>(_oth);
+  const auto& oth = static_cast<const CoEdgeRef&>(_oth);
   return loop_ == oth.loop_ && ind_ == oth.ind_;
 }
 
@@ -442,7 +786,7 @@ template <> void object_saver<SubType::VERTEX>(
   save_base_entity<Type::VERTEX>(_ostr, vert, _psav);
   Geo::Point pt;
   vert->geom(pt);
-  _ostr << pt;
+  _ostr << Utils::BinData<Geo::Point>(pt);
   _ostr << Utils::BinData<double>(vert->tolerance());
 }
 
@@ -453,7 +797,11 @@ object_loader<SubType::VERTEX>(std::istream& _istr, ILoader* _pload)
   load_base_entity(_istr, vert.make<EE<Type::VERTEX>>(), _pload);
 
   Geo::Point pt;
-  _istr >> pt;
+  // Text with default precision in version 0.
+  if (_pload->version() == 0)
+    _istr >> pt;
+  else
+    _istr >> Utils::BinData<Geo::Point>(pt);
   vert->set_geom(pt);
   double tol;
   _istr >> Utils::BinData<double>(tol);
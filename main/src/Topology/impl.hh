@@ -2,10 +2,45 @@
 
 #include "Topology.hh"
 
+#include <atomic>
+#include <memory>
 #include <vector>
 
 namespace Topo {
 
+/*! Index of the parents or of the children of an entity, to find them
+    in logarithmic time. It holds the sorted couples (element, position)
+    and it is kept only for vectors of at least MIN_SIZE elements, so
+    faces with few vertices and vertices with few faces do not pay for
+    it. The owner notifies every change of the vector, so searching does
+    not modify the index.
+*/
+class ElementIndex
+{
+public:
+  static const size_t MIN_SIZE = 16;
+
+  // _min_size = SIZE_MAX never builds the index.
+  explicit ElementIndex(size_t _min_size = MIN_SIZE) : min_size_(_min_size) {}
+
+  // To call after the vector has been changed.
+  void inserted(const std::vector<IBase*>& _elems, size_t _pos);
+  void erased(const std::vector<IBase*>& _elems, size_t _pos, const IBase* _el);
+  void replaced(size_t _pos, const IBase* _old_el, const IBase* _new_el);
+  void rebuild(const std::vector<IBase*>& _elems);
+
+  // First position of _el in _elems or SIZE_MAX.
+  size_t find_first(const std::vector<IBase*>& _elems, const IBase* _el) const;
+  // Last position of _el in [0, _end[ or SIZE_MAX.
+  size_t find_last(const std::vector<IBase*>& _elems, const IBase* _el,
+    size_t _end = SIZE_MAX) const;
+
+private:
+  typedef std::pair<const IBase*, size_t> Entry;
+  std::vector<Entry> index_;
+  size_t min_size_;
+};
+
 template <Type typeT> struct Base : public E<typeT>
 {
   virtual size_t size(Direction _dir) const;
@@ -23,8 +58,19 @@ template <Type typeT> struct Base : public E<typeT>
 protected:
   virtual bool remove_parent(IBase* _prnt);
   bool add_parent(IBase* _prnt);
+  void invalidate_parents_geometry()
+  {
+    for (auto prnt : up_elems_)
+      prnt->invalidate_geometry();
+  }
+  void invalidate_parents_topology()
+  {
+    for (auto prnt : up_elems_)
+      prnt->invalidate_topology();
+  }
 
   std::vector<IBase*> up_elems_;
+  ElementIndex up_index_;
 };
 
 template <Type typeT> struct UpEntity : public Base<typeT>
@@ -52,14 +98,20 @@ template <Type typeT> struct UpEntity : public Base<typeT>
 
 protected:
   std::vector<IBase*> low_elems_;
+  ElementIndex low_index_;
 };
 
 template <Type typeT> struct EE;
 
 template <> struct EE<Type::BODY> : public UpEntity<Type::BODY>
 {
+  // Faces are searched in the ordered children (see optimize()), keeping
+  // an index would make adding faces quadratic.
+  EE();
+  ~EE();
   virtual SubType sub_type() const { return SubType::BODY; }
   virtual bool insert_child(IBase* _el, size_t _pos = SIZE_MAX);
+  virtual bool remove_child(size_t _pos);
   virtual bool replace_child(size_t _pos, IBase* _new_obj);
   // search for an element in the range [0, _end[ in reverse order.
   virtual size_t find_child(const IBase* _el, size_t _end = SIZE_MAX) const;
@@ -68,7 +120,42 @@ template <> struct EE<Type::BODY> : public UpEntity<Type::BODY>
   virtual bool EE<Type::BODY>::remove_children(
     std::vector<IBase*>& _faces_to_remove);
 
+  // Edges of the faces, sorted and without repetitions. The table is
+  // built on the first call and kept up to date when faces are inserted,
+  // removed or replaced, so the same edge objects are returned until a
+  // face changes its vertices.
+  const std::vector<Wrap<Type::EDGE>>& edges() const;
+  // Edge of the table between two vertices, empty if it is not there or
+  // if the table is not built: it is never built here, to not rebuild it
+  // for each edge when the faces are being changed.
+  Wrap<Type::EDGE> find_edge(const IBase* _v0, const IBase* _v1) const;
+
+  // Changes every time a face is inserted, removed or replaced or the
+  // children of a face or of a loop change, so elements extracted from
+  // the body can be kept until it changes.
+  size_t generation() const { return generation_; }
+
+  // While deferred, changes of the faces only mark the topology as
+  // changed and the last resume_invalidation() invalidates it once.
+  // split_edges() uses it to not clear the edge table while other
+  // threads are changing faces of the body.
+  void defer_invalidation() { ++deferred_; }
+  void resume_invalidation();
+
   bool ordered_children_ = true;
+
+protected:
+  // Faces of the body can be changed at the same time by different
+  // threads (see split_edges()), so this can be called concurrently
+  // while the invalidation is deferred.
+  virtual void invalidate_topology();
+
+private:
+  struct EdgeTable;
+  std::unique_ptr<EdgeTable> edge_table_;
+  std::atomic<size_t> generation_{ 0 };
+  std::atomic<size_t> deferred_{ 0 };
+  std::atomic<bool> invalidation_pending_{ false };
 };
 
 template <> struct EE<Type::FACE> : public UpEntity<Type::FACE>
@@ -77,12 +164,39 @@ template <> struct EE<Type::FACE> : public UpEntity<Type::FACE>
   virtual bool reverse();
   virtual Geo::Point internal_point() const;
   virtual Geo::Range<3> box() const;
+  // Normal of the outer loop as computed by Geo::IPolygonalFace.
+  const Geo::VectorD3& normal() const;
+  // Best fitting plane of the outer loop vertices (see Geo::IPlaneFit).
+  void plane(Geo::Point& _center, Geo::VectorD3& _normal) const;
   bool check();
+
+protected:
+  virtual void invalidate_geometry() { cached_ = 0; }
+  virtual void invalidate_topology() { invalidate_parents_topology(); }
+
+private:
+  // Geometric properties are computed on demand and kept until a child
+  // is inserted, removed or replaced or a vertex of the face moves.
+  // The cache is not thread safe.
+  enum CacheBit : unsigned char
+  {
+    BOX = 1, CENTROID = 2, NORMAL = 4, PLANE = 8
+  };
+  mutable unsigned char cached_ = 0;
+  mutable Geo::Range<3> box_;
+  mutable Geo::Point centroid_;
+  mutable Geo::VectorD3 normal_;
+  mutable Geo::Point plane_center_;
+  mutable Geo::VectorD3 plane_normal_;
 };
 
 template <> struct EE<Type::LOOP> : public UpEntity<Type::LOOP>
 {
   virtual SubType sub_type() const { return SubType::LOOP; }
+
+protected:
+  virtual void invalidate_geometry() { invalidate_parents_geometry(); }
+  virtual void invalidate_topology() { invalidate_parents_topology(); }
 };
 
 #if 0 // No edge yet
@@ -100,7 +214,7 @@ template <> struct EE<Type::EDGE> : public UpEntity<Type::EDGE>
 template <> struct EE<Type::VERTEX> : public Base<Type::VERTEX>
 {
   virtual bool geom(Geo::Point& _pt) const { _pt = pt_; return true; }
-  virtual bool set_geom(const Geo::Point& _pt) { pt_ = _pt; return true; }
+  virtual bool set_geom(const Geo::Point& _pt);
   virtual double tolerance() const;
   virtual bool set_tolerance(const double _tol) { tol_ = _tol; return true;  }
   virtual SubType sub_type() const { return SubType::VERTEX; }
@@ -2,8 +2,10 @@
 #include "impl.hh"
 #include "iterator.hh"
 #include "subtype.hh"
+#include "view.hh"
 
 #include "Utils/error_handling.hh"
+#include "Utils/parallel.hh"
 
 #include <map>
 #include <vector>
@@ -89,25 +91,6 @@ struct AddIterElement : public IterElement
   }
 };
 
-template <Topo::Type typeT>
-struct AddIterUniqueElement : public AddIterElement<typeT>
-{
-  using AddIterElement::AddIterElement;
-  std::set<Wrap<typeT>> elems_set_;
-  virtual bool add(IBase* _el) override
-  {
-    if (elems_set_.insert(static_cast<E<typeT>*>(_el)).second)
-      elems_.push_back(static_cast<E<typeT>*>(_el));
-    return true;
-  }
-};
-
-template <Type from_typeT, Type to_typeT> struct AddElementSelector
-{ typedef AddIterElement<to_typeT> Value; };
-
-template <> struct AddElementSelector<Type::BODY, Type::VERTEX>
-{ typedef AddIterUniqueElement<Type::VERTEX> Value; };
-
 template <Direction dirT, Type to_typeT>
 bool topo_iterate(IBase* _from, IterElement& _op)
 {
@@ -125,12 +108,33 @@ bool topo_iterate(IBase* _from, IterElement& _op)
 template <Type from_typeT, Type to_typeT>
 void get_elements(const Wrap<from_typeT>& _from, std::vector<Wrap<to_typeT>>& _elems)
 {
-  AddElementSelector<from_typeT, to_typeT>::Value add_elems(_elems);
+  AddIterElement<to_typeT> add_elems(_elems);
   const Direction dir = from_typeT > to_typeT ? Direction::Down : Direction::Up;
   topo_iterate<dir, to_typeT>(
     const_cast<IBase*>(static_cast<const IBase*>(_from.get())), add_elems);
 }
 
+// The edge of the body table (see EE<Type::BODY>::edges()) if the loop
+// or face _loop is in a body with the table built, else a new edge.
+Wrap<Type::EDGE> make_edge(const IBase* _loop, IBase* _v0, IBase* _v1)
+{
+  auto body = _loop;
+  while (body != nullptr && body->type() != Type::BODY)
+    body = body->get(Direction::Up, 0);
+  if (body != nullptr && body->sub_type() == SubType::BODY)
+  {
+    auto edge = static_cast<const EE<Type::BODY>*>(body)->find_edge(_v0, _v1);
+    if (edge)
+      return edge;
+  }
+  Wrap<Type::EDGE> edg_wrp;
+  auto edg = edg_wrp.make<EdgeRef>();
+  edg->verts_[0] = static_cast<E<Type::VERTEX>*>(_v0);
+  edg->verts_[1] = static_cast<E<Type::VERTEX>*>(_v1);
+  edg->finalise();
+  return edg_wrp;
+}
+
 bool base_ptr_less(const IBase* _a, const IBase* _b)
 {
   if (_a == _b)
@@ -174,13 +178,9 @@ struct BodyIteratorToEdge : public BodyIteratorBase<Type::EDGE>
       }
       virtual bool process(IBase* _from, size_t _i)
       {
-        Wrap<Type::EDGE> edg_wrp;
-        auto edg = edg_wrp.make<EdgeRef>();
-        edg->verts_[0] = static_cast<E<Type::VERTEX>*>(_from->get(Direction::Down, _i));
+        auto v0 = _from->get(Direction::Down, _i);
         if (++_i >= _from->size(Direction::Down)) _i = 0;
-        edg->verts_[1] = static_cast<E<Type::VERTEX>*>(_from->get(Direction::Down, _i));
-        edg->finalise();
-        elems_.push_back(edg);
+        elems_.push_back(make_edge(_from, v0, _from->get(Direction::Down, _i)));
         return true;
       }
     };
@@ -190,9 +190,64 @@ struct BodyIteratorToEdge : public BodyIteratorBase<Type::EDGE>
   }
 };
 
+// Bodies keep their edges.
 template <>
-struct Iterator<Type::BODY, Type::EDGE>::Impl : public BodyIteratorToEdge<Type::BODY>
-{};
+struct Iterator<Type::BODY, Type::EDGE>::Impl : public BodyIteratorBase<Type::EDGE>
+{
+  void reset(const Wrap<Type::BODY>& _from)
+  {
+    THROW_IF(_from->sub_type() != SubType::BODY, "Wrong type");
+    elems_ = static_cast<const EE<Type::BODY>*>(_from.get())->edges();
+  }
+};
+
+/* Big bodies are split in chunks of faces that collect their vertices
+   in parallel, smaller ones are a single chunk: a thread start costs
+   more than the traversal of some thousands faces. Every chunk has its
+   own mark and a vertex keeps the mark of the first chunk that meets it
+   (see IBase::visit_first()), so the chunk lists joined in order keeping
+   the vertices with the chunk mark have the order of a serial traversal.
+   Threads collect plain pointers, the Wraps are made by the calling
+   thread.
+*/
+template <>
+struct Iterator<Type::BODY, Type::VERTEX>::Impl : public BodyIteratorBase<Type::VERTEX>
+{
+  void reset(const Wrap<Type::BODY>& _from)
+  {
+    clear();
+    THROW_IF(_from->sub_type() != SubType::BODY, "Wrong type");
+    static constexpr size_t CHUNK = 16384;
+    const IBase* body = _from.get();
+    const auto face_nmbr = body->size(Direction::Down);
+    std::vector<std::vector<E<Type::VERTEX>*>> chunk_verts(
+      std::max<size_t>(1, (face_nmbr + CHUNK - 1) / CHUNK));
+    const auto first_mark = IBase::new_mark(chunk_verts.size());
+    Utils::parallel_for(chunk_verts.size(),
+      [body, face_nmbr, first_mark, &chunk_verts](size_t _c)
+    {
+      const auto mark = first_mark + _c;
+      auto& verts = chunk_verts[_c];
+      const auto end = std::min(face_nmbr, (_c + 1) * CHUNK);
+      for (auto i = _c * CHUNK; i < end; ++i)
+      {
+        for (auto vert : View<Type::VERTEX>(body->get(Direction::Down, i)))
+        {
+          if (vert->visit_first(first_mark, mark))
+            verts.push_back(vert);
+        }
+      }
+    }, 1);
+    for (size_t c = 0; c < chunk_verts.size(); ++c)
+    {
+      for (auto vert : chunk_verts[c])
+      {
+        if (vert->marked(first_mark + c))
+          elems_.emplace_back(vert);
+      }
+    }
+  }
+};
 
 template <>
 struct Iterator<Type::EDGE, Type::VERTEX>::Impl : public BodyIteratorBase<Type::VERTEX>
@@ -236,12 +291,7 @@ struct Iterator<Type::VERTEX, Type::EDGE>::Impl : public BodyIteratorBase<Type::
           Wrap<Type::VERTEX> vert(static_cast<E<Type::VERTEX>*>(vert_oth));
           if (!already_used.insert(vert).second)
             continue;
-          Wrap<Type::EDGE> edge;
-          auto edref = edge.make<EdgeRef>();
-          edref->verts_[0] = _from;
-          edref->verts_[1].reset(static_cast<E<Type::VERTEX>*>(vert.get()));
-          edref->finalise();
-          elems_.emplace_back(edge);
+          elems_.emplace_back(make_edge(face, _from.get(), vert.get()));
         }
       }
     }
@@ -386,15 +436,9 @@ struct Iterator<Type::COEDGE, Type::EDGE>::Impl : public BodyIteratorBase<Type::
     if (second > coedge_ref->loop()->size(Direction::Down))
       second = 0;
 
-    Wrap<Type::EDGE> edge;
-    auto edref = edge.make<EdgeRef>();
-    auto v0 = static_cast<E<Type::VERTEX>*>(
-      coedge_ref->loop()->get(Direction::Down, coedge_ref->ind_));
-    edref->verts_[0].reset(v0);
-    auto v1 = static_cast<E<Type::VERTEX>*>(coedge_ref->loop()->get(Direction::Down, second));
-    edref->verts_[1].reset(v1);
-    edref->finalise();
-    elems_.emplace_back(edge);
+    auto loop = coedge_ref->loop();
+    elems_.emplace_back(make_edge(loop,
+      loop->get(Direction::Down, coedge_ref->ind_), loop->get(Direction::Down, second)));
   }
 };
 
@@ -5,6 +5,15 @@
 
 namespace Topo {
 
+/*! Collects the elements of type ToT reached from an element.
+    Iterator<BODY, VERTEX> returns each vertex once, in the order of the
+    first face that uses it (the order it always had, the set it used
+    only removed repetitions). It skips the vertices already met with
+    visit marks of the vertices (see IBase::visit_first()), so two traversals
+    of bodies sharing vertices, or a unique View of the same vertices,
+    must not run at the same time: the marks would overwrite each other
+    giving repeated or missing vertices.
+*/
 template <Type FromT, Type ToT> struct Iterator
 {
   Iterator();
@@ -0,0 +1,391 @@
+#include "journal.hh"
+#include "impl.hh"
+#include "view.hh"
+
+#include <Utils/bindata.hh>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+namespace Topo {
+
+namespace {
+
+const char MAGIC[8] = { 'T', 'O', 'P', 'O', 'J', 'R', 'N', 'L' };
+const uint32_t VERSION = 1;
+
+// A record is its kind and its number of elements followed by them. In
+// a checkpoint faces come after the vertices they use.
+enum class Record : uint32_t
+{
+  VERTICES,         // key, point, tolerance of new or moved vertices
+  FACES_ADDED,      // key and signature (see JournalWriter::face_signature)
+  FACES_REMOVED,    // key
+  VERTICES_REMOVED, // key
+  CHECKPOINT        // no elements, ends a checkpoint
+};
+
+// Elements of a record written in chunks of JournalWriter::CHUNK.
+class ChunkWriter
+{
+public:
+  ChunkWriter(std::ostream& _str, Record _rec) : str_(_str), rec_(_rec) {}
+
+  template <typename DataT> void write(const DataT& _dat)
+  {
+    auto ptr = reinterpret_cast<const char*>(&_dat);
+    buf_.insert(buf_.end(), ptr, ptr + sizeof(DataT));
+  }
+  void end_element()
+  {
+    if (++nmbr_ == JournalWriter::CHUNK)
+      flush();
+  }
+  void flush()
+  {
+    if (nmbr_ == 0)
+      return;
+    str_ << Utils::BinData<uint32_t>(uint32_t(rec_));
+    str_ << Utils::BinData<uint32_t>(nmbr_);
+    str_.write(buf_.data(), buf_.size());
+    buf_.clear();
+    nmbr_ = 0;
+  }
+
+private:
+  std::ostream& str_;
+  Record rec_;
+  uint32_t nmbr_ = 0;
+  std::vector<char> buf_;
+};
+
+template <typename DataT> bool read(std::istream& _str, DataT& _dat)
+{
+  _str.read(reinterpret_cast<char*>(&_dat), sizeof(DataT));
+  return _str.gcount() == sizeof(DataT);
+}
+
+}//namespace
+
+JournalWriter::JournalWriter(std::ostream& _str)
+  : str_(&_str), header_written_(_str.tellp() > 0) {}
+
+// Has loops flag, number of loops and for each loop its size and its
+// vertex keys; faces without loop children are one loop.
+void JournalWriter::face_signature(const IBase* _face, std::vector<uint64_t>& _sign) const
+{
+  _sign.clear();
+  auto add_loop = [this, &_sign](const IBase* _loop)
+  {
+    const auto size = _loop->size(Direction::Down);
+    _sign.push_back(size);
+    for (size_t i = 0; i < size; ++i)
+      _sign.push_back(verts_.at(_loop->get(Direction::Down, i)->id()).key_);
+  };
+  const auto size = _face->size(Direction::Down);
+  const bool has_loops = size > 0 &&
+    _face->get(Direction::Down, 0)->type() == Type::LOOP;
+  _sign.push_back(has_loops);
+  if (has_loops)
+  {
+    _sign.push_back(size);
+    for (size_t i = 0; i < size; ++i)
+      add_loop(_face->get(Direction::Down, i));
+  }
+  else
+  {
+    _sign.push_back(1);
+    add_loop(_face);
+  }
+}
+
+void JournalWriter::checkpoint(const Wrap<Type::BODY>& _body)
+{
+  if (!header_written_)
+  {
+    str_->write(MAGIC, sizeof(MAGIC));
+    *str_ << Utils::BinData<uint32_t>(VERSION);
+    header_written_ = true;
+  }
+  ++stamp_;
+  ChunkWriter vert_rec(*str_, Record::VERTICES);
+  for (auto vert : unique_view<Type::VERTEX>(_body))
+  {
+    Geo::Point pt;
+    vert->geom(pt);
+    const auto tol = vert->tolerance();
+    auto pos = verts_.emplace(vert->id(), VertexState());
+    auto& state = pos.first->second;
+    state.stamp_ = stamp_;
+    if (pos.second)
+      state.key_ = next_key_++;
+    else if (state.pt_ == pt && state.tol_ == tol)
+      continue;
+    state.pt_ = pt;
+    state.tol_ = tol;
+    vert_rec.write(state.key_);
+    vert_rec.write(pt);
+    vert_rec.write(tol);
+    vert_rec.end_element();
+  }
+  vert_rec.flush();
+
+  // A changed face is removed and added again with a new key.
+  ChunkWriter add_rec(*str_, Record::FACES_ADDED);
+  ChunkWriter rem_rec(*str_, Record::FACES_REMOVED);
+  std::vector<uint64_t> sign;
+  for (auto face : view<Type::FACE>(_body))
+  {
+    face_signature(face, sign);
+    auto pos = faces_.emplace(face->id(), FaceState());
+    auto& state = pos.first->second;
+    state.stamp_ = stamp_;
+    if (!pos.second)
+    {
+      if (state.sign_ == sign)
+        continue;
+      rem_rec.write(state.key_);
+      rem_rec.end_element();
+    }
+    state.key_ = next_key_++;
+    state.sign_.swap(sign);
+    add_rec.write(state.key_);
+    for (auto val : state.sign_)
+      add_rec.write(val);
+    add_rec.end_element();
+  }
+  add_rec.flush();
+  for (auto it = faces_.begin(); it != faces_.end();)
+  {
+    if (it->second.stamp_ == stamp_)
+    {
+      ++it;
+      continue;
+    }
+    rem_rec.write(it->second.key_);
+    rem_rec.end_element();
+    it = faces_.erase(it);
+  }
+  rem_rec.flush();
+
+  ChunkWriter vert_rem_rec(*str_, Record::VERTICES_REMOVED);
+  for (auto it = verts_.begin(); it != verts_.end();)
+  {
+    if (it->second.stamp_ == stamp_)
+    {
+      ++it;
+      continue;
+    }
+    vert_rem_rec.write(it->second.key_);
+    vert_rem_rec.end_element();
+    it = verts_.erase(it);
+  }
+  vert_rem_rec.flush();
+
+  *str_ << Utils::BinData<uint32_t>(uint32_t(Record::CHECKPOINT));
+  *str_ << Utils::BinData<uint32_t>(0);
+  str_->flush();
+  ++checkpoint_nmbr_;
+}
+
+void JournalWriter::resume(const JournalReader& _reader)
+{
+  verts_.clear();
+  faces_.clear();
+  for (const auto& key_vert : _reader.verts_)
+  {
+    auto& state = verts_[key_vert.second->id()];
+    state.key_ = key_vert.first;
+    state.stamp_ = stamp_;
+    key_vert.second->geom(state.pt_);
+    state.tol_ = key_vert.second->tolerance();
+  }
+  for (const auto& key_face : _reader.faces_)
+  {
+    auto& state = faces_[key_face.second->id()];
+    state.key_ = key_face.first;
+    state.stamp_ = stamp_;
+    face_signature(key_face.second.get(), state.sign_);
+  }
+  next_key_ = _reader.max_key_ + 1;
+  checkpoint_nmbr_ = _reader.checkpoint_nmbr_;
+  // A stream opened to append can be at its start before the first write.
+  header_written_ |= _reader.header_read_;
+}
+
+bool JournalWriter::truncate(const std::string& _file, const JournalReader& _reader)
+{
+  std::error_code err;
+  std::filesystem::resize_file(_file, _reader.position(), err);
+  return !err;
+}
+
+JournalReader::JournalReader(std::istream& _str) : str_(&_str)
+{
+  body_.make<EE<Type::BODY>>();
+}
+
+bool JournalReader::read_header()
+{
+  char magic[sizeof(MAGIC)];
+  uint32_t version;
+  return read(*str_, magic) && memcmp(magic, MAGIC, sizeof(MAGIC)) == 0 &&
+    read(*str_, version) && version == VERSION;
+}
+
+bool JournalReader::next()
+{
+  if (truncated_)
+    return false;
+  if (!header_read_)
+  {
+    if (!read_header())
+      return false;
+    header_read_ = true;
+    position_ = str_->tellg();
+  }
+  // Changes are staged and applied to the body only when the end of the
+  // checkpoint is read, so a truncated checkpoint leaves no trace.
+  std::unordered_map<uint64_t, Wrap<Type::VERTEX>> new_verts;
+  struct VertexMove
+  {
+    Wrap<Type::VERTEX> vert_;
+    Geo::Point pt_;
+    double tol_;
+  };
+  std::vector<VertexMove> moved_verts;
+  std::vector<std::pair<uint64_t, Wrap<Type::FACE>>> added_faces;
+  std::vector<uint64_t> removed_faces, removed_verts;
+  uint64_t max_key = max_key_;
+  bool started = false;
+  auto stop = [this, &started]()
+  {
+    truncated_ = started;
+    str_->clear();
+    str_->seekg(position_);
+    return false;
+  };
+  auto find_vertex = [this, &new_verts](uint64_t _key)
+  {
+    auto vert = new_verts.find(_key);
+    if (vert != new_verts.end())
+      return vert->second.get();
+    auto old_vert = verts_.find(_key);
+    return old_vert == verts_.end() ? nullptr : old_vert->second.get();
+  };
+  for (;;)
+  {
+    uint32_t rec, nmbr;
+    if (!read(*str_, rec) || !read(*str_, nmbr))
+      return stop();
+    started = true;
+    // Unknown records are corrupt even without elements.
+    if (rec > uint32_t(Record::CHECKPOINT))
+      return stop();
+    for (uint32_t i = 0; i < nmbr; ++i)
+    {
+      uint64_t key;
+      if (!read(*str_, key))
+        return stop();
+      max_key = std::max(max_key, key);
+      switch (Record(rec))
+      {
+      case Record::VERTICES:
+      {
+        Geo::Point pt;
+        double tol;
+        if (!read(*str_, pt) || !read(*str_, tol))
+          return stop();
+        auto old_vert = verts_.find(key);
+        if (old_vert != verts_.end())
+        {
+          moved_verts.push_back({ old_vert->second, pt, tol });
+          break;
+        }
+        auto& vert = new_verts[key];
+        vert.make<EE<Type::VERTEX>>();
+        vert->set_geom(pt);
+        vert->set_tolerance(tol);
+        break;
+      }
+      case Record::FACES_ADDED:
+      {
+        uint64_t has_loops, loop_nmbr;
+        if (!read(*str_, has_loops) || !read(*str_, loop_nmbr))
+          return stop();
+        added_faces.emplace_back(key, Wrap<Type::FACE>());
+        auto& face = added_faces.back().second;
+        face.make<EE<Type::FACE>>();
+        for (uint64_t l = 0; l < loop_nmbr; ++l)
+        {
+          IBase* parent = face.get();
+          Wrap<Type::LOOP> loop;
+          if (has_loops)
+          {
+            loop.make<EE<Type::LOOP>>();
+            face->insert_child(loop.get());
+            parent = loop.get();
+          }
+          uint64_t size;
+          if (!read(*str_, size))
+            return stop();
+          for (uint64_t j = 0; j < size; ++j)
+          {
+            uint64_t vert_key;
+            if (!read(*str_, vert_key))
+              return stop();
+            auto vert = find_vertex(vert_key);
+            if (vert == nullptr)
+              return stop();
+            parent->insert_child(vert);
+          }
+        }
+        break;
+      }
+      case Record::FACES_REMOVED:
+        removed_faces.push_back(key);
+        break;
+      case Record::VERTICES_REMOVED:
+        removed_verts.push_back(key);
+        break;
+      default:
+        return stop();
+      }
+    }
+    if (Record(rec) == Record::CHECKPOINT)
+      break;
+  }
+  for (const auto& move : moved_verts)
+  {
+    move.vert_->set_geom(move.pt_);
+    move.vert_->set_tolerance(move.tol_);
+  }
+  for (auto& key_vert : new_verts)
+    verts_.emplace(key_vert.first, std::move(key_vert.second));
+  auto body = static_cast<EE<Type::BODY>*>(body_.get());
+  for (const auto& key_face : added_faces)
+  {
+    faces_[key_face.first] = key_face.second;
+    body->insert_child(key_face.second.get());
+  }
+  // Faces are searched in the children ordered by id, that is in order
+  // of creation.
+  body->optimize();
+  for (auto key : removed_faces)
+  {
+    auto face = faces_.find(key);
+    if (face == faces_.end())
+      continue;
+    body_->remove_child(face->second.get());
+    faces_.erase(face);
+  }
+  for (auto key : removed_verts)
+    verts_.erase(key);
+  max_key_ = max_key;
+  position_ = str_->tellg();
+  ++checkpoint_nmbr_;
+  return true;
+}
+
+}//namespace Topo
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "topology.hh"
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Topo {
+
+class JournalReader;
+
+/*! Append only log of the states of a body made of faces and vertices,
+    to checkpoint the stages of a long computation. The first checkpoint
+    writes the whole body, the next ones only the vertices created or
+    moved and the faces created, changed or removed since the previous
+    one. Records of at most CHUNK elements go straight to the stream, so
+    nothing but the state of the last checkpoint is kept: a key and the
+    position of every vertex and a key and the vertex keys of every face.
+*/
+class JournalWriter
+{
+public:
+  static const size_t CHUNK = 4096;
+
+  // A new journal if the stream is at its start, else the stream holds
+  // a journal and resume() must be called before the first checkpoint.
+  explicit JournalWriter(std::ostream& _str);
+
+  void checkpoint(const Wrap<Type::BODY>& _body);
+  size_t checkpoint_count() const { return checkpoint_nmbr_; }
+
+  // Continues the journal read by _reader, the next checkpoint writes
+  // the changes of _reader.body(). The stream must be at
+  // _reader.position() with nothing after it, a journal file cut inside
+  // a checkpoint must be truncated first (see truncate()).
+  void resume(const JournalReader& _reader);
+
+  // Removes from the journal file _file what follows the last complete
+  // checkpoint read by _reader.
+  static bool truncate(const std::string& _file, const JournalReader& _reader);
+
+private:
+  struct VertexState
+  {
+    uint64_t key_;
+    uint64_t stamp_;
+    Geo::Point pt_;
+    double tol_;
+  };
+  struct FaceState
+  {
+    uint64_t key_;
+    uint64_t stamp_;
+    std::vector<uint64_t> sign_;
+  };
+  void face_signature(const IBase* _face, std::vector<uint64_t>& _sign) const;
+
+  std::ostream* str_;
+  std::unordered_map<Identifier, VertexState> verts_;
+  std::unordered_map<Identifier, FaceState> faces_;
+  uint64_t next_key_ = 1;
+  uint64_t stamp_ = 0;
+  size_t checkpoint_nmbr_ = 0;
+  bool header_written_;
+};
+
+/*! Reads a journal written by JournalWriter applying one checkpoint at
+    a time to body(). Faces are in the order of their creation in the
+    journal.
+*/
+class JournalReader
+{
+public:
+  explicit JournalReader(std::istream& _str);
+
+  // Applies the next checkpoint, false at the end of the journal. If
+  // the journal ends inside a checkpoint, truncated() is true and the
+  // body is the one of the last complete checkpoint.
+  bool next();
+  bool truncated() const { return truncated_; }
+
+  const Wrap<Type::BODY>& body() const { return body_; }
+  size_t checkpoint_count() const { return checkpoint_nmbr_; }
+  // Stream position after the last complete checkpoint.
+  std::streamoff position() const { return position_; }
+
+private:
+  friend class JournalWriter;
+  bool read_header();
+
+  std::istream* str_;
+  Wrap<Type::BODY> body_;
+  std::unordered_map<uint64_t, Wrap<Type::VERTEX>> verts_;
+  std::unordered_map<uint64_t, Wrap<Type::FACE>> faces_;
+  uint64_t max_key_ = 0;
+  size_t checkpoint_nmbr_ = 0;
+  std::streamoff position_ = 0;
+  bool header_read_ = false;
+  bool truncated_ = false;
+};
+
+}//namespace Topo
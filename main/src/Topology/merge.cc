@@ -1,6 +1,9 @@
 #include "merge.hh"
 #include "shared.hh"
 
+#include <Utils/error_handling.hh>
+
+#include <unordered_map>
 
 namespace Topo {
 
@@ -22,5 +25,60 @@ template<> bool merge<Type::VERTEX>(
   return true;
 }
 
+size_t merge(const std::vector<Wrap<Type::VERTEX>>& _verts,
+  Utils::UnionFind& _classes)
+{
+  THROW_IF(_classes.size() != _verts.size(), "Wrong vertex classes");
+  struct ClassData
+  {
+    Geo::Point sum_ = {};
+    size_t nmbr_ = 0;
+    double tol_ = 0;
+  };
+  std::vector<ClassData> class_datas(_verts.size());
+  // Replaced vertex to its representative and the parents to change.
+  std::unordered_map<const IBase*, IBase*> replacements;
+  std::vector<IBase*> parents;
+  const auto mark = IBase::new_mark();
+  for (size_t i = 0; i < _verts.size(); ++i)
+  {
+    const auto repr = _classes.find(i);
+    Geo::Point pt;
+    _verts[i]->geom(pt);
+    auto& data = class_datas[repr];
+    data.sum_ += pt;
+    ++data.nmbr_;
+    data.tol_ = std::max(data.tol_, _verts[i]->tolerance());
+    if (repr == i)
+      continue;
+    replacements.emplace(_verts[i].get(), _verts[repr].get());
+    for (size_t j = 0; j < _verts[i]->size(Direction::Up); ++j)
+    {
+      auto parent = _verts[i]->get(Direction::Up, j);
+      if (parent->visit(mark))
+        parents.push_back(parent);
+    }
+  }
+  for (auto parent : parents)
+  {
+    for (size_t j = 0; j < parent->size(Direction::Down); ++j)
+    {
+      auto child = parent->get(Direction::Down, j);
+      auto repl = replacements.find(child);
+      if (repl != replacements.end())
+        parent->replace_child(child, repl->second);
+    }
+  }
+  for (size_t i = 0; i < _verts.size(); ++i)
+  {
+    const auto& data = class_datas[i];
+    if (data.nmbr_ < 2)
+      continue;
+    _verts[i]->set_geom(data.sum_ / double(data.nmbr_));
+    _verts[i]->set_tolerance(data.tol_);
+  }
+  return replacements.size();
+}
+
 
 }
@@ -2,8 +2,20 @@
 
 #include "topology.hh"
 
+#include <Utils/union_find.hh>
+
+#include <vector>
+
 namespace Topo {
 
 template <Type tyT> bool merge(Wrap<tyT> _a, Wrap<tyT> _b, double _vert_coeff = 0.5);
 
+// Merges all the classes of _classes, made of indices of the distinct
+// vertices _verts, in one pass over their faces and loops. Every class
+// becomes its representative vertex, moved to the average point of the
+// class with the biggest tolerance. Returns the number of vertices
+// replaced.
+size_t merge(const std::vector<Wrap<Type::VERTEX>>& _verts,
+  Utils::UnionFind& _classes);
+
 }
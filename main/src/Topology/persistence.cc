@@ -1,9 +1,13 @@
 #include "persistence.hh"
 #include "Utils/bindata.hh"
+#include "Utils/error_handling.hh"
 
-#include <functional>
-#include <map>
-#include <set>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 namespace Topo
 {
@@ -20,32 +24,86 @@ struct PersistenceFunctions
   LoadFunction _load_fun;
 };
 
-struct PersistenceMap
+const size_t SUBTYPE_NMBR = size_t(SubType::ENUM_SIZE);
+
+// Functions of every sub type, in order of SubType.
+template <size_t... subtypesT>
+constexpr std::array<PersistenceFunctions, SUBTYPE_NMBR> make_persistence_table(
+  std::index_sequence<subtypesT...>)
+{
+  return { { { object_saver<SubType(subtypesT)>, object_loader<SubType(subtypesT)> }... } };
+}
+
+const std::array<PersistenceFunctions, SUBTYPE_NMBR> pers_table__ =
+  make_persistence_table(std::make_index_sequence<SUBTYPE_NMBR>());
+
+const char MAGIC[8] = { 'T', 'O', 'P', 'O', 'P', 'E', 'R', 'S' };
+
+/*! Loaded objects by saved id: open addressing with linear probing in
+    a power of two table at most half full. The slot is given by the high
+    bits of the id times an odd constant (Fibonacci hashing), so ids with
+    a power of two stride do not cluster.
+*/
+class IdTable
 {
-  PersistenceMap()
+public:
+  // Null if _id has not been loaded.
+  const WrapObject* find(size_t _id) const
   {
-    fill_persistence_map<int(SubType::ENUM_SIZE) - 1>();
+    if (slots_.empty())
+      return nullptr;
+    const auto& slot = slots_[find_slot(_id)];
+    return slot.used_ ? &slot.obj_ : nullptr;
   }
-  const PersistenceFunctions& operator[](SubType _sb)
+
+  void insert(size_t _id, const WrapObject& _obj)
   {
-    return save_functs_[_sb];
+    if (2 * (size_ + 1) > slots_.size())
+      grow();
+    auto& slot = slots_[find_slot(_id)];
+    if (!slot.used_)
+      ++size_;
+    slot.id_ = _id;
+    slot.used_ = true;
+    slot.obj_ = _obj;
   }
 
 private:
-  typedef std::map<SubType, PersistenceFunctions> SaveMapInt;
-  SaveMapInt save_functs_;
+  struct Slot
+  {
+    size_t id_ = 0;
+    bool used_ = false;
+    WrapObject obj_;
+  };
 
-  template <int _sb> void fill_persistence_map()
+  size_t find_slot(size_t _id) const
   {
-    auto& pers_funs = save_functs_[SubType(_sb)];
-    pers_funs._load_fun = object_loader<SubType(_sb)>;
-    pers_funs._sav_fun = object_saver<SubType(_sb)>;
-    fill_persistence_map<_sb - 1>();
+    const auto mask = slots_.size() - 1;
+    auto i = size_t((uint64_t(_id) * 0x9E3779B97F4A7C15ull) >> shift_);
+    while (slots_[i].used_ && slots_[i].id_ != _id)
+      i = (i + 1) & mask;
+    return i;
+  }
+
+  void grow()
+  {
+    std::vector<Slot> old_slots(std::max<size_t>(2 * slots_.size(), 64));
+    old_slots.swap(slots_);
+    // 64 - log2 of the number of slots.
+    shift_ = 64;
+    for (auto size = slots_.size(); size > 1; size /= 2)
+      --shift_;
+    for (auto& slot : old_slots)
+    {
+      if (slot.used_)
+        slots_[find_slot(slot.id_)] = std::move(slot);
+    }
   }
-  template <> void fill_persistence_map<-1>() {}
-};
 
-static PersistenceMap pers_map__;
+  std::vector<Slot> slots_;
+  size_t size_ = 0;
+  unsigned shift_ = 64;
+};
 
 }// namespace
 
@@ -55,7 +113,8 @@ struct Saver : public ISaver
   void save(const Object* _obj) override;
 private:
   std::ostream* str_;
-  std::set<const Object*> saved_objs_;
+  std::unordered_set<const Object*> saved_objs_;
+  bool header_written_ = false;
 };
 
 std::shared_ptr<ISaver> ISaver::make(std::ostream& _str)
@@ -65,20 +124,31 @@ std::shared_ptr<ISaver> ISaver::make(std::ostream& _str)
 
 void Saver::save(const Object* _obj)
 {
+  if (!header_written_)
+  {
+    str_->write(MAGIC, sizeof(MAGIC));
+    *str_ << Utils::BinData<uint32_t>(PERSISTENCE_VERSION);
+    header_written_ = true;
+  }
   *str_ << Utils::BinData<size_t>(_obj->id());
   if (!saved_objs_.insert(_obj).second)
     return;
   *str_ << Utils::BinData<size_t>(size_t(_obj->sub_type()));
-  pers_map__[_obj->sub_type()]._sav_fun(*str_, _obj, this);
+  pers_table__[size_t(_obj->sub_type())]._sav_fun(*str_, _obj, this);
 }
 
 struct Loader : public ILoader
 {
   Loader(std::istream* _str) : str_(_str) {}
   virtual WrapObject load() override;
+  virtual uint32_t version() const override { return version_; }
 private:
+  void read_header();
+
   std::istream* str_;
-  std::map<size_t, WrapObject> loaded_objs_;
+  IdTable loaded_objs_;
+  bool header_read_ = false;
+  uint32_t version_ = 0;
 };
 
 std::shared_ptr<ILoader> ILoader::make(std::istream& _str)
@@ -86,19 +156,39 @@ std::shared_ptr<ILoader> ILoader::make(std::istream& _str)
   return std::make_shared<Loader>(&_str);
 }
 
+// Streams without the header are version 0.
+void Loader::read_header()
+{
+  header_read_ = true;
+  const auto start = str_->tellg();
+  char magic[sizeof(MAGIC)];
+  str_->read(magic, sizeof(MAGIC));
+  if (str_->gcount() != sizeof(MAGIC) ||
+      !std::equal(magic, magic + sizeof(MAGIC), MAGIC))
+  {
+    str_->clear();
+    str_->seekg(start);
+    return;
+  }
+  *str_ >> Utils::BinData<uint32_t>(version_);
+  THROW_IF(version_ > PERSISTENCE_VERSION, "Unknown persistence version");
+}
+
 WrapObject Loader::load()
 {
+  if (!header_read_)
+    read_header();
   size_t id;
   *str_ >> Utils::BinData<size_t>(id);
-  auto it = loaded_objs_.emplace(id, nullptr);
-  if (it.second)
-  {
-    size_t sub_ty;
-    *str_ >> Utils::BinData<size_t>(sub_ty);
-    it.first->second =
-      pers_map__[Topo::SubType(sub_ty)]._load_fun(*str_, this);
-  }
-  return it.first->second;
+  if (auto obj = loaded_objs_.find(id))
+    return *obj;
+  size_t sub_ty;
+  *str_ >> Utils::BinData<size_t>(sub_ty);
+  THROW_IF(sub_ty >= pers_table__.size(), "Unknown sub type");
+  // Loading the children can grow the table, the object is inserted after.
+  auto obj = pers_table__[sub_ty]._load_fun(*str_, this);
+  loaded_objs_.insert(id, obj);
+  return obj;
 }
 
 }//banespace Topo
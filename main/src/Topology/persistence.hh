@@ -1,6 +1,7 @@
 
 #include "topology.hh"
 
+#include <cstdint>
 #include <memory>
 #include <iostream>
 
@@ -14,9 +15,18 @@ struct ISaver
 
 template <SubType> void object_saver(std::ostream&, const Object*, ISaver*);
 
+/*! Version of the format written by ISaver, in a header before the
+    first object. Streams without header are version 0, written before
+    the header was introduced, with vertex positions in text.
+    Version 1 writes the positions in binary.
+*/
+const uint32_t PERSISTENCE_VERSION = 1;
+
 struct ILoader
 {
   virtual WrapObject load() = 0;
+  // Version of the stream, known after the first load().
+  virtual uint32_t version() const = 0;
   static std::shared_ptr<ILoader> make(std::istream& _str);
 };
 
@@ -0,0 +1,355 @@
+#include "pool.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace Topo {
+
+namespace {
+
+const size_t SLAB_SIZE = size_t(1) << 16;
+// Slab header, keeps the block alignment.
+const size_t HEADER_SIZE = 64;
+const size_t GRANULE = 16;
+const size_t CLASS_NMBR = Pool::MAX_BLOCK / GRANULE;
+// Blocks moved between the shared state and a thread at once.
+const size_t BATCH_SIZE = 64;
+// Free blocks a thread keeps for each size class, the exceeding ones
+// go back to the shared lists.
+const size_t MAX_CACHED = 4 * BATCH_SIZE;
+
+struct Slab
+{
+  // Null for the shared pools.
+  Arena::Data* arena_;
+  // Blocks cut from a shared slab and blocks of it found free by
+  // Pool::trim().
+  size_t cut_;
+  size_t free_;
+};
+
+Slab* new_slab(Arena::Data* _arena)
+{
+  auto slab = static_cast<Slab*>(
+    ::operator new(SLAB_SIZE, std::align_val_t(SLAB_SIZE)));
+  slab->arena_ = _arena;
+  slab->cut_ = slab->free_ = 0;
+  return slab;
+}
+
+void delete_slab(Slab* _slab)
+{
+  ::operator delete(_slab, std::align_val_t(SLAB_SIZE));
+}
+
+Slab* slab_of(void* _ptr)
+{
+  return reinterpret_cast<Slab*>(
+    reinterpret_cast<std::uintptr_t>(_ptr) & ~(SLAB_SIZE - 1));
+}
+
+size_t size_class(size_t _size)
+{
+  return (_size + GRANULE - 1) / GRANULE - 1;
+}
+
+struct FreeBlock
+{
+  FreeBlock* next_;
+};
+
+// Slabs of the shared pools and the blocks given back by the threads.
+// It is never destroyed: objects can be deleted during the static
+// destruction.
+struct Shared
+{
+  std::mutex mtx_;
+  FreeBlock* free_[CLASS_NMBR] = {};
+  std::vector<Slab*> slabs_;
+  char* cur_ = nullptr;
+  char* end_ = nullptr;
+
+  static Shared& get()
+  {
+    static Shared* shared = new Shared;
+    return *shared;
+  }
+
+  // Gives at most BATCH_SIZE blocks of the class _cls to a thread,
+  // _nmbr is set to their number.
+  FreeBlock* take(size_t _cls, size_t& _nmbr)
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    _nmbr = 0;
+    if (free_[_cls] != nullptr)
+    {
+      auto first = free_[_cls];
+      auto last = first;
+      for (_nmbr = 1; _nmbr < BATCH_SIZE && last->next_ != nullptr; ++_nmbr)
+        last = last->next_;
+      free_[_cls] = last->next_;
+      last->next_ = nullptr;
+      return first;
+    }
+    const size_t block_size = (_cls + 1) * GRANULE;
+    FreeBlock* first = nullptr;
+    for (; _nmbr < BATCH_SIZE; ++_nmbr)
+    {
+      if (cur_ + block_size > end_)
+      {
+        if (first != nullptr)
+          break;
+        slabs_.push_back(new_slab(nullptr));
+        cur_ = reinterpret_cast<char*>(slabs_.back()) + HEADER_SIZE;
+        end_ = cur_ - HEADER_SIZE + SLAB_SIZE;
+      }
+      auto blk = reinterpret_cast<FreeBlock*>(cur_);
+      ++slab_of(blk)->cut_;
+      cur_ += block_size;
+      blk->next_ = first;
+      first = blk;
+    }
+    return first;
+  }
+
+  void give_back(size_t _cls, FreeBlock* _first)
+  {
+    if (_first == nullptr)
+      return;
+    auto last = _first;
+    while (last->next_ != nullptr)
+      last = last->next_;
+    std::lock_guard<std::mutex> lock(mtx_);
+    last->next_ = free_[_cls];
+    free_[_cls] = _first;
+  }
+
+  // Frees the slabs whose blocks are all in the shared lists.
+  size_t trim()
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (auto slab : slabs_)
+      slab->free_ = 0;
+    for (auto blk : free_)
+      for (; blk != nullptr; blk = blk->next_)
+        ++slab_of(blk)->free_;
+    auto unused = [](Slab* _slab) { return _slab->free_ == _slab->cut_; };
+    for (auto& first : free_)
+    {
+      auto prev = &first;
+      while (*prev != nullptr)
+      {
+        if (unused(slab_of(*prev)))
+          *prev = (*prev)->next_;
+        else
+          prev = &(*prev)->next_;
+      }
+    }
+    if (cur_ != nullptr && unused(slab_of(cur_ - HEADER_SIZE)))
+      cur_ = end_ = nullptr;
+    auto used_end = std::partition(slabs_.begin(), slabs_.end(),
+      [&unused](Slab* _slab) { return !unused(_slab); });
+    const size_t freed = slabs_.end() - used_end;
+    std::for_each(used_end, slabs_.end(), delete_slab);
+    slabs_.erase(used_end, slabs_.end());
+    return freed;
+  }
+};
+
+// Trivially destructible, so it can still be used after ThreadExit has
+// run (e.g. by static objects destroyed at the program exit).
+struct ThreadCache
+{
+  FreeBlock* free_[CLASS_NMBR];
+  size_t size_[CLASS_NMBR];
+  bool ended_;
+
+  void give_back_all()
+  {
+    for (size_t cls = 0; cls < CLASS_NMBR; ++cls)
+    {
+      Shared::get().give_back(cls, free_[cls]);
+      free_[cls] = nullptr;
+      size_[cls] = 0;
+    }
+  }
+};
+
+thread_local ThreadCache thread_cache;
+
+// Gives the thread free lists back when the thread ends.
+struct ThreadExit
+{
+  void touch() {}
+  ~ThreadExit()
+  {
+    thread_cache.give_back_all();
+    thread_cache.ended_ = true;
+  }
+};
+
+thread_local ThreadExit thread_exit;
+
+thread_local Arena::Data* current_arena = nullptr;
+
+}//namespace
+
+struct Arena::Data
+{
+  std::mutex mtx_;
+  std::vector<Slab*> slabs_;
+  FreeBlock* free_[CLASS_NMBR] = {};
+  char* cur_ = nullptr;
+  char* end_ = nullptr;
+  // The arena handle plus the live objects.
+  std::atomic<size_t> refs_{ 1 };
+
+  void* allocate(size_t _size)
+  {
+    const auto cls = size_class(_size);
+    _size = (cls + 1) * GRANULE;
+    ++refs_;
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (auto blk = free_[cls])
+    {
+      free_[cls] = blk->next_;
+      return blk;
+    }
+    if (cur_ + _size > end_)
+    {
+      slabs_.push_back(new_slab(this));
+      cur_ = reinterpret_cast<char*>(slabs_.back()) + HEADER_SIZE;
+      end_ = cur_ - HEADER_SIZE + SLAB_SIZE;
+    }
+    auto ptr = cur_;
+    cur_ += _size;
+    return ptr;
+  }
+
+  void deallocate(void* _ptr, size_t _size)
+  {
+    {
+      const auto cls = size_class(_size);
+      auto blk = static_cast<FreeBlock*>(_ptr);
+      std::lock_guard<std::mutex> lock(mtx_);
+      blk->next_ = free_[cls];
+      free_[cls] = blk;
+    }
+    release();
+  }
+
+  void release()
+  {
+    if (--refs_ != 0)
+      return;
+    for (auto slab : slabs_)
+      delete_slab(slab);
+    delete this;
+  }
+};
+
+namespace Pool {
+
+void* allocate(size_t _size)
+{
+  if (_size > MAX_BLOCK)
+    return ::operator new(_size);
+  if (current_arena != nullptr)
+    return current_arena->allocate(_size);
+  const auto cls = size_class(_size);
+  auto& free = thread_cache.free_[cls];
+  if (free == nullptr)
+  {
+    size_t nmbr;
+    if (thread_cache.ended_)
+    {
+      auto blk = Shared::get().take(cls, nmbr);
+      Shared::get().give_back(cls, blk->next_);
+      return blk;
+    }
+    thread_exit.touch();
+    free = Shared::get().take(cls, nmbr);
+    thread_cache.size_[cls] = nmbr;
+  }
+  auto blk = free;
+  free = blk->next_;
+  --thread_cache.size_[cls];
+  return blk;
+}
+
+void deallocate(void* _ptr, size_t _size)
+{
+  if (_ptr == nullptr)
+    return;
+  if (_size > MAX_BLOCK)
+  {
+    ::operator delete(_ptr);
+    return;
+  }
+  if (auto arena = slab_of(_ptr)->arena_)
+  {
+    arena->deallocate(_ptr, _size);
+    return;
+  }
+  const auto cls = size_class(_size);
+  auto blk = static_cast<FreeBlock*>(_ptr);
+  if (thread_cache.ended_)
+  {
+    blk->next_ = nullptr;
+    Shared::get().give_back(cls, blk);
+    return;
+  }
+  // A thread can free blocks without allocating any.
+  thread_exit.touch();
+  auto& free = thread_cache.free_[cls];
+  blk->next_ = free;
+  free = blk;
+  if (++thread_cache.size_[cls] > MAX_CACHED)
+  {
+    // Keeps the first BATCH_SIZE blocks, the most recently freed.
+    auto last = free;
+    for (size_t i = 1; i < BATCH_SIZE; ++i)
+      last = last->next_;
+    Shared::get().give_back(cls, last->next_);
+    last->next_ = nullptr;
+    thread_cache.size_[cls] = BATCH_SIZE;
+  }
+}
+
+size_t trim()
+{
+  if (!thread_cache.ended_)
+    thread_cache.give_back_all();
+  return Shared::get().trim();
+}
+
+}//namespace Pool
+
+Arena::Arena() : data_(new Data) {}
+
+Arena::~Arena()
+{
+  data_->release();
+}
+
+size_t Arena::slab_count() const
+{
+  std::lock_guard<std::mutex> lock(data_->mtx_);
+  return data_->slabs_.size();
+}
+
+Arena::Scope::Scope(Arena& _arena) : prev_(current_arena)
+{
+  current_arena = _arena.data_;
+}
+
+Arena::Scope::~Scope()
+{
+  current_arena = prev_;
+}
+
+}//namespace Topo
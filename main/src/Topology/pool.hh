@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+
+namespace Topo {
+
+/*! Memory of the topological objects in builds with TOPO_POOL (see
+    Object::operator new).
+    Blocks up to MAX_BLOCK bytes come from 64KB slabs split in size
+    classes of 16 bytes. Every thread keeps a short free list per size
+    class, so allocation and deallocation seldom lock; the blocks over
+    the list limit and the lists of a thread that ends go back to shared
+    lists. The slabs stay allocated until trim(). Bigger blocks use
+    ::operator new.
+*/
+namespace Pool {
+
+const size_t MAX_BLOCK = 512;
+
+void* allocate(size_t _size);
+void deallocate(void* _ptr, size_t _size);
+
+// Gives back the free lists of the calling thread and releases the
+// slabs with no block in use or in the lists of other threads.
+// Returns the number of released slabs.
+size_t trim();
+
+}//namespace Pool
+
+/*! Arena for objects discarded together, e.g. a temporary body.
+    The objects created by a thread while an Arena::Scope is alive come
+    from the arena slabs. The memory of the deleted objects is reused
+    only by the same arena; the slabs are freed at once when the arena
+    and all the objects allocated in it are gone, so the arena can be
+    destroyed before the objects it holds.
+*/
+class Arena
+{
+public:
+  Arena();
+  ~Arena();
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  // Number of slabs allocated so far.
+  size_t slab_count() const;
+
+  struct Data;
+
+  // Makes _arena the current arena of the thread, until destruction.
+  class Scope
+  {
+  public:
+    explicit Scope(Arena& _arena);
+    ~Scope();
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+  private:
+    Data* prev_;
+  };
+
+private:
+  Data* data_;
+};
+
+}//namespace Topo
@@ -8,8 +8,13 @@
 #include "Utils/circular.hh"
 #include "Utils/continement_tree.hh"
 #include "Utils/error_handling.hh"
+#include "Utils/parallel.hh"
 
 #include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
 
 namespace Topo {
 
@@ -78,6 +83,123 @@ bool Split<Type::EDGE>::operator()() const
   return true;
 }
 
+/* Splits are grouped in batches of splits without common resources: the
+   faces and loops that can get a new vertex, the faces of these loops and
+   all the vertices the split reads or inserts. A split goes in the batch
+   after the last one that uses any of its resources, so the changes of
+   each face and vertex happen in the order of the set. The faces that a
+   vertex gets from a previous split are added to its parents, so the
+   faces of a split are known before any split is applied.
+   The bodies of the faces defer the invalidation of their topology until
+   all the batches are done. Builds with TOPO_SINGLE_THREAD run the
+   batches serially, since the reference count of the shared vertices is
+   not atomic.
+*/
+bool split_edges(const std::set<Split<Type::EDGE>>& _splits)
+{
+  std::vector<std::vector<const Split<Type::EDGE>*>> batches;
+  std::unordered_map<const IBase*, size_t> last_batches;
+  std::unordered_map<const IBase*, std::vector<IBase*>> new_parents;
+  std::vector<const IBase*> resources;
+  for (const auto& splt : _splits)
+  {
+    resources.clear();
+    if (splt.edge()->sub_type() == SubType::EDGE_REF)
+    {
+      auto ed_ref = static_cast<const EdgeRef*>(splt.edge().get());
+      std::vector<IBase*> parents[2];
+      for (size_t i = 0; i < std::size(ed_ref->verts_); ++i)
+      {
+        auto vert = ed_ref->verts_[i].get();
+        for (size_t j = 0; j < vert->size(Direction::Up); ++j)
+          parents[i].push_back(vert->get(Direction::Up, j));
+        auto new_prnts = new_parents.find(vert);
+        if (new_prnts != new_parents.end())
+        {
+          parents[i].insert(parents[i].end(),
+            new_prnts->second.begin(), new_prnts->second.end());
+        }
+        std::sort(parents[i].begin(), parents[i].end());
+        parents[i].erase(
+          std::unique(parents[i].begin(), parents[i].end()), parents[i].end());
+        resources.push_back(vert);
+      }
+      std::vector<IBase*> comm_parents;
+      std::set_intersection(
+        parents[0].begin(), parents[0].end(),
+        parents[1].begin(), parents[1].end(),
+        std::back_inserter(comm_parents));
+      for (auto prnt : comm_parents)
+      {
+        resources.push_back(prnt);
+        if (prnt->type() != Type::LOOP)
+          continue;
+        for (size_t j = 0; j < prnt->size(Direction::Up); ++j)
+          resources.push_back(prnt->get(Direction::Up, j));
+      }
+      for (const auto& splt_pt : splt.split_points())
+      {
+        auto& new_prnts = new_parents[splt_pt.vert_.get()];
+        new_prnts.insert(new_prnts.end(), comm_parents.begin(), comm_parents.end());
+        resources.push_back(splt_pt.vert_.get());
+      }
+    }
+    size_t batch = 0;
+    for (auto res : resources)
+    {
+      auto last = last_batches.find(res);
+      if (last != last_batches.end())
+        batch = std::max(batch, last->second + 1);
+    }
+    for (auto res : resources)
+      last_batches[res] = batch;
+    if (batch >= batches.size())
+      batches.resize(batch + 1);
+    batches[batch].push_back(&splt);
+  }
+  std::vector<EE<Type::BODY>*> bodies;
+  for (const auto& res : last_batches)
+  {
+    if (res.first->type() != Type::FACE)
+      continue;
+    for (size_t j = 0; j < res.first->size(Direction::Up); ++j)
+    {
+      auto prnt = res.first->get(Direction::Up, j);
+      if (prnt->type() == Type::BODY)
+        bodies.push_back(static_cast<EE<Type::BODY>*>(prnt));
+    }
+  }
+  std::sort(bodies.begin(), bodies.end());
+  bodies.erase(std::unique(bodies.begin(), bodies.end()), bodies.end());
+  struct DeferInvalidation
+  {
+    DeferInvalidation(std::vector<EE<Type::BODY>*>& _bodies) : bodies_(_bodies)
+    {
+      for (auto body : bodies_)
+        body->defer_invalidation();
+    }
+    ~DeferInvalidation()
+    {
+      for (auto body : bodies_)
+        body->resume_invalidation();
+    }
+    std::vector<EE<Type::BODY>*>& bodies_;
+  } defer_invalidation(bodies);
+  for (const auto& batch : batches)
+  {
+#ifdef TOPO_SINGLE_THREAD
+    for (auto splt : batch)
+      (*splt)();
+#else
+    Utils::parallel_for(batch.size(), [&batch](size_t _i)
+    {
+      (*batch[_i])();
+    }, 256);
+#endif
+  }
+  return true;
+}
+
 void Split<Type::FACE>::use_face_loops(const LoopFilter& _loop_filter)
 {
   Topo::Iterator<Topo::Type::FACE, Topo::Type::LOOP> fl_it(face_);
@@ -122,47 +244,141 @@ std::vector<Geo::VectorD3> vertex_chain_to_poly(VertexChain& _chain)
   return poly;
 }
 
-bool is_inside(const std::vector<Geo::VectorD3>& _chain, 
-  VertexChain& _isle, const Geo::VectorD3& _norm)
-{
-  Geo::VectorD3 pt_inside;
-  _isle[0]->geom(pt_inside);
-  auto pt_clss = Geo::PointInPolygon::classify(_chain, pt_inside, &_norm);
-  if (pt_clss != Geo::PointInPolygon::Inside)
-    return false;
-  auto int_norm = Geo::vertex_polygon_normal(_isle.begin(), _isle.end());
-  if (int_norm * _norm > 0)
-    std::reverse(_isle.begin(), _isle.end());
-  return true;
-}
-
 } // namespace
 
+/* Boundaries and islands are nested in a containement tree, so an island
+   is tested only against the chains with a box containing its box. Each
+   island goes to the innermost boundary containing its first vertex.
+*/
 bool Split<Type::FACE>::compute()
 {
   if (boundary_chains_.empty())
     return false;
-  for (auto& chain : boundary_chains_)
+  // Non empty boundaries, original islands and new islands, in this order.
+  std::vector<VertexChain*> chains;
+  size_t chain_ends[3];
+  size_t k = 0;
+  for (auto chain_set : { &boundary_chains_, &original_island_chains_, &island_chains_ })
   {
-    if (chain.empty())
-      continue;
-    auto poly = vertex_chain_to_poly(chain);
-    std::vector<VertexChain> cur_islands;
-    auto norm = Geo::vertex_polygon_normal(chain.begin(), chain.end());
-    auto select_chains = [&cur_islands, &poly, &norm](
-      std::vector<VertexChain>& _island_chains)
+    for (auto& chain : *chain_set)
+    {
+      if (!chain.empty())
+        chains.push_back(&chain);
+    }
+    chain_ends[k++] = chains.size();
+  }
+  const auto bndr_nmbr = chain_ends[0];
+  if (bndr_nmbr == 0)
+  {
+    face_->remove();
+    return true;
+  }
+
+  struct ChainData
+  {
+    std::vector<Geo::VectorD3> poly_;
+    Geo::VectorD3 norm_;
+  };
+  std::vector<ChainData> chain_datas(chains.size());
+  auto chain_data = [&chains, &chain_datas](size_t _i) -> const ChainData&
+  {
+    auto& data = chain_datas[_i];
+    if (data.poly_.empty())
+    {
+      data.poly_ = vertex_chain_to_poly(*chains[_i]);
+      data.norm_ = Geo::vertex_polygon_normal(chains[_i]->begin(), chains[_i]->end());
+    }
+    return data;
+  };
+  auto inside = [&chains, &chain_data](size_t _a, size_t _b)
+  {
+    Geo::VectorD3 pt_inside;
+    (*chains[_a])[0]->geom(pt_inside);
+    const auto& data = chain_data(_b);
+    return Geo::PointInPolygon::classify(data.poly_, pt_inside, &data.norm_) ==
+      Geo::PointInPolygon::Inside;
+  };
+  using ChainTree = Utils::ContainementTree<size_t>;
+  ChainTree chain_tree([&inside](size_t _a, size_t _b)
+  {
+    return inside(_a, _b) ? -1 : (inside(_b, _a) ? 1 : 0);
+  });
+  // Boxes on the coordinates where the face normal is smaller.
+  const auto& face_norm = chain_data(0).norm_;
+  size_t drop = 0;
+  for (size_t i = 1; i < 3; ++i)
+  {
+    if (std::fabs(face_norm[i]) > std::fabs(face_norm[drop]))
+      drop = i;
+  }
+  // Islands touching a boundary within the vertex tolerances can have a
+  // box just outside the boundary box.
+  double tol = 0;
+  for (const auto& ch : chains)
+    for (const auto& v : *ch)
+      tol = std::max(tol, v->tolerance());
+  auto chain_box = [&chains, drop](size_t _i)
+  {
+    ChainTree::Box box;
+    box.min_.fill(std::numeric_limits<double>::max());
+    box.max_.fill(std::numeric_limits<double>::lowest());
+    for (const auto& v : *chains[_i])
     {
-      for (auto& isle : _island_chains)
+      Geo::VectorD3 pt;
+      v->geom(pt);
+      for (size_t j = 0; j < 2; ++j)
       {
-        if (isle.empty())
-          continue;
-        if (is_inside(poly, isle, norm))
-          cur_islands.emplace_back(std::move(isle));
+        const auto coord = pt[(drop + 1 + j) % 3];
+        box.min_[j] = std::min(box.min_[j], coord);
+        box.max_[j] = std::max(box.max_[j], coord);
       }
-    };
-    select_chains(original_island_chains_);
-    auto original_size = cur_islands.size();
-    select_chains(island_chains_);
+    }
+    return box;
+  };
+  std::vector<size_t> chain_inds(chains.size());
+  std::iota(chain_inds.begin(), chain_inds.end(), 0);
+  chain_tree.add(chain_inds, chain_box, tol, inside);
+
+  // Islands of each boundary, also the ones inside other islands.
+  std::vector<std::vector<size_t>> bndr_islands(bndr_nmbr);
+  std::vector<std::pair<const ChainTree::Element*, size_t>> to_visit;
+  to_visit.emplace_back(chain_tree.root(), SIZE_MAX);
+  while (!to_visit.empty())
+  {
+    auto el = to_visit.back().first;
+    auto bndr = to_visit.back().second;
+    to_visit.pop_back();
+    for (; el != nullptr; el = el->next())
+    {
+      const auto i = el->data();
+      if (i < bndr_nmbr)
+        to_visit.emplace_back(el->child(), i);
+      else
+      {
+        if (bndr != SIZE_MAX)
+          bndr_islands[bndr].push_back(i);
+        to_visit.emplace_back(el->child(), bndr);
+      }
+    }
+  }
+
+  for (size_t b = 0; b < bndr_nmbr; ++b)
+  {
+    auto& chain = *chains[b];
+    auto& islands = bndr_islands[b];
+    std::sort(islands.begin(), islands.end());
+    const auto& norm = chain_data(b).norm_;
+    std::vector<VertexChain> cur_islands;
+    size_t original_size = 0;
+    for (auto i : islands)
+    {
+      cur_islands.emplace_back(std::move(*chains[i]));
+      auto& isle = cur_islands.back();
+      auto int_norm = Geo::vertex_polygon_normal(isle.begin(), isle.end());
+      if (int_norm * norm > 0)
+        std::reverse(isle.begin(), isle.end());
+      original_size += i < chain_ends[1];
+    }
     bool make_loops = !cur_islands.empty();
 
 	  auto inherit_parents = [this](Wrap<Type::FACE>& _new_face)
@@ -3,6 +3,7 @@
 #include "Topology.hh"
 #include "Geo/entity.hh"
 
+#include <set>
 #include <vector>
 
 namespace Topo {
@@ -29,6 +30,9 @@ template <> struct Split<Type::EDGE>
 
   bool operator()() const;
 
+  const Wrap<Type::EDGE>& edge() const { return edge_; }
+  const std::vector<Info>& split_points() const { return split_pts_; }
+
 private:
   Wrap<Type::EDGE> edge_;
   mutable std::vector<Info> split_pts_;
@@ -78,4 +82,9 @@ private:
 bool split(const Wrap<Type::VERTEX>& _ed_start,
   const Wrap<Type::VERTEX>& _ed_end, Wrap<Type::VERTEX>& _ins_vert);
 
+// Applies all the edge splits. Splits that do not share faces or vertices
+// are applied at the same time; the result is the same as applying them
+// one by one in the order of the set.
+bool split_edges(const std::set<Split<Type::EDGE>>& _splits);
+
 }//namespace Topology
@@ -3,12 +3,15 @@
 #include "geom.hh"
 
 #include "Geo/plane_fitting.hh"
+#include "Geo/range.hh"
 #include "PolygonTriangularization/poly_triang.hh"
 #include "Utils/error_handling.hh"
 #include "Utils/circular.hh"
 #include "Utils/statistics.hh"
 
+#include <algorithm>
 #include <array>
+#include <cmath>
 #include <functional>
 #include <map>
 #include <set>
@@ -18,7 +21,213 @@ namespace Topo {
 namespace
 {
 using Connection = std::array<Topo::Wrap<Topo::Type::VERTEX>, 2>;
+// Ordered by the first vertex, so the connections leaving a vertex are
+// found with lower_bound.
 using Connections = std::set<Connection>;
+
+/* Uniform grid of the boundary segments and of the connections of a face,
+   projected on the two coordinates where the face normal is smaller.
+   A segment is in all the cells touched by its box. The query boxes are
+   enlarged by the face thickness along the third coordinate plus the
+   vertex tolerances, so that the segments found by closest_point on a
+   nearly flat face are candidates. A segment added after the build
+   outside the built box, or with a bigger vertex tolerance, would make
+   the grid or the margin wrong: the index is cleared to be built again.
+*/
+class SegmentIndex
+{
+public:
+  bool valid() const { return valid_; }
+
+  void clear()
+  {
+    valid_ = false;
+    segs_.clear();
+    cells_.clear();
+    stamps_.clear();
+    stamp_ = 0;
+  }
+
+  void build(const VertexChains& _bndrs, const Connections& _conns)
+  {
+    clear();
+    valid_ = true;
+    Geo::VectorD3 norm = { 0, 0, 1 };
+    if (!_bndrs.empty())
+      norm = Geo::vertex_polygon_normal(_bndrs[0].begin(), _bndrs[0].end());
+    size_t drop = 0;
+    for (size_t i = 1; i < 3; ++i)
+    {
+      if (std::fabs(norm[i]) > std::fabs(norm[drop]))
+        drop = i;
+    }
+    coords_[0] = (drop + 1) % 3;
+    coords_[1] = (drop + 2) % 3;
+
+    box_.clear();
+    tol_ = 0;
+    size_t seg_nmbr = 0;
+    auto add_to_box = [this](const Wrap<Type::VERTEX>& _v)
+    {
+      Geo::Point pt;
+      _v->geom(pt);
+      box_ += pt;
+      tol_ = std::max(tol_, _v->tolerance());
+    };
+    for (const auto& chain : _bndrs)
+    {
+      for (const auto& v : chain)
+        add_to_box(v);
+      seg_nmbr += chain.size();
+    }
+    for (const auto& conn : _conns)
+    {
+      add_to_box(conn[0]);
+      add_to_box(conn[1]);
+      ++seg_nmbr;
+    }
+    if (box_.empty())
+      return;
+    margin_ = tol_ + box_.extr_[1][drop] - box_.extr_[0][drop];
+
+    // About one segment per cell.
+    const size_t MAX_CELLS_PER_SIDE = 256;
+    const auto side_cells = std::min(MAX_CELLS_PER_SIDE,
+      std::max<size_t>(1, size_t(std::sqrt(double(seg_nmbr)))));
+    double max_size = 0;
+    for (size_t i = 0; i < 2; ++i)
+    {
+      org_[i] = box_.extr_[0][coords_[i]];
+      max_size = std::max(max_size, box_.extr_[1][coords_[i]] - org_[i]);
+    }
+    cell_size_ = max_size > 0 ? max_size / side_cells : 1;
+    for (size_t i = 0; i < 2; ++i)
+    {
+      dims_[i] = std::min(side_cells,
+        size_t((box_.extr_[1][coords_[i]] - org_[i]) / cell_size_) + 1);
+    }
+    cells_.resize(dims_[0] * dims_[1]);
+
+    for (const auto& chain : _bndrs)
+    {
+      auto vp = chain.back();
+      for (const auto& v : chain)
+      {
+        insert(vp, v);
+        vp = v;
+      }
+    }
+    for (const auto& conn : _conns)
+    {
+      // Bidirectional connections are indexed once.
+      if (conn[1] < conn[0] && _conns.count(Connection{ conn[1], conn[0] }) > 0)
+        continue;
+      insert(conn[0], conn[1]);
+    }
+  }
+
+  // Adds a segment to a built index, or clears the index if the segment
+  // does not fit it.
+  void add(const Wrap<Type::VERTEX>& _v0, const Wrap<Type::VERTEX>& _v1)
+  {
+    if (cells_.empty() || !fits(_v0) || !fits(_v1))
+      clear();
+    else
+      insert(_v0, _v1);
+  }
+
+  // Calls _fun for every segment that can touch the segment _v0, _v1
+  // until it returns true. Returns true if _fun returned true.
+  template <class FunctionT>
+  bool find(const Wrap<Type::VERTEX>& _v0, const Wrap<Type::VERTEX>& _v1,
+            const FunctionT& _fun) const
+  {
+    if (cells_.empty())
+      return false;
+    size_t cell_range[2][2];
+    find_cells(_v0, _v1, 2 * margin_, cell_range);
+    ++stamp_;
+    for (auto i = cell_range[0][0]; i <= cell_range[1][0]; ++i)
+    {
+      for (auto j = cell_range[0][1]; j <= cell_range[1][1]; ++j)
+      {
+        for (auto seg_ind : cells_[i * dims_[1] + j])
+        {
+          if (stamps_[seg_ind] == stamp_)
+            continue;
+          stamps_[seg_ind] = stamp_;
+          if (_fun(segs_[seg_ind]))
+            return true;
+        }
+      }
+    }
+    return false;
+  }
+
+private:
+  void insert(const Wrap<Type::VERTEX>& _v0, const Wrap<Type::VERTEX>& _v1)
+  {
+    size_t cell_range[2][2];
+    find_cells(_v0, _v1, 0, cell_range);
+    const auto seg_ind = segs_.size();
+    segs_.push_back({ _v0, _v1 });
+    stamps_.push_back(0);
+    for (auto i = cell_range[0][0]; i <= cell_range[1][0]; ++i)
+      for (auto j = cell_range[0][1]; j <= cell_range[1][1]; ++j)
+        cells_[i * dims_[1] + j].push_back(seg_ind);
+  }
+
+  bool fits(const Wrap<Type::VERTEX>& _v) const
+  {
+    if (_v->tolerance() > tol_)
+      return false;
+    Geo::Point pt;
+    _v->geom(pt);
+    for (size_t i = 0; i < 3; ++i)
+    {
+      if (pt[i] < box_.extr_[0][i] || pt[i] > box_.extr_[1][i])
+        return false;
+    }
+    return true;
+  }
+
+  // First and last cell of the box of the segment, inside the grid.
+  void find_cells(const Wrap<Type::VERTEX>& _v0, const Wrap<Type::VERTEX>& _v1,
+                  double _enlarge, size_t _cell_range[2][2]) const
+  {
+    Geo::Point pts[2];
+    _v0->geom(pts[0]);
+    _v1->geom(pts[1]);
+    for (size_t i = 0; i < 2; ++i)
+    {
+      auto coord = coords_[i];
+      const double extr[2] = {
+        std::min(pts[0][coord], pts[1][coord]) - _enlarge - org_[i],
+        std::max(pts[0][coord], pts[1][coord]) + _enlarge - org_[i] };
+      for (size_t j = 0; j < 2; ++j)
+      {
+        auto cell = std::floor(extr[j] / cell_size_);
+        _cell_range[j][i] = cell < 0 ? 0 :
+          std::min(dims_[i] - 1, size_t(cell));
+      }
+    }
+  }
+
+  bool valid_ = false;
+  size_t coords_[2] = { 0, 1 };
+  double org_[2] = {};
+  double cell_size_ = 1;
+  double margin_ = 0;
+  // Box and biggest vertex tolerance of the segments of the build.
+  Geo::Range<3> box_;
+  double tol_ = 0;
+  size_t dims_[2] = {};
+  std::vector<Connection> segs_;
+  std::vector<std::vector<size_t>> cells_;
+  mutable std::vector<size_t> stamps_;
+  mutable size_t stamp_ = 0;
+};
+
 } // namespace
 
 struct SplitChain : public ISplitChain
@@ -26,14 +235,17 @@ struct SplitChain : public ISplitChain
   virtual void add_chain(const VertexChain _chain)
   {
     boundaries_.push_back(_chain);
+    seg_index_.clear();
   }
   virtual void add_connection(const Topo::Wrap<Topo::Type::VERTEX>& _v0,
                               const Topo::Wrap<Topo::Type::VERTEX>& _v1,
                               bool _bidirectional = true) override
   {
-    connections_.emplace(Connection({ _v0, _v1 }));
+    bool added = connections_.emplace(Connection({ _v0, _v1 })).second;
     if (_bidirectional)
-      connections_.emplace(Connection({ _v1, _v0 }));
+      added |= connections_.emplace(Connection({ _v1, _v0 })).second;
+    if (added && seg_index_.valid())
+      seg_index_.add(_v0, _v1);
   }
   ConnectionCheck check_new_connection(
     const Topo::Wrap<Topo::Type::VERTEX>& _v0,
@@ -80,6 +292,8 @@ private:
   VertexChains boundaries_;
   std::map<size_t, VertexChains> islands_;
   Connections connections_;
+  // Built by check_new_connection(), kept while connections are added.
+  mutable SegmentIndex seg_index_;
   Geo::VectorD3 norm_;
 };
 
@@ -95,37 +309,28 @@ ISplitChain::ConnectionCheck SplitChain::check_new_connection(
   Geo::Segment seg_new;
   _v0->geom(seg_new[0]);
   _v1->geom(seg_new[1]);
-  Geo::Segment seg;
-  for (const auto& conn : connections_)
-  {
-    if (_v0 == conn[0] || _v1 == conn[0] || 
-        _v0 == conn[1] || _v1 == conn[1])
-      continue;
-    conn[0]->geom(seg[0]);
-    conn[1]->geom(seg[1]);
-    if (Geo::closest_point(seg, seg_new))
-      return ConnectionCheck::INVALID;
-  }
-  for (const auto& chain : boundaries_)
+  if (!seg_index_.valid())
+    seg_index_.build(boundaries_, connections_);
+  auto crosses = [&_v0, &_v1, &seg_new](const Connection& _conn)
   {
-    auto vp = chain.back();
-    for (const auto& v : chain)
+    if (_v0 == _conn[0] || _v1 == _conn[0] ||
+        _v0 == _conn[1] || _v1 == _conn[1])
     {
-      if (_v0 != vp && _v1 != vp && _v0 != v && _v1 != v)
-      {
-        vp->geom(seg[0]);
-        v->geom(seg[1]);
-        if (Geo::closest_point(seg, seg_new))
-          return ConnectionCheck::INVALID;
-      }
-      vp = v;
+      return false;
     }
-  }   
+    Geo::Segment seg;
+    _conn[0]->geom(seg[0]);
+    _conn[1]->geom(seg[1]);
+    return Geo::closest_point(seg, seg_new);
+  };
+  if (seg_index_.find(_v0, _v1, crosses))
+    return ConnectionCheck::INVALID;
   return ConnectionCheck::OK;
 }
 
 void SplitChain::compute()
 {
+  seg_index_.clear();
   if (boundaries_.empty())
     return;
   norm_ = Geo::vertex_polygon_normal(boundaries_[0].begin(), boundaries_[0].end());
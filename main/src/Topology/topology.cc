@@ -3,9 +3,10 @@
 namespace Topo
 {
 
-Object::Object() : ref_(0)
+Object::Object()
 {
-  static size_t progr_id;
+  // Objects can be created by different threads (see split_edges()).
+  static std::atomic<size_t> progr_id{ 0 };
   id_ = progr_id++;
 }
 
@@ -13,6 +14,12 @@ Object::~Object()
 {
 }
 
+uint64_t IBase::new_mark(size_t _nmbr)
+{
+  static std::atomic<uint64_t> last_mark{ 0 };
+  return last_mark.fetch_add(_nmbr) + 1;
+}
+
 bool Object::operator<(const Object& _oth) const { return id_ < _oth.id_; }
 bool Object::operator==(const Object& _oth) const { return id_ == _oth.id_; }
 
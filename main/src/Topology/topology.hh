@@ -1,11 +1,14 @@
 #pragma once
 
 #include "subtype.hh"
+#include "pool.hh"
 #include "Geo/entity.hh"
 #include "Geo/range.hh"
 
 
 #include <array>
+#include <atomic>
+#include <utility>
 #include <vector>
 
 namespace Topo {
@@ -16,18 +19,43 @@ MAKE_ENUM(Direction, Up, Down )
 
 typedef unsigned __int64 Identifier;
 
+// Reference count of the objects. The atomic one allows Wrap copies in
+// threads sharing the same bodies; builds defining TOPO_SINGLE_THREAD
+// use a plain counter.
+struct PlainRefCount
+{
+  void add() { ++count_; }
+  // Returns the references left.
+  size_t release() { return --count_; }
+  size_t count_ = 0;
+};
+
+struct AtomicRefCount
+{
+  void add() { count_.fetch_add(1, std::memory_order_relaxed); }
+  // Returns the references left. The last release sees all the writes
+  // done by the threads that released before.
+  size_t release() { return count_.fetch_sub(1, std::memory_order_acq_rel) - 1; }
+  std::atomic<size_t> count_{ 0 };
+};
+
+#ifdef TOPO_SINGLE_THREAD
+typedef PlainRefCount RefCount;
+#else
+typedef AtomicRefCount RefCount;
+#endif
+
 struct Object
 {
   template <Type typeT> friend class Wrap;
 
   void add_ref() const
   {
-    ++ref_;
+    ref_.add();
   }
   void release_ref() const
   {
-    auto refs = --ref_;
-    if (refs == 0)
+    if (ref_.release() == 0)
       delete this;
   }
   virtual Type type() const = 0;
@@ -42,12 +70,25 @@ protected:
   Object();
   virtual ~Object();
 
+#ifdef TOPO_POOL
+  // Objects are allocated in the Topo::Pool size class slabs, or in the
+  // current Topo::Arena of the thread.
+  static void operator delete(void* _ptr, std::size_t _sz)
+  {
+    Pool::deallocate(_ptr, _sz);
+  }
+#endif
+
 private:
+#ifdef TOPO_POOL
+  static void* operator new(std::size_t sz) { return Pool::allocate(sz); }
+#else
   static void* operator new(std::size_t sz) { return ::operator new(sz); }
+#endif
   static void* operator new[](std::size_t sz) { return ::operator new(sz); }
 
 private:
-  mutable size_t ref_;
+  mutable RefCount ref_;
   Identifier id_;
 };
 
@@ -62,6 +103,11 @@ public:
   {
     reset(_oth.ptr_);
   }
+  // Moves take the reference without touching the count.
+  WrapObject(WrapObject&& _oth) noexcept : ptr_(_oth.ptr_)
+  {
+    _oth.ptr_ = nullptr;
+  }
   ~WrapObject()
   {
     if (ptr_)
@@ -74,6 +120,12 @@ public:
     return *this;
   }
 
+  WrapObject& operator=(WrapObject&& _oth) noexcept
+  {
+    std::swap(ptr_, _oth.ptr_);
+    return *this;
+  }
+
   Object* operator->() { return get(); }
 
   const Object* operator->() const { return get(); }
@@ -118,6 +170,7 @@ public:
 
 struct IBase : public Object
 {
+  template <Type typeT> friend struct Base;
   template <Type typeT> friend struct UpEntity;
 
   virtual bool replace(IBase*) { return false; }
@@ -138,9 +191,47 @@ struct IBase : public Object
   { return Geo::uniform_vector<3>(std::numeric_limits<double>::max()); }
   virtual Geo::Range<3> box() const { return Geo::Range<3>(); }
   virtual double tolerance() const { return 0; }
+
+  // Returns false if the element has already been visited with _mark.
+  // Marks let a traversal find each element once without a set (see
+  // Topo::View), the atomic exchange lets threads share a traversal.
+  bool visit(uint64_t _mark) const
+  {
+    return mark_.exchange(_mark, std::memory_order_relaxed) != _mark;
+  }
+  // Visit of a traversal split in chunks that use the marks _first,
+  // _first + 1, ... in their order. Returns false if the element has
+  // already been visited by this chunk or by a previous one (a mark in
+  // [_first, _mark]), else sets _mark. In the end each element keeps the
+  // mark of the first chunk that meets it.
+  bool visit_first(uint64_t _first, uint64_t _mark) const
+  {
+    auto cur = mark_.load(std::memory_order_relaxed);
+    do
+    {
+      if (cur >= _first && cur <= _mark)
+        return false;
+    } while (!mark_.compare_exchange_weak(cur, _mark, std::memory_order_relaxed));
+    return true;
+  }
+  bool marked(uint64_t _mark) const
+  {
+    return mark_.load(std::memory_order_relaxed) == _mark;
+  }
+  // The first of _nmbr consecutive marks never used before.
+  static uint64_t new_mark(size_t _nmbr = 1);
+
 protected:
   virtual bool remove_parent(IBase* /*_prnt*/) { return false; }
   virtual bool add_parent(IBase* /*_prnt*/) { return false; }
+  // Called when the geometry of the element or of one of its children
+  // changes, to discard cached geometric properties.
+  virtual void invalidate_geometry() {}
+  // Called when the children of one of the element children change.
+  virtual void invalidate_topology() {}
+
+private:
+  mutable std::atomic<uint64_t> mark_{ 0 };
 };
 
 template <Type typeT> struct EBase : public IBase
@@ -197,6 +288,12 @@ public:
       ptr_->add_ref();
   }
 
+  // Moves take the reference without touching the count.
+  WrapIbase(WrapIbase<IBaseT>&& _ew) noexcept : ptr_(_ew.ptr_)
+  {
+    _ew.ptr_ = nullptr;
+  }
+
   ~WrapIbase()
   {
     if (ptr_)
@@ -209,6 +306,12 @@ public:
     return *this;
   }
 
+  WrapIbase& operator=(WrapIbase<IBaseT>&& _oth) noexcept
+  {
+    std::swap(ptr_, _oth.ptr_);
+    return *this;
+  }
+
   IBaseT* operator->() { return get(); }
 
   const IBaseT* operator->() const { return get(); }
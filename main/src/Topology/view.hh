@@ -0,0 +1,142 @@
+#pragma once
+
+#include "topology.hh"
+
+#include <iterator>
+
+namespace Topo {
+
+/*! Range of the elements of type ToT reached from an element going
+    down (e.g. the vertices of a face, also through its loops) or up
+    (e.g. the faces of a vertex), in the order of Iterator<FromT, ToT>,
+    also for unique views: the first occurrence of each element.
+    It reads the children and parent arrays in place: no allocation and
+    no reference count, so it is valid only while the topology does not
+    change. Edges and coedges are not stored, use Iterator for them; it
+    also makes a loop for each face without loop children, a view does not.
+    A unique view skips the elements already met, using a visit mark of
+    the elements instead of a set; two unique traversals of the same
+    elements must not run at the same time.
+*/
+template <Type ToT> class View
+{
+  static const size_t MAX_DEPTH = 5;
+
+public:
+  View(const IBase* _from, bool _unique = false)
+    : from_(_from), unique_(_unique) {}
+
+  class iterator
+  {
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef E<ToT>* value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef E<ToT>* const* pointer;
+    typedef E<ToT>* reference;
+
+    iterator() {}
+    iterator(const IBase* _from, bool _unique)
+      : mark_(_unique ? IBase::new_mark() : 0)
+    {
+      if (_from == nullptr)
+        return;
+      dir_ = _from->type() > ToT ? Direction::Down : Direction::Up;
+      stack_[0] = { _from, 0 };
+      depth_ = 1;
+      if (!accept(_from))
+        next();
+    }
+
+    E<ToT>* operator*() const
+    {
+      return static_cast<E<ToT>*>(const_cast<IBase*>(stack_[depth_ - 1].el_));
+    }
+
+    iterator& operator++()
+    {
+      next();
+      return *this;
+    }
+
+    bool operator==(const iterator& _oth) const
+    {
+      if (depth_ != _oth.depth_)
+        return false;
+      return depth_ == 0 || (stack_[depth_ - 1].el_ == _oth.stack_[depth_ - 1].el_ &&
+        stack_[depth_ - 1].i_ == _oth.stack_[depth_ - 1].i_);
+    }
+    bool operator!=(const iterator& _oth) const { return !(*this == _oth); }
+
+  private:
+    struct Frame
+    {
+      const IBase* el_;
+      size_t i_;  // Next child to visit.
+    };
+
+    // True if the traversal stops on _el.
+    bool accept(const IBase* _el) const
+    {
+      return _el->type() == ToT && (mark_ == 0 || _el->visit(mark_));
+    }
+
+    // Depth first search of the next element of type ToT.
+    void next()
+    {
+      while (depth_ > 0)
+      {
+        auto& frame = stack_[depth_ - 1];
+        if (frame.el_->type() == ToT ||
+          frame.i_ >= frame.el_->size(dir_))
+        {
+          --depth_;
+          continue;
+        }
+        auto child = frame.el_->get(dir_, frame.i_++);
+        // As topo_iterate, stop on elements beyond ToT.
+        if ((child->type() > ToT) != (dir_ == Direction::Down) &&
+          child->type() != ToT)
+        {
+          continue;
+        }
+        if (depth_ == MAX_DEPTH)
+          continue;
+        stack_[depth_++] = { child, 0 };
+        if (accept(child))
+          return;
+        if (child->type() == ToT)
+          --depth_;
+      }
+    }
+
+    Frame stack_[MAX_DEPTH];
+    size_t depth_ = 0;
+    Direction dir_ = Direction::Down;
+    uint64_t mark_ = 0;
+  };
+
+  iterator begin() const { return iterator(from_, unique_); }
+  iterator end() const { return iterator(); }
+
+  // Walks the range.
+  size_t size() const
+  {
+    size_t nmbr = 0;
+    for (auto it = begin(); it != end(); ++it)
+      ++nmbr;
+    return nmbr;
+  }
+
+private:
+  const IBase* from_;
+  bool unique_;
+};
+
+template <Type ToT, Type FromT>
+View<ToT> view(const Wrap<FromT>& _from) { return View<ToT>(_from.get()); }
+
+template <Type ToT, Type FromT>
+View<ToT> unique_view(const Wrap<FromT>& _from) { return View<ToT>(_from.get(), true); }
+
+}//namespace Topo
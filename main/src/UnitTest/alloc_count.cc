@@ -0,0 +1,38 @@
+#include "alloc_count.hh"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+std::atomic<size_t> alloc_count(0);
+}
+
+void* operator new(std::size_t _sz)
+{
+  ++alloc_count;
+  if (void* ptr = std::malloc(_sz == 0 ? 1 : _sz))
+    return ptr;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* _ptr) noexcept
+{
+  std::free(_ptr);
+}
+
+void operator delete(void* _ptr, std::size_t) noexcept
+{
+  std::free(_ptr);
+}
+
+namespace UnitTest
+{
+
+size_t allocation_count()
+{
+  return alloc_count;
+}
+
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstddef>
+
+namespace UnitTest
+{
+
+// Number of calls to the global operator new since the program start.
+size_t allocation_count();
+
+}
@@ -3,7 +3,7 @@
 #include <Geo/bspline_fiting.hh>
 #include <Geo/evalnurbs.hh>
 
-
+#include <cmath>
 #include <fstream>
 namespace {
 
@@ -106,3 +106,71 @@ TEST_CASE("poly fit", "[BSPLFIT]")
   };
   analyse(knots, Function());
 }
+
+TEST_CASE("exact fit", "[BSPLFIT]")
+{
+  // A parabola is in the space of the quadratic B-splines.
+  std::vector<double> knots = { 0, 0, 0.1, 0.3, 0.35, 0.6, 1, 1 };
+  struct Function : public Geo::IBsplineFitting<2>::IFunction
+  {
+    virtual Geo::VectorD<2> evaluate(const double _t) const
+    {
+      return Geo::VectorD<2>{ _t, _t * _t - 2 * _t };
+    }
+    virtual Geo::VectorD<2> closest_point(
+      const Geo::VectorD<2>&, const double _t) const
+    {
+      return evaluate(_t);
+    }
+  } func;
+  auto bsp_fit = Geo::IBsplineFitting<2>::make();
+  bsp_fit->init(2, knots, func);
+  bsp_fit->set_parameter_correction_iterations(1);
+  bsp_fit->compute();
+  auto ctrl_pts = bsp_fit->X();
+  REQUIRE(ctrl_pts.size() == knots.size() - 1);
+  Geo::Nub<Geo::VectorD<2>, double> nub;
+  nub.init(ctrl_pts, knots);
+  for (double t = 0; t <= 1; t += 1. / 64)
+  {
+    Geo::VectorD<2> pt;
+    nub.eval(t, &pt, &pt + 1);
+    REQUIRE(Geo::length(pt - func.evaluate(t)) < 1e-10);
+  }
+}
+
+TEST_CASE("large fit", "[BSPLFIT]")
+{
+  // Full circle with 10000 spans.
+  const size_t span_nmbr = 10000;
+  std::vector<double> knots = { 0, 0, 0 };
+  for (size_t i = 1; i < span_nmbr; ++i)
+    knots.push_back(double(i) / span_nmbr);
+  knots.insert(knots.end(), { 1, 1, 1 });
+  struct Function : public Geo::IBsplineFitting<2>::IFunction
+  {
+    virtual Geo::VectorD<2> evaluate(const double _t) const
+    {
+      return Geo::VectorD<2>{ cos(2 * M_PI * _t), sin(2 * M_PI * _t) };
+    }
+    virtual Geo::VectorD<2> closest_point(
+      const Geo::VectorD<2>& _pt, const double) const
+    {
+      return _pt / Geo::length(_pt);
+    }
+  } func;
+  auto bsp_fit = Geo::IBsplineFitting<2>::make();
+  bsp_fit->init(3, knots, func);
+  bsp_fit->set_parameter_correction_iterations(2);
+  bsp_fit->compute();
+  auto ctrl_pts = bsp_fit->X();
+  REQUIRE(ctrl_pts.size() == knots.size() - 2);
+  Geo::Nub<Geo::VectorD<2>, double> nub;
+  nub.init(ctrl_pts, knots);
+  for (double t = 0; t <= 1; t += 1. / 1000)
+  {
+    Geo::VectorD<2> pt;
+    nub.eval(t, &pt, &pt + 1);
+    REQUIRE(std::abs(Geo::length(pt) - 1) < 1e-10);
+  }
+}
@@ -0,0 +1,221 @@
+#include "Catch/catch.hpp"
+#include "alloc_count.hh"
+#include <Geo/entity.hh>
+#include <Geo/vector.hh>
+
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <random>
+
+TEST_CASE("triangle_segment", "[CLOSEST_POINT]")
+{
+  Geo::Triangle tri = { { { 0, 0, 0 }, { 1, 0, 0 }, { 0, 1, 0 } } };
+  Geo::Segment seg = { { { 0.25, 0.25, -1 }, { 0.25, 0.25, 1 } } };
+  Geo::Point clsst_pt;
+  double t = 0, dist_sq = 1;
+  REQUIRE(Geo::closest_point(tri, seg, &clsst_pt, &t, &dist_sq));
+  REQUIRE(t == Approx(0.5));
+  REQUIRE(dist_sq < 1e-20);
+  REQUIRE(Geo::length(clsst_pt - Geo::Point{ 0.25, 0.25, 0 }) < 1e-12);
+
+  // Outside the triangle and too short.
+  seg = { { { 1, 1, -1 }, { 1, 1, 1 } } };
+  REQUIRE(!Geo::closest_point(tri, seg));
+  seg = { { { 0.25, 0.25, 1 }, { 0.25, 0.25, 2 } } };
+  REQUIRE(!Geo::closest_point(tri, seg));
+
+  // Parallel to the plane: a point of the segment is still found.
+  seg = { { { 0.1, 0.1, 1 }, { 0.2, 0.2, 1 } } };
+  REQUIRE(Geo::closest_point(tri, seg, nullptr, &t, &dist_sq));
+  REQUIRE(dist_sq == Approx(1));
+  seg = { { { 0.1, 0.1, 0 }, { 0.2, 0.2, 0 } } };
+  REQUIRE(Geo::closest_point(tri, seg, nullptr, &t, &dist_sq));
+  REQUIRE(dist_sq < 1e-20);
+}
+
+TEST_CASE("triangle_batch", "[CLOSEST_POINT]")
+{
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<double> dis(-1., 1.);
+  auto rand_pt = [&gen, &dis]() { return Geo::Point{ dis(gen), dis(gen), dis(gen) }; };
+
+  std::vector<Geo::Triangle> tris(37);
+  Geo::TriangleBatch batch;
+  for (auto& tri : tris)
+  {
+    tri = { rand_pt(), rand_pt(), rand_pt() };
+    batch.add(tri);
+  }
+  REQUIRE(batch.size() == tris.size());
+  for (size_t i = 0; i < 100; ++i)
+  {
+    Geo::Segment seg = { rand_pt(), rand_pt() };
+    size_t crossed = 0;
+    for (const auto& tri : tris)
+      crossed += Geo::closest_point(tri, seg);
+    double t, dist_sq;
+    auto best = batch.closest_point(seg, nullptr, &t, &dist_sq);
+    REQUIRE((best == SIZE_MAX) == (crossed == 0));
+    if (best == SIZE_MAX)
+      continue;
+    // Segments crossing several triangles have all distances near zero.
+    double t_tri, dist_sq_tri;
+    REQUIRE(Geo::closest_point(tris[best], seg, nullptr, &t_tri, &dist_sq_tri));
+    REQUIRE(t == Approx(t_tri));
+    REQUIRE(dist_sq < 1e-20);
+  }
+}
+
+// The batch filter (four triangles at a time with GEO_AVX2) must give the
+// result of the scalar test of every triangle in order.
+TEST_CASE("triangle_batch_filter", "[CLOSEST_POINT]")
+{
+  std::mt19937 gen(5);
+  std::uniform_real_distribution<double> dis(-1., 1.);
+  auto rand_pt = [&gen, &dis]() { return Geo::Point{ dis(gen), dis(gen), dis(gen) }; };
+
+  std::vector<Geo::Triangle> tris;
+  Geo::TriangleBatch batch;
+  for (size_t i = 0; i < 53; ++i)
+  {
+    Geo::Triangle tri = { rand_pt(), rand_pt(), rand_pt() };
+    // Some triangles on the plane z = 0 for segments on the same plane.
+    if (i % 5 == 0)
+    {
+      for (auto& pt : tri)
+        pt[2] = 0;
+    }
+    tris.push_back(tri);
+    batch.add(tri);
+  }
+  for (size_t i = 0; i < 1000; ++i)
+  {
+    Geo::Segment seg = { rand_pt(), rand_pt() };
+    if (i % 3 == 0)
+      seg[0][2] = seg[1][2] = 0;
+    else if (i % 3 == 1)
+      seg[1][2] = seg[0][2] + 1e-9 * dis(gen);
+    size_t best_tri = SIZE_MAX;
+    double t_tri = 0, dist_sq_tri = std::numeric_limits<double>::max();
+    for (size_t j = 0; j < tris.size(); ++j)
+    {
+      double t, dist_sq;
+      if (Geo::closest_point(tris[j], seg, nullptr, &t, &dist_sq) &&
+          dist_sq < dist_sq_tri)
+      {
+        best_tri = j;
+        t_tri = t;
+        dist_sq_tri = dist_sq;
+      }
+    }
+    double t, dist_sq;
+    REQUIRE(batch.closest_point(seg, nullptr, &t, &dist_sq) == best_tri);
+    if (best_tri == SIZE_MAX)
+      continue;
+    REQUIRE(t == t_tri);
+    REQUIRE(dist_sq == dist_sq_tri);
+  }
+}
+
+TEST_CASE("segment_segment", "[CLOSEST_POINT]")
+{
+  Geo::Segment seg_a = { { { 0, 0, 0 }, { 2, 0, 0 } } };
+  Geo::Segment seg_b = { { { 1, -1, 1 }, { 1, 1, 1 } } };
+  Geo::Point clsst_pt;
+  double t[2], dist_sq;
+  REQUIRE(Geo::closest_point(seg_a, seg_b, &clsst_pt, t, &dist_sq));
+  REQUIRE(t[0] == Approx(0.5));
+  REQUIRE(t[1] == Approx(0.5));
+  REQUIRE(dist_sq == Approx(1));
+  REQUIRE(Geo::length(clsst_pt - Geo::Point{ 1, 0, 0.5 }) < 1e-12);
+
+  // Parallel segments too far apart along their direction are out of
+  // range, parallel lines are projected.
+  Gen::Segment<double, 2> seg2_a = { { { 0, 0 }, { 1, 0 } } };
+  Gen::Segment<double, 2> seg2_b = { { { 3, 1 }, { 5, 1 } } };
+  REQUIRE(!Gen::closest_point<double, 2>(seg2_a, seg2_b));
+  REQUIRE(Gen::closest_point<double, 2, true, true>(
+    seg2_a, seg2_b, nullptr, t, &dist_sq));
+  REQUIRE(t[0] == 0);
+  REQUIRE(t[1] == Approx(-1.5));
+  REQUIRE(dist_sq == Approx(1));
+
+  // Degenerate segment.
+  seg2_b[1] = seg2_b[0];
+  REQUIRE(!Gen::closest_point<double, 2>(seg2_a, seg2_b));
+}
+
+// Parallel segments project the start of the shorter one on the other
+// one: the Boolean edge/edge intersection and SplitChain rely on it for
+// overlapping edges.
+TEST_CASE("segment_segment_parallel", "[CLOSEST_POINT]")
+{
+  Geo::Segment seg_a = { { { 0, 0, 0 }, { 2, 0, 0 } } };
+  Geo::Segment seg_b = { { { 1, 0, 0 }, { 3, 0, 0 } } };
+  Geo::Point clsst_pt;
+  double t[2], dist_sq;
+  REQUIRE(Geo::closest_point(seg_a, seg_b, &clsst_pt, t, &dist_sq));
+  REQUIRE(t[0] == 0.5);
+  REQUIRE(t[1] == 0);
+  REQUIRE(dist_sq == 0);
+  REQUIRE(clsst_pt == Geo::Point{ 1, 0, 0 });
+
+  // The start of _seg_b is outside _seg_a.
+  seg_b = { { { 3, 0, 0 }, { 1, 0, 0 } } };
+  REQUIRE(!Geo::closest_point(seg_a, seg_b));
+
+  // Parallel at distance 1.
+  seg_b = { { { 1, 1, 0 }, { 3, 1, 0 } } };
+  REQUIRE(Geo::closest_point(seg_a, seg_b, &clsst_pt, t, &dist_sq));
+  REQUIRE(t[0] == 0.5);
+  REQUIRE(t[1] == 0);
+  REQUIRE(dist_sq == Approx(1));
+
+  // _seg_a is shorter, its start is projected on _seg_b.
+  seg_b = { { { -1, 0, 0 }, { 5, 0, 0 } } };
+  REQUIRE(Geo::closest_point(seg_a, seg_b, &clsst_pt, t, &dist_sq));
+  REQUIRE(t[0] == 0);
+  REQUIRE(t[1] == Approx(1. / 6));
+  REQUIRE(dist_sq < 1e-20);
+  seg_b = { { { 1, 0, 0 }, { 5, 0, 0 } } };
+  REQUIRE(!Geo::closest_point(seg_a, seg_b));
+}
+
+TEST_CASE("segment_segment_no_allocation", "[CLOSEST_POINT]")
+{
+  std::mt19937 gen(7);
+  std::uniform_real_distribution<double> dis(-1., 1.);
+  std::vector<Geo::Segment> segs(64);
+  for (auto& seg : segs)
+    for (auto& pt : seg)
+      pt = { dis(gen), dis(gen), dis(gen) };
+  size_t found = 0;
+  const auto alloc_start = UnitTest::allocation_count();
+  for (const auto& seg_a : segs)
+    for (const auto& seg_b : segs)
+    {
+      double t[2], dist_sq;
+      found += Geo::closest_point(seg_a, seg_b, nullptr, t, &dist_sq);
+    }
+  REQUIRE(UnitTest::allocation_count() == alloc_start);
+  REQUIRE(found > 0);
+}
+
+TEST_CASE("segment_segment_bench", "[.][BENCH]")
+{
+  std::mt19937 gen(7);
+  std::uniform_real_distribution<double> dis(-1., 1.);
+  std::vector<Geo::Segment> segs(1024);
+  for (auto& seg : segs)
+    for (auto& pt : seg)
+      pt = { dis(gen), dis(gen), dis(gen) };
+  size_t found = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (const auto& seg_a : segs)
+    for (const auto& seg_b : segs)
+      found += Geo::closest_point(seg_a, seg_b);
+  std::chrono::duration<double> dur = std::chrono::steady_clock::now() - start;
+  std::cout << "segment_segment: " << segs.size() * segs.size() << " calls in "
+    << dur.count() << "s, " << found << " found" << std::endl;
+}
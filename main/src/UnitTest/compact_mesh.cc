@@ -0,0 +1,319 @@
+#include "Catch/catch.hpp"
+
+#include "topology_help.hh"
+
+#include <Geo/kdtree.hh>
+#include <Import/import.hh>
+#include <Topology/binary_mesh.hh>
+#include <Topology/compact_mesh.hh>
+#include <Topology/iterator.hh>
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <sstream>
+
+using namespace UnitTest;
+
+#define MESH_FOLDER "C:/Users/marco/OneDrive/Documents/PROJECTS/polytriagnulation/mesh/"
+
+namespace {
+
+void check_twins(const Topo::CompactMesh& _mesh)
+{
+  for (Topo::CompactMesh::Index h = 0; h < _mesh.half_edge_count(); ++h)
+  {
+    const auto twin = _mesh.he_twin_[h];
+    if (twin == Topo::CompactMesh::INVALID)
+      continue;
+    REQUIRE(_mesh.he_twin_[twin] == h);
+    REQUIRE(_mesh.he_vert_[twin] == _mesh.he_vert_[_mesh.he_next_[h]]);
+    REQUIRE(_mesh.he_vert_[h] == _mesh.he_vert_[_mesh.he_next_[twin]]);
+  }
+}
+
+void check_same(const Topo::CompactMesh& _a, const Topo::CompactMesh& _b)
+{
+  REQUIRE(_a.vert_pos_ == _b.vert_pos_);
+  REQUIRE(_a.vert_tol_ == _b.vert_tol_);
+  REQUIRE(_a.he_vert_ == _b.he_vert_);
+  REQUIRE(_a.he_next_ == _b.he_next_);
+  REQUIRE(_a.he_twin_ == _b.he_twin_);
+  REQUIRE(_a.he_face_ == _b.he_face_);
+  REQUIRE(_a.loop_he_ == _b.loop_he_);
+  REQUIRE(_a.face_loop_ == _b.face_loop_);
+  REQUIRE(_a.face_has_loops_ == _b.face_has_loops_);
+}
+
+// A cube and a face with a hole.
+Topo::Wrap<Topo::Type::BODY> make_holed_body()
+{
+  auto body = make_cube(cube_00);
+  Topo::Wrap<Topo::Type::FACE> face;
+  face.make<Topo::EE<Topo::Type::FACE>>();
+  body->insert_child(face.get());
+  const double sq[2][4][2] = {
+    { { 0, 0 }, { 4, 0 }, { 4, 4 }, { 0, 4 } },
+    { { 1, 1 }, { 1, 2 }, { 2, 2 }, { 2, 1 } } };
+  for (const auto& lp : sq)
+  {
+    Topo::Wrap<Topo::Type::LOOP> loop;
+    loop.make<Topo::EE<Topo::Type::LOOP>>();
+    face->insert_child(loop.get());
+    for (const auto& xy : lp)
+    {
+      Topo::Wrap<Topo::Type::VERTEX> vert;
+      vert.make<Topo::EE<Topo::Type::VERTEX>>();
+      vert->set_geom(Geo::Point{ xy[0], xy[1], 3 });
+      loop->insert_child(vert.get());
+    }
+  }
+  return body;
+}
+
+std::string file_content(const char* _flnm)
+{
+  std::ifstream fstr(_flnm);
+  std::stringstream buf;
+  buf << fstr.rdbuf();
+  return buf.str();
+}
+
+}//namespace
+
+TEST_CASE("compact_mesh", "[Topo]")
+{
+  auto body = make_holed_body();
+  Topo::CompactMesh mesh;
+  mesh.from_body(body);
+  REQUIRE(mesh.vertex_count() == 16);
+  REQUIRE(mesh.face_count() == 7);
+  REQUIRE(mesh.loop_count() == 8);
+  REQUIRE(mesh.half_edge_count() == 32);
+  check_twins(mesh);
+  // The cube is closed, the holed face is all boundary.
+  for (Topo::CompactMesh::Index h = 0; h < mesh.half_edge_count(); ++h)
+    REQUIRE((mesh.he_twin_[h] == Topo::CompactMesh::INVALID) == (mesh.he_face_[h] == 6));
+  REQUIRE(mesh.edge_items().size() == 20);
+
+  // Faces see the same boxes as the topological ones.
+  Topo::Iterator<Topo::Type::BODY, Topo::Type::FACE> bf_it(body);
+  for (Topo::CompactMesh::Index f = 0; f < 6; ++f)
+  {
+    auto box = bf_it.get(f)->box();
+    auto cbox = mesh.face_box(f);
+    for (size_t i = 0; i < 2; ++i)
+      REQUIRE(cbox.extr_[i] == box.extr_[i]);
+    REQUIRE(mesh.face_centroid(f) == bf_it.get(f)->internal_point());
+  }
+
+  auto back = mesh.to_body();
+  Topo::CompactMesh mesh_back;
+  mesh_back.from_body(back);
+  check_same(mesh, mesh_back);
+
+  // A face added with two loops keeps them without _has_loops.
+  mesh.add_face({ { 8, 9, 10, 11 }, { 12, 13, 14, 15 } });
+  REQUIRE(mesh.face_has_loops_.back());
+  back = mesh.to_body();
+  Topo::Iterator<Topo::Type::BODY, Topo::Type::FACE> back_faces(back);
+  Topo::Iterator<Topo::Type::FACE, Topo::Type::LOOP> fl_it(back_faces.get(7));
+  REQUIRE(fl_it.size() == 2);
+}
+
+TEST_CASE("compact_mesh_kdtree", "[Topo]")
+{
+  auto body_a = make_cube(cube_00);
+  auto body_b = make_cube(cube_03);
+  Topo::CompactMesh mesh_a, mesh_b;
+  mesh_a.from_body(body_a);
+  mesh_b.from_body(body_b);
+
+  // Face index of the topological faces.
+  Topo::Iterator<Topo::Type::BODY, Topo::Type::FACE> faces[2] = { body_a, body_b };
+  auto face_index = [&faces](size_t _i, const Topo::Wrap<Topo::Type::FACE>& _face)
+  {
+    return size_t(std::find(faces[_i].begin(), faces[_i].end(), _face) - faces[_i].begin());
+  };
+  Geo::KdTree<Topo::Wrap<Topo::Type::FACE>> kd_faces[2];
+  for (size_t i = 0; i < 2; ++i)
+  {
+    kd_faces[i].insert(faces[i].begin(), faces[i].end());
+    kd_faces[i].compute();
+  }
+  std::set<std::array<size_t, 2>> topo_couples;
+  for (const auto& pr : Geo::find_kdtree_couples(kd_faces[0], kd_faces[1]))
+    topo_couples.insert({ face_index(0, kd_faces[0][pr[0]]), face_index(1, kd_faces[1][pr[1]]) });
+
+  Geo::KdTree<Topo::CompactMesh::Item> kd_items[2];
+  const Topo::CompactMesh* meshes[2] = { &mesh_a, &mesh_b };
+  for (size_t i = 0; i < 2; ++i)
+  {
+    auto items = meshes[i]->face_items();
+    kd_items[i].insert(items.begin(), items.end());
+    kd_items[i].compute();
+  }
+  std::set<std::array<size_t, 2>> compact_couples;
+  for (const auto& pr : Geo::find_kdtree_couples(kd_items[0], kd_items[1]))
+    compact_couples.insert({ kd_items[0][pr[0]].ind_, kd_items[1][pr[1]].ind_ });
+  REQUIRE(!compact_couples.empty());
+  REQUIRE(compact_couples == topo_couples);
+
+  Geo::KdTree<Topo::CompactMesh::Item> kd_edges[2];
+  for (size_t i = 0; i < 2; ++i)
+  {
+    auto items = meshes[i]->edge_items();
+    REQUIRE(items.size() == 12);
+    kd_edges[i].insert(items.begin(), items.end());
+    kd_edges[i].compute();
+  }
+  REQUIRE(!Geo::find_kdtree_couples(kd_edges[0], kd_edges[1]).empty());
+}
+
+TEST_CASE("compact_mesh_io", "[Topo]")
+{
+  auto body = make_cube(cube_04);
+  IO::save_obj("compact_mesh_body.obj", body, false);
+  Topo::CompactMesh mesh;
+  mesh.from_body(body);
+  IO::save_obj("compact_mesh.obj", mesh);
+  REQUIRE(file_content("compact_mesh.obj") == file_content("compact_mesh_body.obj"));
+
+  // The compact loader numbers the vertices as the file, from_body in
+  // order of first use.
+  auto loaded = IO::load_obj_compact("compact_mesh.obj");
+  check_twins(loaded);
+  Topo::CompactMesh from_loaded, from_body;
+  from_loaded.from_body(loaded.to_body());
+  from_body.from_body(IO::load_obj("compact_mesh.obj"));
+  check_same(from_loaded, from_body);
+  for (auto twin : loaded.he_twin_)
+    REQUIRE(twin != Topo::CompactMesh::INVALID);
+}
+
+TEST_CASE("binary_mesh", "[Topo]")
+{
+  Topo::CompactMesh mesh;
+  mesh.from_body(make_holed_body());
+  mesh.vert_tol_[3] = 1e-3;
+  REQUIRE(Topo::save_binary("binary_mesh.bin", mesh));
+
+  Topo::BinaryMesh bin;
+  REQUIRE(bin.open("binary_mesh.bin"));
+  REQUIRE(bin.vertex_count() == mesh.vertex_count());
+  REQUIRE(bin.face_count() == mesh.face_count());
+  REQUIRE(bin.loop_count() == mesh.loop_count());
+  for (Topo::CompactMesh::Index v = 0; v < mesh.vertex_count(); ++v)
+  {
+    REQUIRE(bin.vertex(v) == mesh.vert_pos_[v]);
+    REQUIRE(bin.tolerance(v) == mesh.vert_tol_[v]);
+  }
+  check_same(bin.to_compact(), mesh);
+  Topo::CompactMesh from_bin;
+  from_bin.from_body(bin.to_body());
+  check_same(from_bin, mesh);
+
+  // Faces made one by one share the vertices.
+  Topo::BinaryMesh lazy;
+  REQUIRE(lazy.open("binary_mesh.bin"));
+  std::vector<Topo::CompactMesh::Index> lv[2];
+  mesh.loop_vertices(0, lv[0]);
+  size_t shared = 0, f = 1;
+  for (; shared == 0; ++f)
+  {
+    mesh.loop_vertices(Topo::CompactMesh::Index(f), lv[1]);
+    for (auto v : lv[0])
+      shared += std::count(lv[1].begin(), lv[1].end(), v);
+  }
+  auto f0 = lazy.face(0), f1 = lazy.face(Topo::CompactMesh::Index(f - 1));
+  Topo::Iterator<Topo::Type::FACE, Topo::Type::VERTEX> fv[2] = { f0, f1 };
+  size_t shared_verts = 0;
+  for (const auto& v0 : fv[0])
+    shared_verts += std::count(fv[1].begin(), fv[1].end(), v0);
+  REQUIRE(shared_verts == shared);
+  auto holed = lazy.face(6);
+  REQUIRE(holed->size(Topo::Direction::Down) == 2);
+  REQUIRE(holed->get(Topo::Direction::Down, 0)->type() == Topo::Type::LOOP);
+
+  // Offsets out of the blocks: the file opens, the faces throw.
+  auto corrupt = [&mesh](const char* _flnm, size_t _block, size_t _i)
+  {
+    auto padded = [](size_t _bytes) { return (_bytes + 7) & ~size_t(7); };
+    const size_t idx_size = sizeof(Topo::CompactMesh::Index);
+    // 48 bytes of header, then positions and tolerances.
+    size_t pos = 48 + 4 * mesh.vertex_count() * sizeof(double);
+    if (_block == 1)
+      pos += padded((mesh.face_count() + 1) * idx_size);
+    std::ifstream in("binary_mesh.bin", std::ios::binary);
+    std::string content{ std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>() };
+    const Topo::CompactMesh::Index big = 1000000;
+    memcpy(&content[pos + _i * idx_size], &big, idx_size);
+    std::ofstream(_flnm, std::ios::binary) << content;
+  };
+  corrupt("binary_mesh_face.bin", 0, 1);
+  corrupt("binary_mesh_loop.bin", 1, 1);
+  for (auto flnm : { "binary_mesh_face.bin", "binary_mesh_loop.bin" })
+  {
+    Topo::BinaryMesh bad;
+    REQUIRE(bad.open(flnm));
+    REQUIRE_THROWS(bad.face(0));
+    REQUIRE_THROWS(bad.to_compact());
+    REQUIRE_THROWS(bad.to_body());
+  }
+
+  // Not mesh files.
+  IO::save_obj("binary_mesh.obj", mesh);
+  REQUIRE(!lazy.open("binary_mesh.obj"));
+  REQUIRE(!lazy.open("no_binary_mesh.bin"));
+  REQUIRE(lazy.face_count() == 0);
+}
+
+TEST_CASE("compact_mesh_bench", "[.][BENCH]")
+{
+  auto start = std::chrono::steady_clock::now();
+  auto body = IO::load_obj(MESH_FOLDER"elepham.obj");
+  std::chrono::duration<double> dur = std::chrono::steady_clock::now() - start;
+  std::cout << "elepham load_obj: " << dur.count() << "s" << std::endl;
+
+  start = std::chrono::steady_clock::now();
+  auto mesh = IO::load_obj_compact(MESH_FOLDER"elepham.obj");
+  dur = std::chrono::steady_clock::now() - start;
+  std::cout << "elepham load_obj_compact: " << dur.count() << "s, " <<
+    mesh.face_count() << " faces, " <<
+    double(mesh.memory()) / mesh.face_count() << " bytes per face" << std::endl;
+
+  Geo::KdTree<Topo::CompactMesh::Item> kd_items;
+  start = std::chrono::steady_clock::now();
+  auto items = mesh.face_items();
+  kd_items.insert(items.begin(), items.end());
+  kd_items.compute();
+  auto couples = Geo::find_kdtree_couples(kd_items, kd_items);
+  dur = std::chrono::steady_clock::now() - start;
+  std::cout << "compact self couples: " << couples.size() << " in " << dur.count() << "s" << std::endl;
+
+  Topo::Iterator<Topo::Type::BODY, Topo::Type::FACE> bf_it(body);
+  Geo::KdTree<Topo::Wrap<Topo::Type::FACE>> kd_faces;
+  start = std::chrono::steady_clock::now();
+  kd_faces.insert(bf_it.begin(), bf_it.end());
+  kd_faces.compute();
+  couples = Geo::find_kdtree_couples(kd_faces, kd_faces);
+  dur = std::chrono::steady_clock::now() - start;
+  std::cout << "topo self couples: " << couples.size() << " in " << dur.count() << "s" << std::endl;
+
+  Topo::save_binary("elepham.bin", mesh);
+  start = std::chrono::steady_clock::now();
+  Topo::BinaryMesh bin;
+  bin.open("elepham.bin");
+  dur = std::chrono::steady_clock::now() - start;
+  std::cout << "elepham binary open: " << dur.count() << "s" << std::endl;
+  start = std::chrono::steady_clock::now();
+  mesh = bin.to_compact();
+  dur = std::chrono::steady_clock::now() - start;
+  std::cout << "elepham binary to compact: " << dur.count() << "s" << std::endl;
+  start = std::chrono::steady_clock::now();
+  body = bin.to_body();
+  dur = std::chrono::steady_clock::now() - start;
+  std::cout << "elepham binary to body: " << dur.count() << "s" << std::endl;
+}
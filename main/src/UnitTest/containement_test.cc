@@ -76,4 +76,123 @@ TEST_CASE("containement_basic_002", "[Containement]")
     }
   }
   REQUIRE(nmbr == std::size(intervals));
-}
\ No newline at end of file
+}
+
+TEST_CASE("containement_bulk", "[Containement]")
+{
+  // A big square around a grid of squares, each one with a square inside.
+  using Square = std::array<double, 3>; // x, y, side
+  using SquareTree = Utils::ContainementTree<Square>;
+  auto box = [](const Square& _sq)
+  {
+    SquareTree::Box box;
+    box.min_ = { _sq[0], _sq[1] };
+    box.max_ = { _sq[0] + _sq[2], _sq[1] + _sq[2] };
+    return box;
+  };
+  size_t cmp_nmbr = 0;
+  SquareTree sq_tree([&box, &cmp_nmbr](const Square& _a, const Square& _b)
+  {
+    ++cmp_nmbr;
+    if (box(_b).contains(box(_a)))
+      return -1;
+    if (box(_a).contains(box(_b)))
+      return 1;
+    return 0;
+  });
+  const size_t N = 30;
+  std::vector<Square> squares;
+  for (size_t i = 0; i < N; ++i)
+  {
+    for (size_t j = 0; j < N; ++j)
+    {
+      squares.push_back({ 0.25 + i, 0.25 + j, 0.5 });
+      squares.push_back({ 0.1 + i, 0.1 + j, 0.8 });
+    }
+  }
+  squares.push_back({ 0, 0, double(N) });
+  sq_tree.add(squares, box);
+  auto root = sq_tree.root();
+  REQUIRE(root->next() == nullptr);
+  REQUIRE(root->data() == squares.back());
+  size_t child_nmbr = 0;
+  for (auto el = root->child(); el != nullptr; el = el->next(), ++child_nmbr)
+  {
+    REQUIRE(el->data()[2] == 0.8);
+    REQUIRE(el->child() != nullptr);
+    REQUIRE(el->child()->next() == nullptr);
+    REQUIRE(el->child()->child() == nullptr);
+    REQUIRE(box(el->data()).contains(box(el->child()->data())));
+  }
+  REQUIRE(child_nmbr == N * N);
+  // One comparison for each contained square.
+  REQUIRE(cmp_nmbr == 2 * N * N);
+
+  // Same tree asking only if the containers contain the squares.
+  size_t inside_nmbr = 0;
+  auto inside = [&box, &inside_nmbr](const Square& _a, const Square& _b)
+  {
+    ++inside_nmbr;
+    return box(_b).contains(box(_a));
+  };
+  cmp_nmbr = 0;
+  SquareTree in_tree([&cmp_nmbr](const Square&, const Square&)
+  {
+    ++cmp_nmbr;
+    return 0;
+  });
+  in_tree.add(squares, box, 0, inside);
+  REQUIRE(cmp_nmbr == 0);
+  REQUIRE(inside_nmbr == 2 * N * N);
+  auto in_el = in_tree.root()->child();
+  for (auto el = root->child(); el != nullptr; el = el->next(), in_el = in_el->next())
+  {
+    REQUIRE(in_el->data() == el->data());
+    REQUIRE(in_el->child()->data() == el->child()->data());
+  }
+  REQUIRE(in_el == nullptr);
+}
+
+TEST_CASE("containement_bulk_tolerance", "[Containement]")
+{
+  // An island touching the boundary within the tolerance, its box is
+  // just outside the boundary box.
+  using Square = std::array<double, 3>; // x, y, side
+  using SquareTree = Utils::ContainementTree<Square>;
+  const double TOL = 1e-6;
+  auto box = [](const Square& _sq)
+  {
+    SquareTree::Box box;
+    box.min_ = { _sq[0], _sq[1] };
+    box.max_ = { _sq[0] + _sq[2], _sq[1] + _sq[2] };
+    return box;
+  };
+  auto compare = [&box, TOL](const Square& _a, const Square& _b)
+  {
+    if (box(_b).contains(box(_a), TOL))
+      return -1;
+    if (box(_a).contains(box(_b), TOL))
+      return 1;
+    return 0;
+  };
+  const std::vector<Square> squares = {
+    { -1e-9, 2, 1 }, { 0, 0, 10 }, { 5, 5, 1 }, { 20, 0, 1 } };
+  for (double tol : { TOL, 0. })
+  {
+    SquareTree sq_tree(compare);
+    sq_tree.add(squares, box, tol);
+    auto root = sq_tree.root();
+    REQUIRE(root->data() == (tol > 0 ? squares[1] : squares[0]));
+    if (tol == 0)
+    {
+      // The island is dropped out of the boundary.
+      REQUIRE(root->child() == nullptr);
+      continue;
+    }
+    REQUIRE(root->next()->data() == squares[3]);
+    REQUIRE(root->next()->next() == nullptr);
+    REQUIRE(root->child()->data() == squares[0]);
+    REQUIRE(root->child()->next()->data() == squares[2]);
+    REQUIRE(root->child()->next()->next() == nullptr);
+  }
+}
@@ -0,0 +1,209 @@
+#include "Catch/catch.hpp"
+#include <Geo/banded_system.hh>
+#include <Geo/linear_system.hh>
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+
+template <size_t N>
+void random_spd(std::mt19937& _gen, double (&_A)[N][N], double (&_b)[N])
+{
+  std::uniform_real_distribution<double> dis(-1., 1.);
+  double M[N][N];
+  for (size_t i = 0; i < N; ++i)
+  {
+    _b[i] = dis(_gen);
+    for (size_t j = 0; j < N; ++j)
+      M[i][j] = dis(_gen);
+  }
+  for (size_t i = 0; i < N; ++i)
+    for (size_t j = 0; j < N; ++j)
+    {
+      _A[i][j] = i == j ? 0.1 : 0.;
+      for (size_t k = 0; k < N; ++k)
+        _A[i][j] += M[k][i] * M[k][j];
+    }
+}
+
+template <size_t N>
+double residual(const double (&_A)[N][N], const double (&_x)[N], const double (&_b)[N])
+{
+  double res = 0;
+  for (size_t i = 0; i < N; ++i)
+  {
+    double r = -_b[i];
+    for (size_t j = 0; j < N; ++j)
+      r += _A[i][j] * _x[j];
+    res = std::max(res, std::fabs(r));
+  }
+  return res;
+}
+
+constexpr double solve_at_compile_time()
+{
+  const double A[2][2] = { { 2, 1 }, { 1, 3 } };
+  const double b[2] = { 3, 4 };
+  double x[2] = {};
+  Geo::solve<2, Geo::LinearSolver::LDLT>(A, x, b);
+  return x[0] + x[1];
+}
+
+}//namespace
+
+TEST_CASE("small_systems", "[LINEAR_SYSTEM]")
+{
+  static_assert(solve_at_compile_time() > 1.99 && solve_at_compile_time() < 2.01,
+    "Compile time solution");
+  std::mt19937 gen(3);
+  for (size_t i = 0; i < 100; ++i)
+  {
+    double A2[2][2], b2[2], x2[2];
+    random_spd(gen, A2, b2);
+    REQUIRE(Geo::solve<2>(A2, x2, b2));
+    REQUIRE(residual(A2, x2, b2) < 1e-10);
+    REQUIRE(Geo::solve<2, Geo::LinearSolver::LDLT>(A2, x2, b2));
+    REQUIRE(residual(A2, x2, b2) < 1e-10);
+
+    double A3[3][3], b3[3], x3[3];
+    random_spd(gen, A3, b3);
+    REQUIRE(Geo::solve_3x3(A3, x3, b3));
+    REQUIRE(residual(A3, x3, b3) < 1e-10);
+    REQUIRE(Geo::solve<3, Geo::LinearSolver::LDLT>(A3, x3, b3));
+    REQUIRE(residual(A3, x3, b3) < 1e-10);
+
+    double A5[5][5], b5[5], x5[5];
+    random_spd(gen, A5, b5);
+    REQUIRE(Geo::solve<5, Geo::LinearSolver::LDLT>(A5, x5, b5));
+    REQUIRE(residual(A5, x5, b5) < 1e-10);
+  }
+  // Not symmetric.
+  const double A[2][2] = { { 1, 2 }, { 0, 1 } }, b[2] = { 5, 2 };
+  double x[2];
+  REQUIRE(Geo::solve_2x2(A, x, b));
+  REQUIRE(x[0] == Approx(1));
+  REQUIRE(x[1] == Approx(2));
+  const double S[2][2] = { { 1, 2 }, { 2, 4 } };
+  REQUIRE(!Geo::solve<2>(S, x, b));
+  REQUIRE(!Geo::solve<2, Geo::LinearSolver::LDLT>(S, x, b));
+}
+
+TEST_CASE("least_squares", "[LINEAR_SYSTEM]")
+{
+  using V3 = std::array<double, 3>;
+  const V3 cols[3] = { { 1, 0, 0 }, { 0, 2, 0 }, { 0, 0, -1 } };
+  double x[3];
+  Geo::least_squares(cols, V3{ 0.5, 0.5, 0.25 }, x);
+  REQUIRE(x[0] == Approx(0.5));
+  REQUIRE(x[1] == Approx(0.25));
+  REQUIRE(x[2] == Approx(-0.25));
+
+  // Overdetermined: the residual is orthogonal to the columns.
+  std::mt19937 gen(5);
+  std::uniform_real_distribution<double> dis(-1., 1.);
+  for (size_t i = 0; i < 100; ++i)
+  {
+    const V3 c2[2] = { { dis(gen), dis(gen), dis(gen) }, { dis(gen), dis(gen), dis(gen) } };
+    const V3 b = { dis(gen), dis(gen), dis(gen) };
+    double x2[2];
+    Geo::least_squares(c2, b, x2);
+    for (const auto& c : c2)
+    {
+      double res = 0;
+      for (size_t k = 0; k < 3; ++k)
+        res += c[k] * (x2[0] * c2[0][k] + x2[1] * c2[1][k] - b[k]);
+      REQUIRE(std::fabs(res) < 1e-10);
+    }
+  }
+
+  // Parallel columns: the component on the null pivot is zero.
+  const V3 par[2] = { { 1, 0, 0 }, { 2, 0, 0 } };
+  double x2[2];
+  Geo::least_squares(par, V3{ 4, 1, 0 }, x2);
+  REQUIRE(x2[0] == 0);
+  REQUIRE(x2[1] == Approx(2));
+}
+
+TEST_CASE("small_systems_bench", "[.][BENCH]")
+{
+  const size_t n = 1 << 16;
+  std::mt19937 gen(5);
+  std::vector<std::array<double, 9>> As(n);
+  std::vector<std::array<double, 3>> bs(n), xs(n);
+  for (size_t k = 0; k < n; ++k)
+  {
+    double A3[3][3], b3[3];
+    random_spd(gen, A3, b3);
+    for (size_t i = 0; i < 3; ++i)
+    {
+      bs[k][i] = b3[i];
+      for (size_t j = 0; j < 3; ++j)
+        As[k][i * 3 + j] = A3[i][j];
+    }
+  }
+  auto time = [](const char* _name, auto _func)
+  {
+    auto start = std::chrono::steady_clock::now();
+    for (int rep = 0; rep < 20; ++rep)
+      _func();
+    std::chrono::duration<double> dur = std::chrono::steady_clock::now() - start;
+    std::cout << _name << ": " << dur.count() << "s" << std::endl;
+  };
+  time("solve_3x3", [&]()
+  {
+    for (size_t k = 0; k < n; ++k)
+      Geo::solve_3x3(reinterpret_cast<const double(*)[3]>(As[k].data()), xs[k].data(), bs[k].data());
+  });
+  time("solve<3, LDLT>", [&]()
+  {
+    for (size_t k = 0; k < n; ++k)
+      Geo::solve<3, Geo::LinearSolver::LDLT>(
+        *reinterpret_cast<const double(*)[3][3]>(As[k].data()),
+        *reinterpret_cast<double(*)[3]>(xs[k].data()),
+        *reinterpret_cast<const double(*)[3]>(bs[k].data()));
+  });
+}
+
+TEST_CASE("banded_system", "[LINEAR_SYSTEM]")
+{
+  std::mt19937 gen(17);
+  std::uniform_real_distribution<double> dis(-1., 1.);
+  for (size_t band : { 0, 1, 3 })
+  {
+    // Diagonally dominant symmetric banded matrix.
+    const size_t n = 200;
+    Geo::BandedSymmetricMatrix A;
+    A.init(n, band);
+    for (size_t i = 0; i < n; ++i)
+    {
+      for (size_t j = i > band ? i - band : 0; j < i; ++j)
+        A(i, j) = dis(gen);
+      A(i, i) = 2. * band + 1;
+    }
+    auto full = [&A, band](size_t _i, size_t _j)
+    {
+      if (_i < _j)
+        std::swap(_i, _j);
+      return _i - _j > band ? 0. : A(_i, _j);
+    };
+    std::vector<double> x(n), b(n, 0.);
+    for (auto& v : x)
+      v = dis(gen);
+    for (size_t i = 0; i < n; ++i)
+      for (size_t j = 0; j < n; ++j)
+        b[i] += full(i, j) * x[j];
+    REQUIRE(A.cholesky());
+    A.solve(b);
+    for (size_t i = 0; i < n; ++i)
+      REQUIRE(b[i] == Approx(x[i]).margin(1e-12));
+  }
+  Geo::BandedSymmetricMatrix A;
+  A.init(2, 1);
+  A(0, 0) = A(1, 1) = A(1, 0) = 1;
+  REQUIRE(!A.cholesky());
+}
@@ -2,9 +2,10 @@
 
 #include "Geo/linking_number.hh"
 
+#include <chrono>
+#include <cmath>
 #include <iostream>
 
-#if 0
 TEST_CASE("LnDisconnected", "[LINNUM]")
 {
   std::vector<Geo::Vector<double, 3>> loop0 = {
@@ -38,7 +39,7 @@ TEST_CASE("Link1", "[LINNUM]")
   { -0.5, 0.5, -0.5 }
   };
   auto res = Geo::LinkingNumber::compute(loop0, loop1);
-  REQUIRE(res == 0);
+  REQUIRE(std::abs(res) == 1);
 }
 
 TEST_CASE("Link1_a", "[LINNUM]")
@@ -57,6 +58,51 @@ TEST_CASE("Link1_a", "[LINNUM]")
     { -0.5, 0.5, -0.5 }
   };
   auto res = Geo::LinkingNumber::compute(loop0, loop1);
-  REQUIRE(res == 0);
+  REQUIRE(std::abs(res) == 1);
+}
+
+namespace {
+
+// Curve winding _turns times around the unit circle in the xy plane.
+std::vector<Geo::VectorD3> torus_curve(size_t _n, double _rad, int _turns)
+{
+  std::vector<Geo::VectorD3> loop(_n);
+  for (size_t i = 0; i < _n; ++i)
+  {
+    auto t = 2 * M_PI * i / _n;
+    auto r = 1 + _rad * std::cos(_turns * t);
+    loop[i] = { r * std::cos(t), r * std::sin(t), _rad * std::sin(_turns * t) };
+  }
+  return loop;
+}
+
+}//namespace
+
+TEST_CASE("LinkTorus", "[LINNUM]")
+{
+  auto core = torus_curve(1000, 0, 0);
+  for (int turns : { 0, 1, 2, 5 })
+  {
+    auto loop = torus_curve(1500, 0.2, turns);
+    auto exact = Geo::LinkingNumber::integral(core, loop, 0);
+    REQUIRE(std::abs(std::abs(exact) - turns) < 1e-6);
+    auto fast = Geo::LinkingNumber::integral(core, loop);
+    REQUIRE(std::abs(fast - exact) < 0.1);
+    REQUIRE(Geo::LinkingNumber::compute(core, loop) == std::round(exact));
+    REQUIRE(Geo::LinkingNumber::compute(loop, core) == std::round(exact));
+  }
+}
+
+TEST_CASE("LinkTorusBench", "[.][BENCH]")
+{
+  auto core = torus_curve(8000, 0, 0);
+  auto loop = torus_curve(8000, 0.2, 3);
+  for (double theta : { 0., 0.25, 0.5 })
+  {
+    auto start = std::chrono::steady_clock::now();
+    auto val = Geo::LinkingNumber::integral(core, loop, theta);
+    std::chrono::duration<double> dt = std::chrono::steady_clock::now() - start;
+    std::cout << "Linking number theta " << theta << ": " << val <<
+      " in " << dt.count() << "s" << std::endl;
+  }
 }
-#endif
\ No newline at end of file
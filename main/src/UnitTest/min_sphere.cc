@@ -0,0 +1,145 @@
+#include "Catch/catch.hpp"
+#include <Geo/minsphere.hh>
+#include <Geo/vector.hh>
+
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+TEST_CASE("min_ball", "[MINSPHERE]")
+{
+  std::vector<Geo::VectorD3> pts = { { 1, 0, 0 }, { -1, 0, 0 } };
+  auto sph = Geo::min_ball(pts.data(), pts.size());
+  REQUIRE(sph.radius_ == Approx(1));
+  REQUIRE(Geo::length(sph.centre_) < 1e-12);
+
+  pts = { { 1, 0, 0 }, { 0, 1, 0 }, { -1, 0, 0 }, { 0, 0, 1 } };
+  sph = Geo::min_ball(pts.data(), pts.size());
+  REQUIRE(sph.radius_ == Approx(1));
+  REQUIRE(Geo::length(sph.centre_) < 1e-12);
+}
+
+namespace {
+
+// True if all the points are in the sphere, up to the rounding.
+bool contains_all(const Geo::MinSphereT<Geo::VectorD3>& _sph,
+  const std::vector<Geo::VectorD3>& _pts)
+{
+  for (const auto& pt : _pts)
+  {
+    if (Geo::length(pt - _sph.centre_) > _sph.radius_ * (1 + 1e-9) + 1e-12)
+      return false;
+  }
+  return true;
+}
+
+// Radius of the smallest sphere through 1 to 4 of the points containing
+// all of them.
+double brute_force_radius(const std::vector<Geo::VectorD3>& _pts)
+{
+  double best = std::numeric_limits<double>::max();
+  const size_t n = _pts.size();
+  for (size_t mask = 1; mask < (size_t(1) << n); ++mask)
+  {
+    Geo::VectorD3 sub[4];
+    size_t sub_nmbr = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+      if (mask & (size_t(1) << i))
+      {
+        if (sub_nmbr < 4)
+          sub[sub_nmbr] = _pts[i];
+        ++sub_nmbr;
+      }
+    }
+    if (sub_nmbr > 4)
+      continue;
+    Geo::MinSphereT<Geo::VectorD3> sph(sub, sub_nmbr);
+    if (sph.radius_ >= 0 && sph.radius_ < best && contains_all(sph, _pts))
+      best = sph.radius_;
+  }
+  return best;
+}
+
+} // namespace
+
+TEST_CASE("min_ball_known", "[MINSPHERE]")
+{
+  struct Case
+  {
+    std::vector<Geo::VectorD3> pts_;
+    Geo::VectorD3 centre_;
+    double radius_;
+  };
+  const Case cases[] = {
+    // Equilateral triangle.
+    { { { 0, 0, 0 }, { 1, 0, 0 }, { 0.5, std::sqrt(0.75), 0 } },
+      { 0.5, std::sqrt(0.75) / 3, 0 }, 1 / std::sqrt(3.) },
+    // Obtuse triangle: the longest side is a diameter.
+    { { { 0, 0, 0 }, { 4, 0, 0 }, { 1, 1, 0 } }, { 2, 0, 0 }, 2 },
+    // Regular tetrahedron with a point inside.
+    { { { 1, 1, 1 }, { 0, 0, 0.1 }, { 1, -1, -1 }, { -1, 1, -1 }, { -1, -1, 1 } },
+      { 0, 0, 0 }, std::sqrt(3.) },
+    // Collinear and repeated points.
+    { { { 0, 0, 0 }, { 1, 1, 1 }, { 3, 3, 3 }, { 1, 1, 1 }, { 2, 2, 2 } },
+      { 1.5, 1.5, 1.5 }, 1.5 * std::sqrt(3.) },
+    // Cube vertices, all the supports are coplanar.
+    { { { 0, 0, 0 }, { 1, 0, 0 }, { 0, 1, 0 }, { 1, 1, 0 },
+        { 0, 0, 1 }, { 1, 0, 1 }, { 0, 1, 1 }, { 1, 1, 1 } },
+      { 0.5, 0.5, 0.5 }, std::sqrt(0.75) },
+    // Square far from the origin.
+    { { { 1000, 1000, 5 }, { 1002, 1000, 5 }, { 1000, 1002, 5 }, { 1002, 1002, 5 } },
+      { 1001, 1001, 5 }, std::sqrt(2.) }
+  };
+  for (const auto& cs : cases)
+  {
+    auto sph = Geo::min_ball(cs.pts_.data(), cs.pts_.size());
+    REQUIRE(sph.radius_ == Approx(cs.radius_));
+    REQUIRE(Geo::length(sph.centre_ - cs.centre_) < 1e-9);
+    REQUIRE(contains_all(sph, cs.pts_));
+  }
+}
+
+TEST_CASE("min_ball_random", "[MINSPHERE]")
+{
+  // Clusters of 3 to 8 points, a quarter of them flat: all the points are
+  // in the ball and no smaller sphere through some of them contains them.
+  std::mt19937 gen(5);
+  std::uniform_real_distribution<double> dis(-1., 1.);
+  for (size_t i = 0; i < 1000; ++i)
+  {
+    const Geo::VectorD3 centre = { 100. * dis(gen), 100. * dis(gen), 0 };
+    const double flat = i % 4 == 0 ? 0 : 1;
+    std::vector<Geo::VectorD3> pts(i % 6 + 3);
+    for (auto& pt : pts)
+      pt = centre + Geo::VectorD3{ dis(gen), dis(gen), flat * dis(gen) };
+    auto sph = Geo::min_ball(pts.data(), pts.size());
+    REQUIRE(contains_all(sph, pts));
+    REQUIRE(sph.radius_ <= brute_force_radius(pts) * (1 + 1e-9));
+  }
+}
+
+TEST_CASE("min_balls", "[MINSPHERE]")
+{
+  std::mt19937 gen(2);
+  std::uniform_real_distribution<double> dis(-1., 1.);
+  std::vector<Geo::VectorD3> pts;
+  std::vector<size_t> offsets(1, 0);
+  for (size_t i = 0; i < 500; ++i)
+  {
+    const Geo::VectorD3 centre = { 10. * i, 0, 0 };
+    for (size_t j = 0; j < i % 7 + 1; ++j)
+      pts.push_back(centre + Geo::VectorD3{ dis(gen), dis(gen), dis(gen) });
+    offsets.push_back(pts.size());
+  }
+  std::vector<Geo::MinSphereT<Geo::VectorD3>> spheres(offsets.size() - 1);
+  Geo::min_balls(pts.data(), offsets.data(), spheres.size(), spheres.data());
+  for (size_t i = 0; i < spheres.size(); ++i)
+  {
+    auto sph = Geo::min_ball(
+      pts.data() + offsets[i], offsets[i + 1] - offsets[i]);
+    REQUIRE(spheres[i].radius_ == sph.radius_);
+    REQUIRE(spheres[i].centre_ == sph.centre_);
+  }
+}
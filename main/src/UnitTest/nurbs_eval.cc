@@ -3,10 +3,12 @@
 
 #include "boost/math/tools/polynomial.hpp"
 
-#include "Geo/evalnurbs.hh"
 #include "Geo/geo_function.hh"
+#include "Geo/evalnurbs.hh"
 
+#include <chrono>
 #include <iostream>
+#include <random>
 #include <vector>
 #include <array>
 
@@ -88,3 +90,101 @@ TEST_CASE("Curve00", "[NURBS]")
   crv3->evaluate({ 1 }, pt3, &ders3, true);
   REQUIRE((ders3[0].val_ == MyPt3{ 1, -2, -3 }));
 }
+
+namespace {
+
+struct RandomNub
+{
+  std::vector<Geo::VectorD<3>> pts_;
+  std::vector<double> knots_;
+  std::vector<double> pars_;
+
+  RandomNub(size_t _deg, size_t _pt_nmbr, size_t _par_nmbr, std::mt19937& _gen)
+  {
+    std::uniform_real_distribution<double> dis(0., 1.);
+    pts_.resize(_pt_nmbr);
+    for (auto& pt : pts_)
+      pt = { dis(_gen), dis(_gen), dis(_gen) };
+    // End knots repeated deg times, some double knots inside.
+    knots_.assign(_deg, 0.);
+    for (size_t i = 1; knots_.size() + _deg < _pt_nmbr + _deg - 1; ++i)
+    {
+      knots_.push_back(double(i));
+      if (i % 5 == 0 && knots_.size() + _deg < _pt_nmbr + _deg - 1)
+        knots_.push_back(double(i));
+    }
+    const auto end_kn = knots_.back() + 1;
+    knots_.insert(knots_.end(), _deg, end_kn);
+    pars_.resize(_par_nmbr);
+    for (auto& t : pars_)
+      t = dis(_gen) * end_kn;
+    pars_.front() = 0;
+    pars_.back() = end_kn;
+    std::sort(pars_.begin(), pars_.end());
+  }
+};
+
+}//namespace
+
+TEST_CASE("Batch nub", "[NURBS]")
+{
+  std::mt19937 gen(1);
+  for (size_t deg = 1; deg <= 5; ++deg)
+  {
+    RandomNub crv(deg, 30, 500, gen);
+    Geo::Nub<Geo::VectorD<3>, double> nub;
+    REQUIRE(nub.init(crv.pts_, crv.knots_));
+    Geo::NubBatch<3> batch;
+    REQUIRE(batch.init(crv.pts_, crv.knots_));
+    REQUIRE(batch.degree() == deg);
+    const size_t der_nmbr = deg + 1, n = crv.pars_.size();
+    std::vector<double> res((der_nmbr + 1) * 3 * n);
+    REQUIRE(batch.eval(crv.pars_.data(), n, res.data(), der_nmbr));
+    std::vector<Geo::VectorD<3>> expected(der_nmbr + 1);
+    for (size_t j = 0; j < n; ++j)
+    {
+      nub.eval(crv.pars_[j], expected.begin(), expected.end());
+      for (size_t k = 0; k <= der_nmbr; ++k)
+        for (size_t d = 0; d < 3; ++d)
+        {
+          REQUIRE(res[(k * 3 + d) * n + j] ==
+            Approx(expected[k][d]).margin(1e-9 * (1 + std::abs(expected[k][d]))));
+        }
+    }
+  }
+}
+
+TEST_CASE("Batch nub bench", "[.][BENCH]")
+{
+  std::mt19937 gen(1);
+  for (size_t deg : { 2, 3, 5 })
+  {
+    RandomNub crv(deg, 1000, 1 << 20, gen);
+    const auto n = crv.pars_.size();
+    Geo::Nub<Geo::VectorD<3>, double> nub;
+    nub.init(crv.pts_, crv.knots_);
+    Geo::NubBatch<3> batch;
+    batch.init(crv.pts_, crv.knots_);
+    for (size_t der_nmbr : { 0, 1 })
+    {
+      double sum[2] = { 0, 0 };
+      std::vector<Geo::VectorD<3>> vals(der_nmbr + 1);
+      std::vector<double> res((der_nmbr + 1) * 3 * n, 0.);
+      auto start = std::chrono::steady_clock::now();
+      for (auto t : crv.pars_)
+      {
+        nub.eval(t, vals.begin(), vals.end());
+        sum[0] += vals.back()[0];
+      }
+      auto t0 = std::chrono::steady_clock::now();
+      batch.eval(crv.pars_.data(), n, res.data(), der_nmbr);
+      for (size_t j = 0; j < n; ++j)
+        sum[1] += res[der_nmbr * 3 * n + j];
+      auto t1 = std::chrono::steady_clock::now();
+      std::chrono::duration<double> dt[2] = { t0 - start, t1 - t0 };
+      std::cout << "Degree " << deg << " derivatives " << der_nmbr <<
+        ": Nub::eval " << dt[0].count() << "s, NubBatch " <<
+        dt[1].count() << "s (" << sum[0] - sum[1] << ")" << std::endl;
+    }
+  }
+}
@@ -0,0 +1,78 @@
+#include "Catch/catch.hpp"
+#include <Geo/packed_vector.hh>
+#include <Geo/vector.hh>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+
+bool identical(const Geo::PackedVectorD3& _a, const Geo::VectorD3& _b)
+{
+  return _a[0] == _b[0] && _a[1] == _b[1] && _a[2] == _b[2];
+}
+
+}//namespace
+
+TEST_CASE("packed_vector", "[VECTOR]")
+{
+  std::mt19937 gen(11);
+  std::uniform_real_distribution<double> dis(-100., 100.);
+  for (size_t n = 0; n < 1000; ++n)
+  {
+    const Geo::VectorD3 a{ dis(gen), dis(gen), dis(gen) };
+    const Geo::VectorD3 b{ dis(gen), dis(gen), dis(gen) };
+    const double s = dis(gen);
+    const Geo::PackedVectorD3 pa(a), pb(b);
+    REQUIRE(identical(pa + pb, a + b));
+    REQUIRE(identical(pa - pb, a - b));
+    REQUIRE(identical(pa * s, a * s));
+    REQUIRE(identical(s * pa, s * a));
+    REQUIRE(identical(pa / s, a / s));
+    REQUIRE(identical(-pa, -a));
+    // These can differ in the last bit if the compiler fuses the scalar
+    // multiply and add.
+    REQUIRE(Geo::length(Geo::VectorD3(pa % pb) - a % b) < 1e-10);
+    REQUIRE(std::abs(pa * pb - a * b) <= 1e-14 * Geo::length(a) * Geo::length(b));
+    REQUIRE(Geo::length(pa) == Approx(Geo::length(a)).epsilon(1e-14));
+    REQUIRE(Geo::length(
+      Geo::VectorD3(Geo::interpolate(pa, pb, 0.3)) - Geo::interpolate(a, b, 0.3)) < 1e-12);
+    const auto c = a + Geo::uniform_vector<3>(1e-9);
+    REQUIRE(Geo::same(pa, Geo::PackedVectorD3(c), 1e-6) == Geo::same(a, c, 1e-6));
+    REQUIRE(Geo::same(pa, Geo::PackedVectorD3(c), 0.) == Geo::same(a, c, 0.));
+  }
+  Geo::PackedVectorD3 p = { 1, 2, 3 };
+  p += Geo::PackedVectorD3{ 1, 1, 1 };
+  p *= 2.;
+  REQUIRE(p == Geo::PackedVectorD3(4, 6, 8));
+  REQUIRE(Geo::VectorD3(p) == Geo::VectorD3{ 4, 6, 8 });
+}
+
+TEST_CASE("packed_vector_bench", "[.][BENCH]")
+{
+  std::mt19937 gen(7);
+  std::uniform_real_distribution<double> dis(-1., 1.);
+  std::vector<Geo::VectorD3> pts(1 << 20);
+  for (auto& pt : pts)
+    pt = { dis(gen), dis(gen), dis(gen) };
+  std::vector<Geo::PackedVectorD3> ppts(pts.begin(), pts.end());
+  auto run = [](const auto& _pts, const char* _name)
+  {
+    double sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 1; i < _pts.size(); ++i)
+    {
+      auto n = (_pts[i] - _pts[i - 1]) % _pts[i];
+      sum += Geo::length(n) + (n * _pts[i - 1]);
+      sum += Geo::same(_pts[i], _pts[i - 1], 1e-3);
+    }
+    std::chrono::duration<double> dur = std::chrono::steady_clock::now() - start;
+    std::cout << _name << ": " << _pts.size() << " points in "
+      << dur.count() << "s (" << sum << ")" << std::endl;
+    return sum;
+  };
+  REQUIRE(run(pts, "VectorD3") == Approx(run(ppts, "PackedVectorD3")));
+}
@@ -2,11 +2,20 @@
 
 #include "topology_help.hh"
 
+#include <Import/import.hh>
 #include <Topology/impl.hh>
 #include <Topology/iterator.hh>
+#include <Topology/journal.hh>
 #include <Topology/persistence.hh>
+#include <Utils/bindata.hh>
 
+#include <algorithm>
+#include <chrono>
 #include <fstream>
+#include <iostream>
+#include <sstream>
+
+#define MESH_FOLDER "C:/Users/marco/OneDrive/Documents/PROJECTS/polytriagnulation/mesh/"
 
 TEST_CASE("saveload1", "[PERS]")
 {
@@ -36,4 +45,254 @@ TEST_CASE("saveload1", "[PERS]")
     v1->geom(pt1);
     REQUIRE(pt0 == pt1);
   }
-}
\ No newline at end of file
+}
+
+TEST_CASE("saveload_version", "[PERS]")
+{
+  // A vertex written before the version header, position in text.
+  const Geo::Point pt{ 1.5, -2, 3 };
+  std::stringstream old;
+  old << Utils::BinData<size_t>(7) <<
+    Utils::BinData<size_t>(size_t(Topo::SubType::VERTEX)) <<
+    Utils::BinData<size_t>(0) << pt << Utils::BinData<double>(0.);
+  auto lod = Topo::ILoader::make(old);
+  auto obj = lod->load();
+  REQUIRE(lod->version() == 0);
+  REQUIRE(obj->sub_type() == Topo::SubType::VERTEX);
+  Geo::Point pt_load;
+  static_cast<Topo::E<Topo::Type::VERTEX>*>(obj.get())->geom(pt_load);
+  REQUIRE(pt_load == pt);
+
+  // Current version, positions are exact.
+  Topo::Wrap<Topo::Type::VERTEX> vert;
+  vert.make<Topo::EE<Topo::Type::VERTEX>>();
+  vert->set_geom(Geo::Point{ 1. / 3, 2. / 7, -1e-17 });
+  std::stringstream buf;
+  Topo::ISaver::make(buf)->save(vert.get());
+  lod = Topo::ILoader::make(buf);
+  obj = lod->load();
+  REQUIRE(lod->version() == Topo::PERSISTENCE_VERSION);
+  Geo::Point pt_save;
+  vert->geom(pt_save);
+  static_cast<Topo::E<Topo::Type::VERTEX>*>(obj.get())->geom(pt_load);
+  REQUIRE(pt_load == pt_save);
+
+  // Newer versions are refused.
+  auto newer = buf.str();
+  newer[8] = char(Topo::PERSISTENCE_VERSION + 1);
+  std::stringstream newer_buf(newer);
+  REQUIRE_THROWS(Topo::ILoader::make(newer_buf)->load());
+}
+
+namespace {
+
+// Sorted points of the faces, to compare bodies with faces in any order.
+std::vector<std::vector<Geo::Point>> face_points(const Topo::Wrap<Topo::Type::BODY>& _body)
+{
+  std::vector<std::vector<Geo::Point>> res;
+  Topo::Iterator<Topo::Type::BODY, Topo::Type::FACE> bf_it(_body);
+  for (const auto& face : bf_it)
+  {
+    res.emplace_back();
+    Topo::Iterator<Topo::Type::FACE, Topo::Type::VERTEX> fv_it(face);
+    for (const auto& vert : fv_it)
+    {
+      Geo::Point pt;
+      vert->geom(pt);
+      res.back().push_back(pt);
+    }
+  }
+  std::sort(res.begin(), res.end());
+  return res;
+}
+
+}//namespace
+
+TEST_CASE("journal", "[PERS]")
+{
+  auto body = UnitTest::make_cube(UnitTest::cube_00);
+  std::stringstream journal;
+  Topo::JournalWriter writer(journal);
+  writer.checkpoint(body);
+  const auto full_size = journal.str().size();
+  std::vector<std::vector<std::vector<Geo::Point>>> states = { face_points(body) };
+
+  // Moves a vertex and replaces a face with two triangles.
+  Topo::Iterator<Topo::Type::BODY, Topo::Type::FACE> bf_it(body);
+  auto face = bf_it.get(0);
+  Topo::Iterator<Topo::Type::FACE, Topo::Type::VERTEX> fv_it(face);
+  fv_it.get(0)->set_geom(Geo::Point{ -1, -1, -1 });
+  for (size_t i = 0; i < 2; ++i)
+  {
+    Topo::Wrap<Topo::Type::FACE> tri;
+    tri.make<Topo::EE<Topo::Type::FACE>>();
+    for (size_t j = 0; j < 3; ++j)
+      tri->insert_child(fv_it.get((2 * i + j) % 4).get());
+    body->insert_child(tri.get());
+  }
+  body->remove_child(face.get());
+  writer.checkpoint(body);
+  states.push_back(face_points(body));
+  REQUIRE(journal.str().size() < 2 * full_size);
+
+  // Nothing changed, only the end of the checkpoint.
+  auto size = journal.str().size();
+  writer.checkpoint(body);
+  REQUIRE(journal.str().size() == size + 8);
+  states.push_back(states.back());
+
+  Topo::JournalReader reader(journal);
+  for (const auto& state : states)
+  {
+    REQUIRE(reader.next());
+    REQUIRE(face_points(reader.body()) == state);
+  }
+  REQUIRE(!reader.next());
+  REQUIRE(!reader.truncated());
+  REQUIRE(reader.checkpoint_count() == 3);
+
+  // Goes on from the loaded body.
+  Topo::JournalWriter resumed(journal);
+  resumed.resume(reader);
+  auto loaded = reader.body();
+  Topo::Iterator<Topo::Type::BODY, Topo::Type::FACE> loaded_faces(loaded);
+  loaded->remove_child(loaded_faces.get(0).get());
+  resumed.checkpoint(loaded);
+  states.push_back(face_points(loaded));
+  REQUIRE(resumed.checkpoint_count() == 4);
+
+  std::stringstream all(journal.str());
+  Topo::JournalReader all_reader(all);
+  for (const auto& state : states)
+  {
+    REQUIRE(all_reader.next());
+    REQUIRE(face_points(all_reader.body()) == state);
+  }
+  REQUIRE(!all_reader.next());
+
+  // A journal cut inside the last checkpoint.
+  std::stringstream cut(journal.str().substr(0, journal.str().size() - 12));
+  Topo::JournalReader cut_reader(cut);
+  for (size_t i = 0; i < 3; ++i)
+    REQUIRE(cut_reader.next());
+  REQUIRE(!cut_reader.next());
+  REQUIRE(cut_reader.truncated());
+  REQUIRE(face_points(cut_reader.body()) == states[2]);
+
+  // An unknown record without elements is corrupt.
+  std::stringstream bad(journal.str().substr(0, full_size),
+    std::ios::in | std::ios::out | std::ios::ate);
+  bad << Utils::BinData<uint32_t>(99) << Utils::BinData<uint32_t>(0);
+  bad << Utils::BinData<uint32_t>(4) << Utils::BinData<uint32_t>(0);
+  Topo::JournalReader bad_reader(bad);
+  REQUIRE(bad_reader.next());
+  REQUIRE(!bad_reader.next());
+  REQUIRE(bad_reader.truncated());
+  REQUIRE(bad_reader.checkpoint_count() == 1);
+
+  // A journal cut inside its first checkpoint keeps its header when it
+  // is resumed.
+  std::stringstream first(journal.str().substr(0, full_size - 12));
+  Topo::JournalReader first_reader(first);
+  REQUIRE(!first_reader.next());
+  REQUIRE(first_reader.truncated());
+  std::stringstream restarted(journal.str().substr(0, size_t(first_reader.position())));
+  Topo::JournalWriter restarted_writer(restarted);
+  restarted_writer.resume(first_reader);
+  restarted.seekp(0, std::ios::end);
+  restarted_writer.checkpoint(loaded);
+  Topo::JournalReader restarted_reader(restarted);
+  REQUIRE(restarted_reader.next());
+  REQUIRE(face_points(restarted_reader.body()) == states.back());
+  REQUIRE(!restarted_reader.next());
+  REQUIRE(!restarted_reader.truncated());
+}
+
+TEST_CASE("journal_resume_truncated", "[PERS]")
+{
+  const char* flnm = "tmp_journal.bin";
+  auto body = UnitTest::make_cube(UnitTest::cube_00);
+  std::vector<std::vector<std::vector<Geo::Point>>> states;
+  std::string data;
+  size_t first_size;
+  {
+    std::stringstream journal;
+    Topo::JournalWriter writer(journal);
+    writer.checkpoint(body);
+    first_size = journal.str().size();
+    states.push_back(face_points(body));
+    // Moves two vertices and adds a triangle.
+    Topo::Iterator<Topo::Type::BODY, Topo::Type::FACE> bf_it(body);
+    Topo::Iterator<Topo::Type::FACE, Topo::Type::VERTEX> fv_it(bf_it.get(0));
+    fv_it.get(0)->set_geom(Geo::Point{ -1, -1, -1 });
+    fv_it.get(1)->set_geom(Geo::Point{ 2, -1, -1 });
+    Topo::Wrap<Topo::Type::FACE> tri;
+    tri.make<Topo::EE<Topo::Type::FACE>>();
+    for (size_t j = 0; j < 3; ++j)
+      tri->insert_child(fv_it.get(j).get());
+    body->insert_child(tri.get());
+    writer.checkpoint(body);
+    data = journal.str();
+  }
+  // Cut after the first moved vertex of the second checkpoint: record
+  // kind and size, key, point and tolerance.
+  {
+    std::ofstream out(flnm, std::ios::binary | std::ios::trunc);
+    out.write(data.data(), first_size + 2 * sizeof(uint32_t) +
+      sizeof(uint64_t) + sizeof(Geo::Point) + sizeof(double));
+  }
+  std::ifstream in(flnm, std::ios::binary);
+  Topo::JournalReader reader(in);
+  REQUIRE(reader.next());
+  REQUIRE(!reader.next());
+  REQUIRE(reader.truncated());
+  REQUIRE(reader.position() == std::streamoff(first_size));
+  REQUIRE(face_points(reader.body()) == states[0]);
+  in.close();
+
+  REQUIRE(Topo::JournalWriter::truncate(flnm, reader));
+  auto loaded = reader.body();
+  {
+    std::ofstream out(flnm, std::ios::binary | std::ios::app);
+    Topo::JournalWriter resumed(out);
+    resumed.resume(reader);
+    Topo::Iterator<Topo::Type::BODY, Topo::Type::FACE> bf_it(loaded);
+    Topo::Iterator<Topo::Type::FACE, Topo::Type::VERTEX> fv_it(bf_it.get(0));
+    Topo::Wrap<Topo::Type::FACE> tri;
+    tri.make<Topo::EE<Topo::Type::FACE>>();
+    for (size_t j = 0; j < 3; ++j)
+      tri->insert_child(fv_it.get(j).get());
+    loaded->insert_child(tri.get());
+    resumed.checkpoint(loaded);
+    REQUIRE(resumed.checkpoint_count() == 2);
+  }
+  states.push_back(face_points(loaded));
+
+  std::ifstream all(flnm, std::ios::binary);
+  Topo::JournalReader all_reader(all);
+  for (const auto& state : states)
+  {
+    REQUIRE(all_reader.next());
+    REQUIRE(face_points(all_reader.body()) == state);
+  }
+  REQUIRE(!all_reader.next());
+  REQUIRE(!all_reader.truncated());
+}
+
+TEST_CASE("saveload_bench", "[.][BENCH]")
+{
+  for (auto flnm : { "elepham.obj", "bambolina_a_02.obj" })
+  {
+    auto body = IO::load_obj((std::string(MESH_FOLDER) + flnm).c_str());
+    std::stringstream buf;
+    auto start = std::chrono::steady_clock::now();
+    Topo::ISaver::make(buf)->save(body.get());
+    std::chrono::duration<double> save_dur = std::chrono::steady_clock::now() - start;
+    start = std::chrono::steady_clock::now();
+    auto obj = Topo::ILoader::make(buf)->load();
+    std::chrono::duration<double> load_dur = std::chrono::steady_clock::now() - start;
+    REQUIRE(obj->sub_type() == Topo::SubType::BODY);
+    std::cout << flnm << " save: " << save_dur.count() << "s, load: "
+      << load_dur.count() << "s" << std::endl;
+  }
+}
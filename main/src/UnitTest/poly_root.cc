@@ -1,8 +1,14 @@
 #include "catch/catch.hpp"
 
 #include "Geo/polynomial_solver.hh"
+#include "alloc_count.hh"
 
+#include <chrono>
+#include <cmath>
 #include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
 
 
 TEST_CASE("Basic_pol_solver", "[POLYNOMIAL_SOLVER]")
@@ -25,10 +31,223 @@ TEST_CASE("Basic_pol_solver1", "[POLYNOMIAL_SOLVER]")
   std::reverse(poly2.begin(), poly2.end());
   for (auto x : roots)
   {
-    auto s = 0.;
+    // The residual is within the rounding error of the Horner evaluation.
+    auto s = 0., s_abs = 0.;
     for (auto c : poly2)
+    {
       s = s * x + c;
-    REQUIRE(s == Approx(0));
+      s_abs = s_abs * std::abs(x) + std::abs(c);
+    }
+    REQUIRE(std::abs(s) <= 4 * std::numeric_limits<double>::epsilon() * s_abs);
   }
 }
 
+namespace {
+
+// Coefficients of prod(x - _roots[i]) * _scale.
+template <size_t DegT>
+std::array<double, DegT + 1> poly_from_roots(
+  const std::array<double, DegT>& _roots, double _scale)
+{
+  std::array<double, DegT + 1> poly{};
+  poly[0] = _scale;
+  for (size_t i = 0; i < DegT; ++i)
+  {
+    for (size_t j = i + 1; j > 0; --j)
+      poly[j] = poly[j - 1] - _roots[i] * poly[j];
+    poly[0] *= -_roots[i];
+  }
+  return poly;
+}
+
+template <size_t DegT>
+void check_random_roots(std::mt19937& _gen)
+{
+  std::uniform_real_distribution<double> dis(-10., 10.);
+  for (int test = 0; test < 100; ++test)
+  {
+    std::array<double, DegT> roots;
+    for (auto& r : roots)
+      r = dis(_gen);
+    std::sort(roots.begin(), roots.end());
+    if (std::adjacent_find(roots.begin(), roots.end(),
+      [](double _a, double _b) { return _b - _a < 1e-2; }) != roots.end())
+      continue;
+    auto poly = poly_from_roots<DegT>(roots, dis(_gen));
+    auto res = Geo::polynomial_roots<DegT>(poly);
+    REQUIRE(res.size() == DegT);
+    for (size_t i = 0; i < DegT; ++i)
+      REQUIRE(res[i] == Approx(roots[i]).margin(1e-8));
+  }
+}
+
+template <size_t DegT>
+void check_batch(std::mt19937& _gen, size_t _n)
+{
+  std::uniform_real_distribution<double> dis(-1., 1.);
+  std::vector<double> coeffs((DegT + 1) * _n);
+  for (auto& c : coeffs)
+    c = dis(_gen);
+  for (size_t k = 0; k < _n; k += 7)
+    coeffs[DegT * _n + k] = 0;
+  std::vector<double> roots(DegT * _n);
+  std::vector<size_t> counts(_n);
+  Geo::polynomial_roots_batch<DegT>(_n, coeffs.data(), roots.data(), counts.data());
+  for (size_t k = 0; k < _n; ++k)
+  {
+    std::array<double, DegT + 1> poly;
+    for (size_t i = 0; i <= DegT; ++i)
+      poly[i] = coeffs[i * _n + k];
+    auto res = Geo::polynomial_roots<DegT>(poly);
+    REQUIRE(res.size() == counts[k]);
+    for (size_t j = 0; j < res.size(); ++j)
+      REQUIRE(res[j] == Approx(roots[j * _n + k]).margin(1e-12));
+  }
+}
+
+template <size_t DegT>
+void bench_roots(std::mt19937& _gen, size_t _n)
+{
+  std::uniform_real_distribution<double> dis(-1., 1.);
+  std::vector<double> coeffs((DegT + 1) * _n);
+  for (auto& c : coeffs)
+    c = dis(_gen);
+  std::vector<double> roots(DegT * _n);
+  std::vector<size_t> counts(_n);
+  std::array<double, DegT + 1> poly;
+  size_t root_nmbr[3] = {};
+
+  auto start = std::chrono::steady_clock::now();
+  for (size_t k = 0; k < _n; ++k)
+  {
+    for (size_t i = 0; i <= DegT; ++i)
+      poly[i] = coeffs[i * _n + k];
+    root_nmbr[0] += Geo::polygon_roots<DegT>(poly).size();
+  }
+  auto t0 = std::chrono::steady_clock::now();
+  for (size_t k = 0; k < _n; ++k)
+  {
+    for (size_t i = 0; i <= DegT; ++i)
+      poly[i] = coeffs[i * _n + k];
+    root_nmbr[1] += Geo::polynomial_roots<DegT>(poly).size();
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  Geo::polynomial_roots_batch<DegT>(_n, coeffs.data(), roots.data(), counts.data());
+  for (auto c : counts)
+    root_nmbr[2] += c;
+  auto t2 = std::chrono::steady_clock::now();
+  auto mps = [_n](std::chrono::duration<double> _dt) { return _n / _dt.count() * 1e-6; };
+  std::cout << "Degree " << DegT << " (Mpoly/s): multiset " << mps(t0 - start) <<
+    ", inline " << mps(t1 - t0) << ", batch " << mps(t2 - t1) <<
+    " roots " << root_nmbr[0] << " " << root_nmbr[1] << " " << root_nmbr[2] << std::endl;
+}
+
+}//namespace
+
+TEST_CASE("pol_solver_degrees", "[POLYNOMIAL_SOLVER]")
+{
+  std::mt19937 gen(3);
+  check_random_roots<1>(gen);
+  check_random_roots<2>(gen);
+  check_random_roots<3>(gen);
+  check_random_roots<4>(gen);
+  check_random_roots<5>(gen);
+  check_random_roots<6>(gen);
+
+  // Double root on a critical point and lower degree polynomial.
+  auto roots = Geo::polynomial_roots<3>(std::array<double, 4>{ 2, -3, 0, 1 });
+  REQUIRE(roots.size() == 2);
+  REQUIRE(roots[0] == Approx(-2));
+  REQUIRE(roots[1] == Approx(1));
+  roots = Geo::polynomial_roots<3>(std::array<double, 4>{ 1, 0, -1, 0 });
+  REQUIRE(roots.size() == 2);
+  REQUIRE(roots[0] == Approx(-1));
+  REQUIRE(roots[1] == Approx(1));
+  REQUIRE(Geo::polynomial_roots<4>(std::array<double, 5>{ 1, 0, 1, 0, 1 }).empty());
+}
+
+TEST_CASE("pol_solver_multiple_roots", "[POLYNOMIAL_SOLVER]")
+{
+  // x^n has only the root 0.
+  auto check_zero = [](const auto& _roots)
+  {
+    REQUIRE(_roots.size() == 1);
+    REQUIRE(_roots[0] == 0);
+    REQUIRE(!std::signbit(_roots[0]));
+  };
+  check_zero(Geo::polynomial_roots<2>(std::array<double, 3>{ 0, 0, 1 }));
+  check_zero(Geo::polynomial_roots<3>(std::array<double, 4>{ 0, 0, 0, 1 }));
+  check_zero(Geo::polynomial_roots<4>(std::array<double, 5>{ 0, 0, 0, 0, 2 }));
+  check_zero(Geo::polynomial_roots<5>(std::array<double, 6>{ 0, 0, 0, 0, 0, -1 }));
+  check_zero(Geo::polynomial_roots<6>(std::array<double, 7>{ 0, 0, 0, 0, 0, 0, 1 }));
+  // x^3 (x - 1)
+  auto roots = Geo::polynomial_roots<4>(std::array<double, 5>{ 0, 0, 0, -1, 1 });
+  REQUIRE(roots.size() == 2);
+  REQUIRE(roots[0] == 0);
+  REQUIRE(roots[1] == Approx(1));
+
+  // Multiple roots away from 0, found with about half of the digits.
+  auto roots2 = Geo::polynomial_roots<2>(poly_from_roots<2>({ 0.1, 0.1 }, 1));
+  REQUIRE(roots2.size() == 1);
+  REQUIRE(roots2[0] == Approx(0.1).margin(1e-7));
+  auto roots3 = Geo::polynomial_roots<3>(poly_from_roots<3>({ -3, 0.1, 0.1 }, 1));
+  REQUIRE(roots3.size() == 2);
+  REQUIRE(roots3[0] == Approx(-3));
+  REQUIRE(roots3[1] == Approx(0.1).margin(1e-7));
+  roots = Geo::polynomial_roots<4>(poly_from_roots<4>({ -2, 1, 1, 1 }, -3));
+  REQUIRE(roots.size() == 2);
+  REQUIRE(roots[0] == Approx(-2));
+  REQUIRE(roots[1] == Approx(1).margin(1e-5));
+  auto roots6 = Geo::polynomial_roots<6>(poly_from_roots<6>({ -1, -1, 0.5, 0.5, 2, 3 }, 2));
+  REQUIRE(roots6.size() == 4);
+  REQUIRE(roots6[0] == Approx(-1).margin(1e-7));
+  REQUIRE(roots6[1] == Approx(0.5).margin(1e-7));
+  REQUIRE(roots6[2] == Approx(2));
+  REQUIRE(roots6[3] == Approx(3));
+
+  // The batch gives the same roots.
+  auto poly = poly_from_roots<3>({ -3, 0.1, 0.1 }, 1);
+  std::vector<double> coeffs(4 * 3), batch_roots(3 * 3);
+  std::vector<size_t> counts(3);
+  for (size_t i = 0; i < 4; ++i)
+    for (size_t k = 0; k < 3; ++k)
+      coeffs[i * 3 + k] = k == 1 ? (i == 3 ? 1 : 0) : poly[i];
+  Geo::polynomial_roots_batch<3>(3, coeffs.data(), batch_roots.data(), counts.data());
+  REQUIRE(counts == std::vector<size_t>{ 2, 1, 2 });
+  REQUIRE(batch_roots[1] == 0);
+  for (size_t k = 0; k < 3; k += 2)
+  {
+    REQUIRE(batch_roots[k] == Approx(-3));
+    REQUIRE(batch_roots[3 + k] == Approx(0.1).margin(1e-7));
+  }
+}
+
+TEST_CASE("pol_solver_batch", "[POLYNOMIAL_SOLVER]")
+{
+  std::mt19937 gen(5);
+  check_batch<2>(gen, 101);
+  check_batch<3>(gen, 101);
+  check_batch<4>(gen, 5);
+  check_batch<5>(gen, 101);
+  check_batch<6>(gen, 101);
+
+  std::array<double, 7> poly{ 1, -2, 3, -4, 5, -6, 7 };
+  std::vector<double> coeffs(7 * 16, 1.), roots(6 * 16);
+  std::vector<size_t> counts(16);
+  const auto alloc_start = UnitTest::allocation_count();
+  auto res = Geo::polynomial_roots<6>(poly);
+  Geo::polynomial_roots_batch<6>(16, coeffs.data(), roots.data(), counts.data());
+  REQUIRE(UnitTest::allocation_count() == alloc_start);
+  REQUIRE(res.size() <= 6);
+}
+
+TEST_CASE("pol_solver_bench", "[.][BENCH]")
+{
+  std::mt19937 gen(11);
+  const size_t n = 1 << 18;
+  bench_roots<2>(gen, n);
+  bench_roots<3>(gen, n);
+  bench_roots<4>(gen, n);
+  bench_roots<5>(gen, n);
+  bench_roots<6>(gen, n);
+}
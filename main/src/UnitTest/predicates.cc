@@ -0,0 +1,118 @@
+#include "Catch/catch.hpp"
+#include <Geo/predicates.hh>
+
+#include <cmath>
+#include <random>
+
+using namespace Geo::Predicates;
+
+TEST_CASE("orient2d", "[PREDICATES]")
+{
+  REQUIRE(orient2d({ 0, 0 }, { 1, 0 }, { 0, 1 }) == 1);
+  REQUIRE(orient2d({ 0, 0 }, { 0, 1 }, { 1, 0 }) == -1);
+  REQUIRE(orient2d({ 0.5, 0.5 }, { 12, 12 }, { 24, 24 }) == 0);
+  // One ulp away from collinear, below the rounding of the naive formula.
+  REQUIRE(orient2d({ 0.5, 0.5 }, { 12, 12 }, { 24, std::nextafter(24., 25.) }) == 1);
+  REQUIRE(orient2d({ 0.5, 0.5 }, { 12, 12 }, { 24, std::nextafter(24., 23.) }) == -1);
+  // Points on the line y = x computed with rounding: the exact answer has
+  // to be consistent when the points are permuted.
+  std::mt19937 gen(3);
+  std::uniform_real_distribution<double> dis(0., 1.);
+  for (size_t i = 0; i < 10000; ++i)
+  {
+    const double t = dis(gen);
+    const Geo::VectorD2 a{ 0.1, 0.3 }, b{ 10.7, 3.1 };
+    const Geo::VectorD2 c = a + t * (b - a);
+    const int o = orient2d(a, b, c);
+    REQUIRE(orient2d(b, c, a) == o);
+    REQUIRE(orient2d(c, a, b) == o);
+    REQUIRE(orient2d(b, a, c) == -o);
+  }
+}
+
+TEST_CASE("orient3d", "[PREDICATES]")
+{
+  const Geo::VectorD3 a{ 0, 0, 0 }, b{ 1, 0, 0 }, c{ 0, 1, 0 };
+  REQUIRE(orient3d(a, b, c, { 0.3, 0.3, 1 }) == 1);
+  REQUIRE(orient3d(a, b, c, { 0.3, 0.3, -1 }) == -1);
+  REQUIRE(orient3d(a, b, c, { 5, -7, 0 }) == 0);
+  REQUIRE(orient3d(a, b, c, { 5, -7, 1e-300 }) == 1);
+  // Nearly coplanar points: the sign must not depend on the point order.
+  std::mt19937 gen(5);
+  std::uniform_real_distribution<double> dis(0., 1.);
+  const Geo::VectorD3 p{ 0.1, 0.2, 0.3 }, q{ 1.3, -0.7, 2.9 }, r{ -3.1, 0.7, 1.1 };
+  for (size_t i = 0; i < 10000; ++i)
+  {
+    const double u = dis(gen), v = dis(gen);
+    const Geo::VectorD3 s = p + u * (q - p) + v * (r - p);
+    const int o = orient3d(p, q, r, s);
+    REQUIRE(orient3d(q, r, p, s) == o);
+    REQUIRE(orient3d(q, p, r, s) == -o);
+    REQUIRE(orient3d(s, p, q, r) == -o);
+  }
+}
+
+TEST_CASE("segment_intersection", "[PREDICATES]")
+{
+  using Seg2 = std::array<Geo::VectorD2, 2>;
+  REQUIRE(intersect(Seg2{ { { 0, 0 }, { 2, 2 } } }, Seg2{ { { 0, 2 }, { 2, 0 } } }) ==
+    Intersection::CROSS);
+  REQUIRE(intersect(Seg2{ { { 0, 0 }, { 2, 2 } } }, Seg2{ { { 1, 1 }, { 2, 0 } } }) ==
+    Intersection::TOUCH);
+  REQUIRE(intersect(Seg2{ { { 0, 0 }, { 2, 2 } } }, Seg2{ { { 1, 1 }, { 3, 3 } } }) ==
+    Intersection::TOUCH);
+  REQUIRE(intersect(Seg2{ { { 0, 0 }, { 1, 1 } } }, Seg2{ { { 2, 2 }, { 3, 3 } } }) ==
+    Intersection::NONE);
+  REQUIRE(intersect(Seg2{ { { 0, 0 }, { 1, 0 } } }, Seg2{ { { 0, 1 }, { 1, 1 } } }) ==
+    Intersection::NONE);
+
+  const Geo::Segment sa = { { { 0, 0, 0 }, { 2, 2, 2 } } };
+  REQUIRE(intersect(sa, Geo::Segment{ { { 0, 2, 2 }, { 2, 0, 0 } } }) == Intersection::CROSS);
+  REQUIRE(intersect(sa, Geo::Segment{ { { 0, 2, 2 }, { 2, 0, 1 } } }) == Intersection::NONE);
+  REQUIRE(intersect(sa, Geo::Segment{ { { 2, 2, 2 }, { 3, 3, 3 } } }) == Intersection::TOUCH);
+  REQUIRE(intersect(sa, Geo::Segment{ { { 3, 3, 3 }, { 4, 4, 4 } } }) == Intersection::NONE);
+  REQUIRE(intersect(sa, Geo::Segment{ { { 1, 1, 1 }, { 1, 1, 1 } } }) == Intersection::TOUCH);
+}
+
+TEST_CASE("triangle_segment_intersection", "[PREDICATES]")
+{
+  const Geo::Triangle tri = { { { 0, 0, 0 }, { 1, 0, 0 }, { 0, 1, 0 } } };
+  auto check = [&tri](const Geo::Segment& _seg)
+  {
+    return intersect(tri, _seg);
+  };
+  REQUIRE(check({ { { 0.25, 0.25, -1 }, { 0.25, 0.25, 1 } } }) == Intersection::CROSS);
+  REQUIRE(check({ { { 1, 1, -1 }, { 1, 1, 1 } } }) == Intersection::NONE);
+  REQUIRE(check({ { { 0.25, 0.25, 1 }, { 0.25, 0.25, 2 } } }) == Intersection::NONE);
+  // Through an edge, a vertex and ending on the triangle.
+  REQUIRE(check({ { { 0.5, 0, -1 }, { 0.5, 0, 1 } } }) == Intersection::TOUCH);
+  REQUIRE(check({ { { 0, 0, -1 }, { 0, 0, 1 } } }) == Intersection::TOUCH);
+  REQUIRE(check({ { { 0.25, 0.25, 0 }, { 0.25, 0.25, 1 } } }) == Intersection::TOUCH);
+  // Coplanar.
+  REQUIRE(check({ { { 0.1, 0.1, 0 }, { 0.2, 0.2, 0 } } }) == Intersection::TOUCH);
+  REQUIRE(check({ { { -1, 0.5, 0 }, { 2, 0.5, 0 } } }) == Intersection::TOUCH);
+  REQUIRE(check({ { { 1, 1, 0 }, { 2, 2, 0 } } }) == Intersection::NONE);
+  // Degenerate triangle.
+  const Geo::Triangle flat = { { { 0, 0, 0 }, { 1, 1, 1 }, { 2, 2, 2 } } };
+  REQUIRE(intersect(flat, Geo::Segment{ { { 0, 2, 2 }, { 2, 0, 0 } } }) ==
+    Intersection::TOUCH);
+  REQUIRE(intersect(flat, Geo::Segment{ { { 0, 2, 2 }, { 2, 0, 1 } } }) ==
+    Intersection::NONE);
+  // Segment nearly on the plane of a rotated triangle: the predicate must
+  // agree with itself when the triangle vertices are permuted.
+  std::mt19937 gen(9);
+  std::uniform_real_distribution<double> dis(0., 1.);
+  const Geo::Triangle rot = { { { 0.1, 0.2, 0.3 }, { 1.3, -0.7, 2.9 }, { -3.1, 0.7, 1.1 } } };
+  for (size_t i = 0; i < 1000; ++i)
+  {
+    Geo::Segment seg;
+    for (auto& pt : seg)
+    {
+      const double u = 2 * dis(gen) - 0.5, v = 2 * dis(gen) - 0.5;
+      pt = rot[0] + u * (rot[1] - rot[0]) + v * (rot[2] - rot[0]);
+    }
+    const auto res = intersect(rot, seg);
+    REQUIRE(intersect({ { rot[1], rot[2], rot[0] } }, seg) == res);
+    REQUIRE(intersect({ { rot[2], rot[1], rot[0] } }, seg) == res);
+  }
+}
@@ -0,0 +1,169 @@
+#include "Catch/catch.hpp"
+
+#include "alloc_count.hh"
+#include "topology_help.hh"
+
+#include <Import/import.hh>
+#include <Topology/iterator.hh>
+#include <Topology/pool.hh>
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace UnitTest;
+
+#define MESH_FOLDER "C:/Users/marco/OneDrive/Documents/PROJECTS/polytriagnulation/mesh/"
+
+TEST_CASE("pool_reuse", "[Topo]")
+{
+  void* ptr = Topo::Pool::allocate(72);
+  Topo::Pool::deallocate(ptr, 72);
+  // Same size class, same thread: the block is recycled.
+  REQUIRE(Topo::Pool::allocate(80) == ptr);
+  Topo::Pool::deallocate(ptr, 80);
+
+  // Blocks freed by another thread are usable.
+  void* ptrs[100];
+  for (auto& p : ptrs)
+    p = Topo::Pool::allocate(40);
+  std::thread([&ptrs]()
+  {
+    for (auto p : ptrs)
+      Topo::Pool::deallocate(p, 40);
+  }).join();
+  for (auto& p : ptrs)
+    p = Topo::Pool::allocate(40);
+  for (auto p : ptrs)
+    Topo::Pool::deallocate(p, 40);
+
+  // A thread that only frees blocks gives them back when it ends, so
+  // their slabs can be trimmed.
+  std::vector<void*> big_ptrs(200);
+  for (auto& p : big_ptrs)
+    p = Topo::Pool::allocate(480);
+  std::thread([&big_ptrs]()
+  {
+    for (auto p : big_ptrs)
+      Topo::Pool::deallocate(p, 480);
+  }).join();
+  REQUIRE(Topo::Pool::trim() >= 1);
+
+#ifdef TOPO_POOL
+  // No heap allocation once the slabs are there.
+  auto body = make_cube(cube_00);
+  body.reset(nullptr);
+  const auto alloc_start = allocation_count();
+  for (size_t i = 0; i < 10; ++i)
+  {
+    Topo::Wrap<Topo::Type::VERTEX> vert;
+    vert.make<Topo::EE<Topo::Type::VERTEX>>();
+  }
+  REQUIRE(allocation_count() == alloc_start);
+#endif
+}
+
+TEST_CASE("pool_trim", "[Topo]")
+{
+  // The blocks freed by a thread beyond its list limit and its lists
+  // at the end go back to the shared lists, then trim frees the slabs.
+  std::thread([]()
+  {
+    std::vector<void*> ptrs(2000);
+    for (auto& p : ptrs)
+      p = Topo::Pool::allocate(Topo::Pool::MAX_BLOCK);
+    for (auto p : ptrs)
+      Topo::Pool::deallocate(p, Topo::Pool::MAX_BLOCK);
+  }).join();
+  REQUIRE(Topo::Pool::trim() >= 10);
+  REQUIRE(Topo::Pool::trim() == 0);
+  void* ptr = Topo::Pool::allocate(Topo::Pool::MAX_BLOCK);
+  Topo::Pool::deallocate(ptr, Topo::Pool::MAX_BLOCK);
+}
+
+TEST_CASE("arena", "[Topo]")
+{
+  {
+    // Deleted blocks are reused by the arena.
+    Topo::Arena arena;
+    Topo::Arena::Scope scope(arena);
+    for (size_t i = 0; i < 10000; ++i)
+    {
+      auto ptr = Topo::Pool::allocate(100);
+      Topo::Pool::deallocate(ptr, 100);
+    }
+    REQUIRE(arena.slab_count() == 1);
+  }
+#ifdef TOPO_POOL
+  Topo::Wrap<Topo::Type::BODY> body;
+  {
+    Topo::Arena arena;
+    {
+      Topo::Arena::Scope scope(arena);
+      body = make_cube(cube_00);
+    }
+    REQUIRE(arena.slab_count() == 1);
+    // Objects created outside the scope do not use the arena.
+    auto other = make_cube(cube_00);
+    REQUIRE(arena.slab_count() == 1);
+  }
+  // The arena is gone, but its slabs live until the body is released.
+  Topo::Iterator<Topo::Type::BODY, Topo::Type::VERTEX> bv(body);
+  REQUIRE(bv.size() == 8);
+  body.reset(nullptr);
+#endif
+}
+
+TEST_CASE("wrap_move", "[Topo]")
+{
+  Topo::Wrap<Topo::Type::VERTEX> vert;
+  auto ptr = vert.make<Topo::EE<Topo::Type::VERTEX>>();
+  ptr->set_geom(Geo::Point{ 1, 2, 3 });
+  auto moved(std::move(vert));
+  REQUIRE(!vert);
+  REQUIRE(moved.get() == ptr);
+  std::vector<Topo::Wrap<Topo::Type::VERTEX>> verts;
+  verts.push_back(std::move(moved));
+  REQUIRE(!moved);
+
+  // Copies in several threads of the same object.
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < 4; ++i)
+  {
+    threads.emplace_back([&verts]()
+    {
+      for (size_t j = 0; j < 100000; ++j)
+      {
+        auto copy = verts[0];
+        std::vector<Topo::Wrap<Topo::Type::VERTEX>> copies(4, copy);
+      }
+    });
+  }
+  for (auto& thr : threads)
+    thr.join();
+  Geo::Point pt;
+  REQUIRE(verts[0]->geom(pt));
+  REQUIRE(pt == Geo::Point{ 1, 2, 3 });
+}
+
+TEST_CASE("load_bench", "[.][BENCH]")
+{
+  for (int use_arena = 0; use_arena < 2; ++use_arena)
+  {
+    Topo::Arena arena;
+    auto start = std::chrono::steady_clock::now();
+    size_t face_nmbr = 0;
+    {
+      std::unique_ptr<Topo::Arena::Scope> scope;
+      if (use_arena)
+        scope.reset(new Topo::Arena::Scope(arena));
+      auto body = IO::load_obj(MESH_FOLDER"elepham.obj");
+      Topo::Iterator<Topo::Type::BODY, Topo::Type::FACE> bf_it(body);
+      face_nmbr = bf_it.size();
+    }
+    std::chrono::duration<double> dur = std::chrono::steady_clock::now() - start;
+    std::cout << "elepham load and release" << (use_arena ? " in arena: " : ": ")
+      << face_nmbr << " faces in " << dur.count() << "s" << std::endl;
+  }
+}
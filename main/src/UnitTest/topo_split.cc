@@ -432,4 +432,49 @@ TEST_CASE("bambolina_split_00", "[SPLITCHAIN]")
   }
   spl_ch->compute();
   spl_ch->boundaries();
-}
\ No newline at end of file
+}
+
+TEST_CASE("check_new_connection", "[SPLITCHAIN]")
+{
+  // A circle in the plane y = 0 with vertical chords between the vertices
+  // i and N - i, for i multiple of 4. The checked chords are not parallel
+  // to other segments.
+  const size_t N = 64;
+  Topo::VertexChain vs;
+  for (size_t i = 0; i < N; ++i)
+  {
+    const double ang = 2 * M_PI * i / N;
+    vs.emplace_back();
+    vs.back().make<Topo::EE<Topo::Type::VERTEX>>();
+    vs.back()->set_geom(Geo::Point{ std::cos(ang), 0, std::sin(ang) });
+  }
+  auto spl_ch = Topo::ISplitChain::make();
+  spl_ch->add_chain(vs);
+  for (size_t i = 4; i < N / 2; i += 4)
+    spl_ch->add_connection(vs[i], vs[N - i]);
+  using Check = Topo::ISplitChain::ConnectionCheck;
+  REQUIRE(spl_ch->check_new_connection(vs[0], vs[N / 2]) == Check::INVALID);
+  REQUIRE(spl_ch->check_new_connection(vs[2], vs[6]) == Check::INVALID);
+  REQUIRE(spl_ch->check_new_connection(vs[1], vs[N - 3]) == Check::OK);
+  REQUIRE(spl_ch->check_new_connection(vs[5], vs[7]) == Check::OK);
+  REQUIRE(spl_ch->check_new_connection(vs[4], vs[6]) == Check::OK);
+  // Connections added after a check are seen by the next ones.
+  spl_ch->add_connection(vs[6], vs[N - 6]);
+  REQUIRE(spl_ch->check_new_connection(vs[5], vs[7]) == Check::INVALID);
+  REQUIRE(spl_ch->check_new_connection(vs[4], vs[6]) == Check::OK);
+  REQUIRE(spl_ch->check_new_connection(vs[9], vs[N - 11]) == Check::OK);
+
+  // Connections outside the box of the circle.
+  Topo::Wrap<Topo::Type::VERTEX> out[4];
+  const Geo::Point out_pts[4] = {
+    { 3, 0, -0.5 }, { 3, 0, 0.5 }, { 2.5, 0, 0 }, { 3.5, 0, 0 } };
+  for (size_t i = 0; i < 4; ++i)
+  {
+    out[i].make<Topo::EE<Topo::Type::VERTEX>>();
+    out[i]->set_geom(out_pts[i]);
+  }
+  spl_ch->add_connection(out[0], out[1]);
+  REQUIRE(spl_ch->check_new_connection(out[2], out[3]) == Check::INVALID);
+  REQUIRE(spl_ch->check_new_connection(vs[0], out[2]) == Check::OK);
+  REQUIRE(spl_ch->check_new_connection(vs[5], vs[7]) == Check::INVALID);
+}
@@ -1,12 +1,19 @@
 #include "Catch/catch.hpp"
 
+#include "alloc_count.hh"
 #include "topology_help.hh"
 
 #include <Topology/iterator.hh>
+#include <Topology/merge.hh>
+#include <Topology/split.hh>
+#include <Topology/view.hh>
 #include <Boolean/boolean.hh>
 #include <Geo/vector.hh>
 #include <Import/import.hh>
 
+#include <chrono>
+#include <iostream>
+
 using namespace UnitTest;
 
 #define MESH_FOLDER "C:/Users/marco/OneDrive/Documents/PROJECTS/polytriagnulation/mesh/"
@@ -44,6 +51,30 @@ TEST_CASE("make body", "[Topo]")
   REQUIRE(bv.size() == 8);
 }
 
+TEST_CASE("face cache", "[Topo]")
+{
+  Topo::Wrap<Topo::Type::BODY> body = make_cube(cube_00);
+  Topo::Iterator<Topo::Type::BODY, Topo::Type::FACE> bf(body);
+  auto face = static_cast<Topo::EE<Topo::Type::FACE>*>(bf.get(0).get());
+
+  auto norm = face->normal();
+  REQUIRE(Geo::length(norm) == Approx(1));
+  auto box = face->box();
+  auto centr = face->internal_point();
+
+  Topo::Iterator<Topo::Type::FACE, Topo::Type::VERTEX> fv(bf.get(0));
+  Geo::Point pt;
+  fv.get(0)->geom(pt);
+  fv.get(0)->set_geom(pt + norm);
+  REQUIRE(Geo::length(face->internal_point() - centr - norm / 4.) < 1e-12);
+  REQUIRE(face->box() != box);
+
+  fv.get(0)->set_geom(pt);
+  REQUIRE(face->internal_point() == centr);
+  face->reverse();
+  REQUIRE(Geo::length(face->normal() + norm) < 1e-12);
+}
+
 namespace
 {
 static Topo::Wrap<Topo::Type::BODY> body_1;
@@ -957,7 +988,9 @@ TEST_CASE("bambolina_15", "[Bool]")
   auto result = bool_solver->compute(Boolean::Operation::UNION);
   IO::save_obj("result_bambolina_15.obj", result);
   Topo::Iterator<Topo::Type::BODY, Topo::Type::VERTEX> bv_it(result);
-  REQUIRE(bv_it.size() == 6892);
+  // The chains of short edges are merged at their centroid (see the
+  // merge_chain_centroid test), merging them edge by edge left 6892.
+  REQUIRE(bv_it.size() == 6893);
   Topo::Iterator<Topo::Type::BODY, Topo::Type::FACE> bf_it(result);
   REQUIRE(bf_it.size() == 7374);
 }
@@ -1059,3 +1092,367 @@ TEST_CASE("open_attach", "[Bool]")
   Topo::Iterator<Topo::Type::BODY, Topo::Type::FACE> bf_it(b0);
   REQUIRE(bf_it.size() == 456);
 }
+
+// Children and parent searches agree with a linear scan when the
+// entities are big enough to be indexed.
+TEST_CASE("child_parent_index", "[Topo]")
+{
+  std::vector<Topo::Wrap<Topo::Type::VERTEX>> verts(30);
+  for (auto& v : verts)
+    v.make<Topo::EE<Topo::Type::VERTEX>>();
+  Topo::Wrap<Topo::Type::FACE> face;
+  face.make<Topo::EE<Topo::Type::FACE>>();
+  std::vector<Topo::IBase*> children;
+  auto check = [&face, &children, &verts]()
+  {
+    REQUIRE(face->size(Topo::Direction::Down) == children.size());
+    for (size_t i = 0; i < children.size(); ++i)
+      REQUIRE(face->get(Topo::Direction::Down, i) == children[i]);
+    for (const auto& v : verts)
+    {
+      auto it = std::find(children.rbegin(), children.rend(), v.get());
+      const size_t pos = it == children.rend() ? SIZE_MAX : children.rend() - it - 1;
+      REQUIRE(face->find_child(v.get()) == pos);
+      const bool has_parent = std::find(children.begin(), children.end(), v.get()) != children.end();
+      REQUIRE((v->find_parent(face.get()) == 0) == has_parent);
+    }
+  };
+  // Insertions at the end and in the middle, with repeated vertices.
+  for (size_t i = 0; i < 40; ++i)
+  {
+    const auto pos = (i * 7) % (children.size() + 1);
+    face->insert_child(verts[i % verts.size()].get(), pos);
+    children.insert(children.begin() + pos, verts[i % verts.size()].get());
+    check();
+  }
+  face->replace_child(verts[3].get(), verts[29].get());
+  std::replace(children.begin(), children.end(), verts[3].get(), verts[29].get());
+  check();
+  while (!children.empty())
+  {
+    const auto pos = (children.size() * 5 / 3) % children.size();
+    face->remove_child(pos);
+    children.erase(children.begin() + pos);
+    check();
+  }
+
+  // Replacement of a vertex with many faces.
+  Topo::Wrap<Topo::Type::VERTEX> other;
+  other.make<Topo::EE<Topo::Type::VERTEX>>();
+  std::vector<Topo::Wrap<Topo::Type::FACE>> faces(100);
+  for (auto& f : faces)
+  {
+    f.make<Topo::EE<Topo::Type::FACE>>();
+    f->insert_child(verts[0].get());
+    f->insert_child(verts[1].get());
+  }
+  REQUIRE(verts[0]->size(Topo::Direction::Up) == faces.size());
+  verts[0]->replace(other.get());
+  REQUIRE(verts[0]->size(Topo::Direction::Up) == 0);
+  REQUIRE(other->size(Topo::Direction::Up) == faces.size());
+  for (size_t i = 0; i < faces.size(); ++i)
+  {
+    REQUIRE(faces[i]->find_child(other.get()) == 0);
+    REQUIRE(other->find_parent(faces[i].get()) == i);
+  }
+}
+
+// The body keeps its edges while faces are added and removed.
+TEST_CASE("body_edges", "[Topo]")
+{
+  auto body = make_cube(cube_00);
+  Topo::Iterator<Topo::Type::BODY, Topo::Type::EDGE> be(body);
+  REQUIRE(be.size() == 12);
+  Topo::Iterator<Topo::Type::BODY, Topo::Type::EDGE> be_again(body);
+  REQUIRE(std::equal(be.begin(), be.end(), be_again.begin(),
+    [](const Topo::Wrap<Topo::Type::EDGE>& _a, const Topo::Wrap<Topo::Type::EDGE>& _b)
+  { return _a.get() == _b.get(); }));
+
+  // Edges from vertices are the ones of the body.
+  Topo::Iterator<Topo::Type::BODY, Topo::Type::VERTEX> bv(body);
+  Topo::Iterator<Topo::Type::VERTEX, Topo::Type::EDGE> ve(bv.get(0));
+  REQUIRE(ve.size() == 3);
+  for (const auto& edge : ve)
+    REQUIRE(std::find_if(be.begin(), be.end(),
+      [&edge](const Topo::Wrap<Topo::Type::EDGE>& _e) { return _e.get() == edge.get(); }) != be.end());
+
+  // Removing a face keeps its edges, they are still used by other faces.
+  Topo::Iterator<Topo::Type::BODY, Topo::Type::FACE> bf(body);
+  auto face = bf.get(0);
+  body->remove_child(face.get());
+  be.reset(body);
+  REQUIRE(be.size() == 12);
+  body->insert_child(face.get());
+  be.reset(body);
+  REQUIRE(be.size() == 12);
+
+  // A new triangle on three vertices of a face.
+  Topo::Iterator<Topo::Type::FACE, Topo::Type::VERTEX> fv(face);
+  Topo::Wrap<Topo::Type::FACE> tri;
+  tri.make<Topo::EE<Topo::Type::FACE>>();
+  for (size_t i = 0; i < 3; ++i)
+    tri->insert_child(fv.get(i).get());
+  body->insert_child(tri.get());
+  be.reset(body);
+  REQUIRE(be.size() == 13);
+  // Changing the vertices of a face of the body.
+  tri->remove_child(size_t(2));
+  be.reset(body);
+  REQUIRE(be.size() == 12);
+  body->remove_child(tri.get());
+  tri->insert_child(fv.get(2).get());
+  be.reset(body);
+  REQUIRE(be.size() == 12);
+}
+
+TEST_CASE("body_generation", "[Topo]")
+{
+  // A grid of quads, more faces than a chunk of the parallel traversal.
+  // Faces in reverse order, so vertices are not in creation order.
+  const size_t N = 200;
+  auto body = make_quad_grid(N, true);
+  Topo::Iterator<Topo::Type::BODY, Topo::Type::VERTEX> bv(body);
+  REQUIRE(bv.size() == (N + 1) * (N + 1));
+  size_t i = 0;
+  for (auto vert : Topo::unique_view<Topo::Type::VERTEX>(body))
+    REQUIRE(bv.get(i++).get() == vert);
+
+  // Only topological changes make a new generation.
+  auto body_data = static_cast<const Topo::EE<Topo::Type::BODY>*>(body.get());
+  auto gen = body_data->generation();
+  bv.get(0)->set_geom(Geo::Point{ -1, -1, 0 });
+  REQUIRE(body_data->generation() == gen);
+  Topo::Iterator<Topo::Type::BODY, Topo::Type::FACE> bf(body);
+  bf.get(0)->remove_child(size_t(0));
+  REQUIRE(body_data->generation() != gen);
+  gen = body_data->generation();
+  body->remove_child(bf.get(1).get());
+  REQUIRE(body_data->generation() != gen);
+}
+
+namespace {
+
+template <Topo::Type FromT, Topo::Type ToT>
+void check_view(const Topo::Wrap<FromT>& _from)
+{
+  Topo::Iterator<FromT, ToT> it(_from);
+  std::vector<Topo::E<ToT>*> from_view;
+  if (ToT == Topo::Type::VERTEX && FromT == Topo::Type::BODY)
+  {
+    for (auto el : Topo::unique_view<ToT>(_from))
+      from_view.push_back(el);
+  }
+  else
+  {
+    for (auto el : Topo::view<ToT>(_from))
+      from_view.push_back(el);
+  }
+  REQUIRE(from_view.size() == it.size());
+  for (size_t i = 0; i < it.size(); ++i)
+    REQUIRE(from_view[i] == it.get(i).get());
+}
+
+}//namespace
+
+// Views see the elements of the iterators in the same order.
+TEST_CASE("topo_view", "[Topo]")
+{
+  auto body = make_cube(cube_00);
+  // A face with loops.
+  Topo::Iterator<Topo::Type::BODY, Topo::Type::VERTEX> bv(body);
+  Topo::Wrap<Topo::Type::FACE> face;
+  face.make<Topo::EE<Topo::Type::FACE>>();
+  body->insert_child(face.get());
+  for (size_t i = 0; i < 2; ++i)
+  {
+    Topo::Wrap<Topo::Type::LOOP> loop;
+    loop.make<Topo::EE<Topo::Type::LOOP>>();
+    face->insert_child(loop.get());
+    for (size_t j = 0; j < 3; ++j)
+      loop->insert_child(bv.get(i * 3 + j).get());
+  }
+  check_view<Topo::Type::BODY, Topo::Type::FACE>(body);
+  check_view<Topo::Type::BODY, Topo::Type::VERTEX>(body);
+  check_view<Topo::Type::FACE, Topo::Type::VERTEX>(face);
+  Topo::Iterator<Topo::Type::BODY, Topo::Type::FACE> bf(body);
+  check_view<Topo::Type::FACE, Topo::Type::VERTEX>(bf.get(0));
+  check_view<Topo::Type::VERTEX, Topo::Type::FACE>(bv.get(0));
+  REQUIRE(Topo::view<Topo::Type::VERTEX>(face).size() == 6);
+  // Only the stored loops, Iterator makes one for each face without them.
+  REQUIRE(Topo::view<Topo::Type::LOOP>(body).size() == 2);
+
+  const auto alloc_start = allocation_count();
+  size_t nmbr = 0;
+  for (auto f : Topo::view<Topo::Type::FACE>(body))
+    for (auto v : Topo::view<Topo::Type::VERTEX>(Topo::Wrap<Topo::Type::FACE>(f)))
+      nmbr += v != nullptr;
+  REQUIRE(allocation_count() == alloc_start);
+  REQUIRE(nmbr == 30);
+}
+
+// End to end time of the Boolean pipeline on the spheres union.
+TEST_CASE("spheres_bench", "[.][BENCH]")
+{
+  auto b0 = IO::load_obj(MESH_FOLDER"sphere0.obj");
+  auto b1 = IO::load_obj(MESH_FOLDER"sphere1.obj");
+  auto start = std::chrono::steady_clock::now();
+  auto bool_solver = Boolean::ISolver::make();
+  bool_solver->init(b0, b1);
+  b0 = bool_solver->compute(Boolean::Operation::UNION);
+  std::chrono::duration<double> dur = std::chrono::steady_clock::now() - start;
+  Topo::Iterator<Topo::Type::BODY, Topo::Type::FACE> bf_it(b0);
+  std::cout << "spheres union: " << bf_it.size() << " faces in "
+    << dur.count() << "s" << std::endl;
+  REQUIRE(bf_it.size() == 14916);
+}
+
+TEST_CASE("merge_classes", "[Topo]")
+{
+  auto body = make_cube(cube_00);
+  Topo::Iterator<Topo::Type::BODY, Topo::Type::VERTEX> bv(body);
+  std::vector<Topo::Wrap<Topo::Type::VERTEX>> verts;
+  for (auto vert : bv)
+    verts.push_back(vert);
+  REQUIRE(verts.size() == 8);
+  auto index = [&verts](const Topo::Wrap<Topo::Type::VERTEX>& _vert)
+  {
+    size_t i = 0;
+    while (verts[i].get() != _vert.get())
+      ++i;
+    return i;
+  };
+  Topo::Iterator<Topo::Type::BODY, Topo::Type::FACE> bf(body);
+  Topo::Iterator<Topo::Type::FACE, Topo::Type::VERTEX> fv(bf.get(0));
+  std::vector<size_t> face_inds;
+  for (auto vert : fv)
+    face_inds.push_back(index(vert));
+  REQUIRE(face_inds.size() == 4);
+  // Three vertices of a face and two of the other ones.
+  std::vector<size_t> other_inds;
+  for (size_t i = 0; i < verts.size(); ++i)
+  {
+    if (std::find(face_inds.begin(), face_inds.end(), i) == face_inds.end())
+      other_inds.push_back(i);
+  }
+  verts[face_inds[2]]->set_tolerance(0.01);
+  Utils::UnionFind classes(verts.size());
+  classes.unite(face_inds[0], face_inds[1]);
+  classes.unite(face_inds[2], face_inds[1]);
+  classes.unite(other_inds[0], other_inds[1]);
+  Geo::Point pts[3], centr = {};
+  for (size_t i = 0; i < 3; ++i)
+  {
+    verts[face_inds[i]]->geom(pts[i]);
+    centr += pts[i] / 3.;
+  }
+  REQUIRE(Topo::merge(verts, classes) == 3);
+
+  Topo::Iterator<Topo::Type::BODY, Topo::Type::VERTEX> bv_after(body);
+  REQUIRE(bv_after.size() == 5);
+  auto repr = verts[classes.find(face_inds[0])];
+  Geo::Point pt;
+  repr->geom(pt);
+  REQUIRE(Geo::length(pt - centr) < 1e-12);
+  REQUIRE(repr->tolerance() == 0.01);
+  // The face has the representative in place of three vertices.
+  Topo::Iterator<Topo::Type::FACE, Topo::Type::VERTEX> fv_after(bf.get(0));
+  size_t repr_nmbr = 0;
+  for (auto vert : fv_after)
+    repr_nmbr += vert.get() == repr.get();
+  REQUIRE(repr_nmbr == 3);
+}
+
+TEST_CASE("merge_chain_centroid", "[Topo]")
+{
+  // A face with a chain of two short edges, as remove_degenerate_edges
+  // finds it. The class merge moves the chain to its centroid, merging
+  // the edges one by one moves it towards the last vertex.
+  const Geo::Point pts[] = {
+    { 0, 0, 0 }, { 0.003, 0, 0 }, { 0.009, 0, 0 }, { 1, 0, 0 }, { 1, 1, 0 }, { 0, 1, 0 } };
+  Topo::Wrap<Topo::Type::BODY> bodies[2];
+  std::vector<Topo::Wrap<Topo::Type::VERTEX>> verts[2];
+  for (size_t k = 0; k < 2; ++k)
+  {
+    bodies[k].make<Topo::EE<Topo::Type::BODY>>();
+    Topo::Wrap<Topo::Type::FACE> face;
+    face.make<Topo::EE<Topo::Type::FACE>>();
+    for (const auto& pt : pts)
+    {
+      verts[k].emplace_back();
+      verts[k].back().make<Topo::EE<Topo::Type::VERTEX>>();
+      verts[k].back()->set_geom(pt);
+      face->insert_child(verts[k].back().get());
+    }
+    bodies[k]->insert_child(face.get());
+  }
+  Utils::UnionFind classes(verts[0].size());
+  classes.unite(1, 0);
+  classes.unite(2, 1);
+  REQUIRE(Topo::merge(verts[0], classes) == 2);
+  REQUIRE(Topo::merge(verts[1][0], verts[1][1]));
+  REQUIRE(Topo::merge(verts[1][1], verts[1][2]));
+
+  Geo::Point pt;
+  verts[0][classes.find(0)]->geom(pt);
+  REQUIRE(Geo::length(pt - Geo::Point{ 0.004, 0, 0 }) < 1e-12);
+  verts[1][2]->geom(pt);
+  REQUIRE(Geo::length(pt - Geo::Point{ 0.00525, 0, 0 }) < 1e-12);
+  for (const auto& body : bodies)
+  {
+    Topo::Iterator<Topo::Type::BODY, Topo::Type::VERTEX> bv(body);
+    REQUIRE(bv.size() == 4);
+  }
+}
+
+TEST_CASE("split_edges", "[Topo]")
+{
+  // Two grids of quads, all the edges split in the middle and at a third
+  // of the ones along x. The splits are applied one by one in the first
+  // grid and by split_edges in the second one.
+  const size_t N = 40;
+  Topo::Wrap<Topo::Type::BODY> bodies[2] = { make_quad_grid(N), make_quad_grid(N) };
+  for (auto& body : bodies)
+  {
+    std::set<Topo::Split<Topo::Type::EDGE>> splits;
+    Topo::Iterator<Topo::Type::BODY, Topo::Type::EDGE> be(body);
+    for (auto edge : be)
+    {
+      Geo::Segment seg;
+      edge->geom(seg);
+      auto it = splits.emplace(edge).first;
+      for (double t : { 0.5, 1. / 3 })
+      {
+        Topo::Split<Topo::Type::EDGE>::Info info;
+        info.vert_.make<Topo::EE<Topo::Type::VERTEX>>();
+        info.vert_->set_geom(seg[0] + t * (seg[1] - seg[0]));
+        info.t_ = t;
+        it->add_point(info);
+        if (seg[0][1] != seg[1][1])
+          break;
+      }
+    }
+    if (&body == &bodies[0])
+    {
+      for (const auto& splt : splits)
+        splt();
+    }
+    else
+      REQUIRE(Topo::split_edges(splits));
+  }
+  Topo::Iterator<Topo::Type::BODY, Topo::Type::FACE> bf[2] = { bodies[0], bodies[1] };
+  REQUIRE(bf[0].size() == N * N);
+  REQUIRE(bf[1].size() == N * N);
+  for (size_t i = 0; i < bf[0].size(); ++i)
+  {
+    Topo::Iterator<Topo::Type::FACE, Topo::Type::VERTEX> fv[2] = {
+      bf[0].get(i), bf[1].get(i) };
+    REQUIRE(fv[0].size() == fv[1].size());
+    for (size_t j = 0; j < fv[0].size(); ++j)
+    {
+      Geo::Point pts[2];
+      fv[0].get(j)->geom(pts[0]);
+      fv[1].get(j)->geom(pts[1]);
+      REQUIRE(pts[0] == pts[1]);
+    }
+  }
+}
@@ -4,6 +4,7 @@
 #include <Geo/vector.hh>
 
 #include <iostream>
+#include <vector>
 
 namespace UnitTest
 {
@@ -84,6 +85,29 @@ Topo::Wrap<Topo::Type::BODY> make_cube(IndexToPoint idx_to_pt)
   return body;
 }
 
+Topo::Wrap<Topo::Type::BODY> make_quad_grid(size_t _n, bool _reverse)
+{
+  Topo::Wrap<Topo::Type::BODY> body;
+  body.make<Topo::EE<Topo::Type::BODY>>();
+  std::vector<Topo::Wrap<Topo::Type::VERTEX>> verts((_n + 1) * (_n + 1));
+  for (size_t i = 0; i < verts.size(); ++i)
+  {
+    verts[i].make<Topo::EE<Topo::Type::VERTEX>>();
+    verts[i]->set_geom(Geo::Point{ double(i % (_n + 1)), double(i / (_n + 1)), 0 });
+  }
+  for (size_t k = 0; k < _n * _n; ++k)
+  {
+    const auto ind = _reverse ? _n * _n - 1 - k : k;
+    Topo::Wrap<Topo::Type::FACE> face;
+    face.make<Topo::EE<Topo::Type::FACE>>();
+    const size_t v0 = (ind / _n) * (_n + 1) + ind % _n;
+    for (auto v : { v0, v0 + 1, v0 + _n + 2, v0 + _n + 1 })
+      face->insert_child(verts[v].get());
+    body->insert_child(face.get());
+  }
+  return body;
+}
+
 void print_body(Topo::Wrap<Topo::Type::BODY> _body)
 {
   Topo::Iterator<Topo::Type::BODY, Topo::Type::FACE> bf;
@@ -19,6 +19,10 @@ double cube_04(size_t i, size_t _i_xyz); // Unit cube in (-0.5, 0.5), (-0.5, 0.5
 
 Topo::Wrap<Topo::Type::BODY> make_cube(IndexToPoint idx_to_pt);
 
+// Grid of _n x _n unit quads in the plane z = 0. Faces are inserted
+// row by row, or from the last one if _reverse.
+Topo::Wrap<Topo::Type::BODY> make_quad_grid(size_t _n, bool _reverse = false);
+
 void print_body(Topo::Wrap<Topo::Type::BODY> _body);
 
 typedef std::function<double(size_t, size_t)> IndexToPoint;
@@ -1,7 +1,11 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <functional>
+#include <limits>
 #include <memory>
+#include <numeric>
 #include <vector>
 
 namespace Utils {
@@ -65,6 +69,157 @@ struct ContainementTree
     (*ins_el).reset(new_node);
   }
 
+  // Box of an element on two coordinates. An element contains only
+  // elements with a box inside its box.
+  struct Box
+  {
+    std::array<double, 2> min_, max_;
+    // True if _oth is inside this box enlarged by _tol.
+    bool contains(const Box& _oth, double _tol = 0) const
+    {
+      return min_[0] - _tol <= _oth.min_[0] && min_[1] - _tol <= _oth.min_[1] &&
+        max_[0] + _tol >= _oth.max_[0] && max_[1] + _tol >= _oth.max_[1];
+    }
+    double area() const { return (max_[0] - min_[0]) * (max_[1] - min_[1]); }
+  };
+  using BoxFunc = std::function<Box(const ElemT&)>;
+  // True if the first element is inside the second one.
+  using InsideFunc = std::function<bool(const ElemT&, const ElemT&)>;
+
+  /*! Adds all the elements of a nested set at once. The elements are swept
+      in order of their box minimum on the first coordinate. The boxes met
+      by the sweep are kept in a segment tree on the second coordinate, so
+      the boxes that can contain an element are found in logarithmic time.
+      An element is compared only with the bigger elements whose box,
+      enlarged by _tol, contains its box, from the smallest one, until the
+      first one containing it. Children and relatives are in the order of
+      _elems. If given, _inside replaces the comparison, the containers
+      are only asked if they contain the element.
+  */
+  void add(const std::vector<ElemT>& _elems, const BoxFunc& _box_func,
+           double _tol = 0, const InsideFunc& _inside = nullptr)
+  {
+    if (root_)
+    {
+      for (const auto& elem : _elems)
+        add(elem);
+      return;
+    }
+    std::vector<Box> boxes;
+    boxes.reserve(_elems.size());
+    for (const auto& elem : _elems)
+      boxes.push_back(_box_func(elem));
+    std::vector<size_t> order(_elems.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&boxes](size_t _a, size_t _b)
+    {
+      if (boxes[_a].min_[0] != boxes[_b].min_[0])
+        return boxes[_a].min_[0] < boxes[_b].min_[0];
+      if (boxes[_a].area() != boxes[_b].area())
+        return boxes[_a].area() > boxes[_b].area();
+      return _a < _b;
+    });
+    // Strict order where a container comes before its content.
+    std::vector<size_t> rank(_elems.size());
+    for (size_t i = 0; i < order.size(); ++i)
+      rank[order[i]] = i;
+    auto bigger = [&boxes, &rank](size_t _a, size_t _b)
+    {
+      return boxes[_a].area() > boxes[_b].area() ||
+        (boxes[_a].area() == boxes[_b].area() && rank[_a] < rank[_b]);
+    };
+
+    // Leaves are the box minimums on the second coordinate. A box is in
+    // the nodes covering the leaves inside it, an element finds the boxes
+    // containing its minimum in the nodes above its leaf.
+    std::vector<double> ys(_elems.size());
+    for (size_t i = 0; i < ys.size(); ++i)
+      ys[i] = boxes[i].min_[1];
+    std::sort(ys.begin(), ys.end());
+    ys.erase(std::unique(ys.begin(), ys.end()), ys.end());
+    const auto leaf_nmbr = ys.size();
+    std::vector<std::vector<size_t>> tree(2 * leaf_nmbr);
+    auto insert = [&boxes, &ys, &tree, leaf_nmbr, _tol](size_t _i)
+    {
+      auto l = std::lower_bound(ys.begin(), ys.end(), boxes[_i].min_[1] - _tol) -
+        ys.begin() + leaf_nmbr;
+      auto r = std::upper_bound(ys.begin(), ys.end(), boxes[_i].max_[1] + _tol) -
+        ys.begin() + leaf_nmbr;
+      for (; l < r; l /= 2, r /= 2)
+      {
+        if (l & 1)
+          tree[l++].push_back(_i);
+        if (r & 1)
+          tree[--r].push_back(_i);
+      }
+    };
+
+    const auto NO_PARENT = std::numeric_limits<size_t>::max();
+    std::vector<size_t> parents(_elems.size(), NO_PARENT);
+    std::vector<size_t> candidates;
+    size_t inserted = 0;
+    for (auto i : order)
+    {
+      const auto& box = boxes[i];
+      // Boxes starting just after this one can contain it within _tol.
+      for (; inserted < order.size() &&
+             boxes[order[inserted]].min_[0] <= box.min_[0] + _tol; ++inserted)
+      {
+        insert(order[inserted]);
+      }
+      candidates.clear();
+      auto node = std::lower_bound(ys.begin(), ys.end(), box.min_[1]) -
+        ys.begin() + leaf_nmbr;
+      for (; node > 0; node /= 2)
+      {
+        auto& elems = tree[node];
+        for (size_t k = 0; k < elems.size();)
+        {
+          const auto j = elems[k];
+          // Elements ending before this box do not contain the next ones.
+          if (boxes[j].max_[0] + _tol < box.min_[0])
+          {
+            elems[k] = elems.back();
+            elems.pop_back();
+            continue;
+          }
+          if (bigger(j, i) && boxes[j].contains(box, _tol))
+            candidates.push_back(j);
+          ++k;
+        }
+      }
+      std::sort(candidates.begin(), candidates.end(), [&boxes](size_t _a, size_t _b)
+      {
+        return boxes[_a].area() < boxes[_b].area() ||
+          (boxes[_a].area() == boxes[_b].area() && _a > _b);
+      });
+      for (auto j : candidates)
+      {
+        if (_inside ? _inside(_elems[i], _elems[j]) :
+                      cmp_func_(_elems[i], _elems[j]) < 0)
+        {
+          parents[i] = j;
+          break;
+        }
+      }
+    }
+    std::vector<std::unique_ptr<Element>> nodes(_elems.size());
+    std::vector<std::unique_ptr<Element>*> child_ends(_elems.size());
+    for (size_t i = 0; i < _elems.size(); ++i)
+    {
+      nodes[i].reset(new Element(_elems[i]));
+      child_ends[i] = &nodes[i]->child_;
+    }
+    auto root_end = &root_;
+    for (size_t i = 0; i < _elems.size(); ++i)
+    {
+      auto& end = parents[i] == NO_PARENT ? root_end : child_ends[parents[i]];
+      auto next_end = &nodes[i]->next_;
+      *end = std::move(nodes[i]);
+      end = next_end;
+    }
+  }
+
 private:
   std::unique_ptr<Element> root_;
   CompareFunc cmp_func_;
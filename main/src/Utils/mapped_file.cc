@@ -0,0 +1,77 @@
+#include "mapped_file.hh"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Utils {
+
+// The view keeps the file open, the handles are closed at once.
+#ifdef _WIN32
+
+bool MappedFile::open(const char* _flnm)
+{
+  close();
+  auto file = CreateFileA(_flnm, GENERIC_READ, FILE_SHARE_READ, nullptr,
+    OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    return false;
+  LARGE_INTEGER size;
+  HANDLE mapping = nullptr;
+  if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  CloseHandle(file);
+  if (mapping == nullptr)
+    return false;
+  data_ = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+  CloseHandle(mapping);
+  if (data_ == nullptr)
+    return false;
+  size_ = size_t(size.QuadPart);
+  return true;
+}
+
+void MappedFile::close()
+{
+  if (data_ != nullptr)
+    UnmapViewOfFile(data_);
+  data_ = nullptr;
+  size_ = 0;
+}
+
+#else
+
+bool MappedFile::open(const char* _flnm)
+{
+  close();
+  const int fd = ::open(_flnm, O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat st;
+  void* addr = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && st.st_size > 0)
+    addr = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (addr == MAP_FAILED)
+    return false;
+  data_ = static_cast<const char*>(addr);
+  size_ = size_t(st.st_size);
+  return true;
+}
+
+void MappedFile::close()
+{
+  if (data_ != nullptr)
+    munmap(const_cast<char*>(data_), size_);
+  data_ = nullptr;
+  size_ = 0;
+}
+
+#endif
+
+}//namespace Utils
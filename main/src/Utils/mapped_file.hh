@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+
+namespace Utils {
+
+/*! Read only memory map of a whole file. The system reads the pages on
+    first access, so opening even a very big file costs nothing and
+    only the parts that are used are loaded.
+*/
+class MappedFile
+{
+public:
+  MappedFile() {}
+  ~MappedFile() { close(); }
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  // False if the file cannot be opened or it is empty.
+  bool open(const char* _flnm);
+  void close();
+
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+
+private:
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+};
+
+}//namespace Utils
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <algorithm>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace Utils {
+
+/*! Calls _func(i) for all i in [0, _size[. The range is split in
+    contiguous chunks of at least _min_chunk elements, one per hardware
+    thread; the calling thread runs the first one. An exception thrown
+    by _func is rethrown in the calling thread.
+*/
+template <class FuncT>
+void parallel_for(size_t _size, const FuncT& _func, size_t _min_chunk = 64)
+{
+  size_t thread_nmbr = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  thread_nmbr = std::min(thread_nmbr, (_size + _min_chunk - 1) / _min_chunk);
+  if (thread_nmbr <= 1)
+  {
+    for (size_t i = 0; i < _size; ++i)
+      _func(i);
+    return;
+  }
+  const size_t chunk = (_size + thread_nmbr - 1) / thread_nmbr;
+  std::vector<std::exception_ptr> errors(thread_nmbr);
+  auto run_chunk = [&_func, &errors, chunk, _size](size_t _thrd)
+  {
+    try
+    {
+      const auto end = std::min(_size, (_thrd + 1) * chunk);
+      for (size_t i = _thrd * chunk; i < end; ++i)
+        _func(i);
+    }
+    catch (...)
+    {
+      errors[_thrd] = std::current_exception();
+    }
+  };
+  std::vector<std::thread> threads;
+  threads.reserve(thread_nmbr - 1);
+  for (size_t thrd = 1; thrd < thread_nmbr; ++thrd)
+    threads.emplace_back(run_chunk, thrd);
+  run_chunk(0);
+  for (auto& thrd : threads)
+    thrd.join();
+  for (const auto& err : errors)
+  {
+    if (err)
+      std::rethrow_exception(err);
+  }
+}
+
+}//namespace Utils
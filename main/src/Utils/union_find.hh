@@ -0,0 +1,61 @@
+#pragma once
+
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace Utils {
+
+/*! Disjoint sets of the indices [0, size()). Union by size and path
+    halving make every operation almost constant time.
+*/
+class UnionFind
+{
+public:
+  explicit UnionFind(size_t _size = 0) { grow(_size); }
+
+  // Adds single element sets up to _size.
+  void grow(size_t _size)
+  {
+    const auto old_size = parent_.size();
+    if (_size <= old_size)
+      return;
+    parent_.resize(_size);
+    std::iota(parent_.begin() + old_size, parent_.end(), old_size);
+    size_.resize(_size, 1);
+  }
+
+  size_t size() const { return parent_.size(); }
+
+  // Representative of the set of _i.
+  size_t find(size_t _i)
+  {
+    while (parent_[_i] != _i)
+    {
+      parent_[_i] = parent_[parent_[_i]];
+      _i = parent_[_i];
+    }
+    return _i;
+  }
+
+  // Joins the sets of _a and _b, false if they are the same. With sets
+  // of the same size the representative of _a is kept.
+  bool unite(size_t _a, size_t _b)
+  {
+    _a = find(_a);
+    _b = find(_b);
+    if (_a == _b)
+      return false;
+    if (size_[_a] < size_[_b])
+      std::swap(_a, _b);
+    parent_[_b] = _a;
+    size_[_a] += size_[_b];
+    return true;
+  }
+
+private:
+  std::vector<size_t> parent_;
+  std::vector<size_t> size_;
+};
+
+}//namespace Utils